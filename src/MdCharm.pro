@@ -4,6 +4,7 @@ CONFIG += ordered
 
 SUBDIRS += lib
 SUBDIRS += MdCharm
+SUBDIRS += mdrender
 
 TRANSLATIONS =  lang_en.ts \
                 lang_zh.ts \
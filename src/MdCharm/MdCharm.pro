@@ -98,6 +98,7 @@ SOURCES += \
     util/gui/statusbarlabel.cpp \
     util/gui/gotodialog.cpp \
     util/spellcheck/spellchecker.cpp \
+    util/spellcheck/spellcheckerloader.cpp \
     baseeditor/markdowneditor.cpp \
     util/gui/exportdialog.cpp \
     util/sessionfileparser.cpp \
@@ -120,7 +121,8 @@ SOURCES += \
     util/gui/exportdirectorydialog.cpp \
     util/gui/shortcutlineedit.cpp \
     dock/tocdockwidget.cpp \
-    util/updatetocthread.cpp
+    util/previewrenderthread.cpp \
+    util/documentutf8mirror.cpp
 
 
 HEADERS += \
@@ -148,6 +150,7 @@ HEADERS += \
     util/gui/statusbarlabel.h \
     util/gui/gotodialog.h \
     util/spellcheck/spellchecker.h \
+    util/spellcheck/spellcheckerloader.h \
     baseeditor/markdowneditor.h \
     util/gui/exportdialog.h \
     util/sessionfileparser.h \
@@ -170,7 +173,8 @@ HEADERS += \
     util/gui/exportdirectorydialog.h \
     util/gui/shortcutlineedit.h \
     dock/tocdockwidget.h \
-    util/updatetocthread.h
+    util/previewrenderthread.h \
+    util/documentutf8mirror.h
 
 
 FORMS += \
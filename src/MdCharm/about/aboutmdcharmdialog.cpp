@@ -1,6 +1,20 @@
 #include "aboutmdcharmdialog.h"
 #include "ui_aboutdialog.h"
 #include "version.h"
+#include "rendercache.h"
+#include "codesyntaxhighlighter.h"
+#include "timingprofiler.h"
+#include "configuration.h"
+#include "utils.h"
+
+#include <QCheckBox>
+#include <QFile>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QVBoxLayout>
 
 AboutMdCharmDialog::AboutMdCharmDialog(QWidget *parent) :
     QDialog(parent, Qt::WindowTitleHint|Qt::WindowSystemMenuHint),
@@ -23,6 +37,8 @@ AboutMdCharmDialog::AboutMdCharmDialog(QWidget *parent) :
                             .arg(QString::fromLatin1(VERSION_STR))
                             .arg(QString::fromLatin1(REVISION_STR).left(10)));
 
+    initDiagnosticsTab();
+
     QObject::connect(closePushButton, SIGNAL(clicked()),
                      this, SLOT(close()));
 }
@@ -31,3 +47,116 @@ AboutMdCharmDialog::~AboutMdCharmDialog()
 {
     delete ui;
 }
+
+void AboutMdCharmDialog::initDiagnosticsTab()
+{
+    RenderCache::Statistics cache = RenderCache::instance()->getStatistics();
+    unsigned long long lookups = cache.hits+cache.misses;
+    QWidget *diagnosticsTab = new QWidget;
+    QVBoxLayout *layout = new QVBoxLayout(diagnosticsTab);
+    QLabel *cacheLabel = new QLabel(diagnosticsTab);
+    cacheLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    cacheLabel->setText(tr("<h4>Render cache</h4>"
+                           "Hits: %1 (%2%)<br/>"
+                           "Misses: %3<br/>"
+                           "Evictions: %4<br/>"
+                           "Documents: %5<br/>"
+                           "Memory: %6 KB of %7 KB")
+                        .arg(cache.hits)
+                        .arg(lookups ? cache.hits*100/lookups : 0)
+                        .arg(cache.misses)
+                        .arg(cache.evictions)
+                        .arg(cache.entries)
+                        .arg(cache.bytes/1024)
+                        .arg(cache.budget/1024));
+    layout->addWidget(cacheLabel);
+
+    LanguageManager *languageManager = LanguageManager::getInstance();
+    QLabel *highlighterLabel = new QLabel(diagnosticsTab);
+    highlighterLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    highlighterLabel->setText(tr("<h4>Code highlighter</h4>"
+                                 "JIT compiled patterns: %1 of %2")
+                              .arg(languageManager->getJitPatternCount())
+                              .arg(languageManager->getPatternCount()));
+    layout->addWidget(highlighterLabel);
+
+    layout->addWidget(new QLabel(tr("<h4>Timings</h4>"), diagnosticsTab));
+    timingsTextEdit = new QPlainTextEdit(diagnosticsTab);
+    timingsTextEdit->setReadOnly(true);
+    timingsTextEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
+    QFont font(QString::fromLatin1("Courier"));
+    font.setStyleHint(QFont::TypeWriter);
+    timingsTextEdit->setFont(font);
+    layout->addWidget(timingsTextEdit);
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    QCheckBox *recordCheckBox = new QCheckBox(tr("Record timings"), diagnosticsTab);
+    recordCheckBox->setChecked(TimingProfiler::isEnabled());
+    buttonLayout->addWidget(recordCheckBox);
+    buttonLayout->addStretch();
+    QPushButton *refreshButton = new QPushButton(tr("Refresh"), diagnosticsTab);
+    QPushButton *resetButton = new QPushButton(tr("Reset"), diagnosticsTab);
+    QPushButton *saveTraceButton = new QPushButton(tr("Save Trace..."), diagnosticsTab);
+    buttonLayout->addWidget(refreshButton);
+    buttonLayout->addWidget(resetButton);
+    buttonLayout->addWidget(saveTraceButton);
+    layout->addLayout(buttonLayout);
+    ui->infoTabWidget->addTab(diagnosticsTab, tr("Diagnostics"));
+
+    connect(recordCheckBox, SIGNAL(toggled(bool)), this, SLOT(recordTimingsToggled(bool)));
+    connect(refreshButton, SIGNAL(clicked()), this, SLOT(updateTimings()));
+    connect(resetButton, SIGNAL(clicked()), this, SLOT(resetTimings()));
+    connect(saveTraceButton, SIGNAL(clicked()), this, SLOT(saveChromeTrace()));
+    updateTimings();
+}
+
+void AboutMdCharmDialog::updateTimings()
+{
+    std::vector<TimingProfiler::Stage> stages = TimingProfiler::instance()->getStages();
+    if(stages.empty()){
+        timingsTextEdit->setPlainText(TimingProfiler::isEnabled()
+                                      ? tr("Nothing has been timed yet.")
+                                      : tr("Check \"Record timings\" and edit a document."));
+        return;
+    }
+    QString text = QString::fromLatin1("%1 %2 %3 %4 %5 %6\n")
+            .arg(QString::fromLatin1("stage"), -26)
+            .arg(QString::fromLatin1("count"), 8)
+            .arg(QString::fromLatin1("mean ms"), 9)
+            .arg(QString::fromLatin1("p50 ms"), 9)
+            .arg(QString::fromLatin1("p99 ms"), 9)
+            .arg(QString::fromLatin1("max ms"), 9);
+    for(size_t i=0; i<stages.size(); i++){
+        const TimingProfiler::Stage &stage = stages[i];
+        text += QString::fromLatin1("%1 %2 %3 %4 %5 %6\n")
+                .arg(QString::fromStdString(stage.name), -26)
+                .arg(stage.count, 8)
+                .arg(stage.totalNs/1000000.0/stage.count, 9, 'f', 3)
+                .arg(stage.percentileMs(50), 9, 'f', 3)
+                .arg(stage.percentileMs(99), 9, 'f', 3)
+                .arg(stage.maxNs/1000000.0, 9, 'f', 3);
+    }
+    timingsTextEdit->setPlainText(text);
+}
+
+void AboutMdCharmDialog::recordTimingsToggled(bool checked)
+{
+    TimingProfiler::instance()->setEnabled(checked);
+    Configuration::getInstance()->setRecordTimings(checked);
+    updateTimings();
+}
+
+void AboutMdCharmDialog::resetTimings()
+{
+    TimingProfiler::instance()->reset();
+    updateTimings();
+}
+
+void AboutMdCharmDialog::saveChromeTrace()
+{
+    QString filePath = Utils::getSaveFileName(QString::fromLatin1(".json"), this, tr("Save Trace"),
+                                              QString(), tr("Chrome Trace (*.json)"));
+    if(filePath.isEmpty())
+        return;
+    if(!TimingProfiler::instance()->writeChromeTrace(QFile::encodeName(filePath).constData()))
+        QMessageBox::warning(this, tr("Save Trace"), tr("Cannot write %1.").arg(filePath));
+}
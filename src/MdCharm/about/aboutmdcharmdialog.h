@@ -5,6 +5,7 @@
 
 class QPlainTextEdit;
 class QLabel;
+class QPushButton;
 
 namespace Ui {
     class AboutMdCharmDialog;
@@ -17,10 +18,18 @@ class AboutMdCharmDialog : public QDialog
 public:
     AboutMdCharmDialog(QWidget *parent);
     ~AboutMdCharmDialog();
+private:
+    void initDiagnosticsTab();
+private slots:
+    void updateTimings();
+    void recordTimingsToggled(bool checked);
+    void resetTimings();
+    void saveChromeTrace();
 private:
     Ui::AboutMdCharmDialog *ui;
     QPushButton *closePushButton;
     QLabel *versionLabel;
+    QPlainTextEdit *timingsTextEdit;
 };
 
 #endif // ABOUTMDCHARMDIALOG_H
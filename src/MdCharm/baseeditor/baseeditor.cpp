@@ -9,6 +9,7 @@
 #include "util/spellcheck/spellchecker.h"
 #include "configuration.h"
 #include "utils.h"
+#include "timingprofiler.h"
 
 BaseEditor::BaseEditor(QWidget *parent) :
     QPlainTextEdit(parent)
@@ -25,6 +26,8 @@ BaseEditor::BaseEditor(QWidget *parent) :
 
     connect(this, SIGNAL(textChanged()),
             this, SLOT(ensureAtTheLast()));
+    connect(mdCharmGlobal, SIGNAL(spellCheckerReady(QString)),
+            this, SLOT(spellCheckerReady(QString)));
 }
 
 BaseEditor::~BaseEditor(){}
@@ -46,7 +49,8 @@ void BaseEditor::enableSpellCheck()
     updateExtraSelection();
     if(spellCheckLanguage.isEmpty())
         spellCheckLanguage=conf->getSpellCheckLanguage();
-    if(mdCharmGlobal->getSpellChecker(spellCheckLanguage)==NULL){
+    //the dictionary may still be loading, see spellCheckerReady()
+    if(!mdCharmGlobal->loadSpellCheck(spellCheckLanguage)){
         Q_ASSERT(0 && "This should not be happen");
         spellCheckLanguage.clear();
         return;
@@ -554,6 +558,7 @@ void BaseEditor::spellCheck(int start, int unused, int length)
     Q_UNUSED(unused)
     if(length==0)
         return;
+    PROFILE_SCOPE("editor.spellCheck");
 //    qDebug("start %d, length %d", start, length);;
     int end = start+length;
     bool isInSameBlock=false;
@@ -597,8 +602,18 @@ void BaseEditor::spellCheckAux(const QTextBlock &block)
     }
 }
 
+void BaseEditor::spellCheckerReady(const QString &lan)
+{
+    if(spellCheckLanguage.isEmpty() || lan!=spellCheckLanguage)
+        return;
+    checkWholeContent();
+}
+
 void BaseEditor::checkWholeContent()
 {
+    if(mdCharmGlobal->getSpellChecker(spellCheckLanguage)==NULL)
+        return;//not loaded yet
+    PROFILE_SCOPE("editor.spellCheckAll");
     for(int i=0; i<blockCount(); i++)
         spellCheckAux(document()->findBlockByNumber(i));
     updateExtraSelection();
@@ -47,6 +47,7 @@ private slots:
     void updateLineNumberArea(const QRect &, int);
     void ensureAtTheLast();
     void spellCheck(int start, int unused, int length);
+    void spellCheckerReady(const QString &lan);
 private:
     void initSpellCheckMatter();
     void updateExtraSelection();
@@ -1,4 +1,5 @@
 #include "markdownwebview.h"
+#include "timingprofiler.h"
 
 MarkdownWebView::MarkdownWebView(QWidget *parent) :
     BaseWebView(parent)
@@ -9,3 +10,11 @@ void MarkdownWebView::reload()
 {
     //Do Nothing
 }
+
+//WebKit lays the page out when it is painted after a change, so this is
+//where the layout time of an update shows up
+void MarkdownWebView::paintEvent(QPaintEvent *event)
+{
+    PROFILE_SCOPE("preview.layoutAndPaint");
+    BaseWebView::paintEvent(event);
+}
@@ -13,6 +13,8 @@ signals:
     
 public slots:
     void reload();
+protected:
+    void paintEvent(QPaintEvent *event);
 };
 
 #endif // MARKDOWNWEBVIEW_H
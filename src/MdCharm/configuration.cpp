@@ -56,6 +56,12 @@ const QString Configuration::AUTO_PAIR = QString::fromLatin1("TextEditor/AutoPai
 const QString Configuration::LAST_IGNORE_REVISION = QString::fromLatin1("Update/LastIgnoreRevision");
 const QString Configuration::RIGHT_MARGIN_COLUMN = QString::fromLatin1("TextEditor/RightMarginColumn");
 const QString Configuration::MARKDOWN_ENGINE = QString::fromLatin1("Common/MarkdownEngine");
+const QString Configuration::INCREMENTAL_PREVIEW = QString::fromLatin1("Behavior/IncrementalPreview");
+const QString Configuration::PREVIEW_DEBOUNCE_INTERVAL = QString::fromLatin1("Behavior/PreviewDebounceInterval");
+const QString Configuration::RENDER_CACHE_SIZE = QString::fromLatin1("Behavior/RenderCacheSize");
+const QString Configuration::RECORD_TIMINGS = QString::fromLatin1("Behavior/RecordTimings");
+const QString Configuration::MARKDOWN_HIGHLIGHTER = QString::fromLatin1("TextEditor/MarkdownHighlighter");
+const QString Configuration::LAZY_HIGHLIGHT = QString::fromLatin1("TextEditor/LazyHighlight");
 const QString Configuration::LAST_STATE_GROUP = QString::fromLatin1("LastState/");
 const QString Configuration::SHORTCUTS_GROUP = QString::fromLatin1("Shortcuts/");
 
@@ -503,6 +509,15 @@ QString Configuration::getLanguageSpellCheckUserDictPath()
     return QString("%1/%2/user.txt").arg(configFileDirPath()).arg(SPELL_CHECK_DIC_DIRECTORY_NAME);
 }
 
+QString Configuration::getLanguageSpellCheckCachePath(const QString &lan)
+{
+    //Compiled word table, kept in the user data path since the bundled
+    //dictionaries may not be writable
+    return QString("%1/%2/%3.cache").arg(configFileDirPath())
+            .arg(SPELL_CHECK_DIC_DIRECTORY_NAME)
+            .arg(lan);
+}
+
 const QStringList Configuration::getAllAvailableSpellCheckDictNames()
 {
     QStringList dicts;
@@ -829,6 +844,112 @@ MarkdownToHtml::MarkdownType Configuration::getMarkdownEngineType() const
     }
 }
 
+void Configuration::setIncrementalPreview(bool b)
+{
+    settings->setValue(INCREMENTAL_PREVIEW, b);
+}
+
+bool Configuration::isIncrementalPreview()
+{
+    QVariant var = settings->value(INCREMENTAL_PREVIEW);
+    if(var.isValid() && var.canConvert(QVariant::Bool)){
+        return var.toBool();
+    } else {
+        setIncrementalPreview(true);
+        return true;
+    }
+}
+
+void Configuration::setPreviewDebounceInterval(int msec)
+{
+    settings->setValue(PREVIEW_DEBOUNCE_INTERVAL, msec);
+}
+
+int Configuration::getPreviewDebounceInterval()
+{
+    QVariant var = settings->value(PREVIEW_DEBOUNCE_INTERVAL);
+    if(var.isValid() && var.canConvert(QVariant::Int) && var.toInt()>=0){
+        return var.toInt();
+    } else {
+        setPreviewDebounceInterval(150);
+        return 150;
+    }
+}
+
+/**
+ * @brief Configuration::setRenderCacheSize The memory budget of the render
+ *        cache in MB, 0 turns it off.
+ */
+void Configuration::setRenderCacheSize(int mb)
+{
+    settings->setValue(RENDER_CACHE_SIZE, mb);
+}
+
+int Configuration::getRenderCacheSize()
+{
+    QVariant var = settings->value(RENDER_CACHE_SIZE);
+    if(var.isValid() && var.canConvert(QVariant::Int) && var.toInt()>=0){
+        return var.toInt();
+    } else {
+        setRenderCacheSize(32);
+        return 32;
+    }
+}
+
+void Configuration::setRecordTimings(bool b)
+{
+    settings->setValue(RECORD_TIMINGS, b);
+}
+
+bool Configuration::isRecordTimings()
+{
+    QVariant var = settings->value(RECORD_TIMINGS);
+    if(var.isValid() && var.canConvert(QVariant::Bool)){
+        return var.toBool();
+    } else {
+        setRecordTimings(false);
+        return false;
+    }
+}
+
+void Configuration::setMarkdownHighlighter(int type)
+{
+    settings->setValue(MARKDOWN_HIGHLIGHTER, type);
+}
+
+int Configuration::getMarkdownHighlighter()
+{
+    QVariant var = settings->value(MARKDOWN_HIGHLIGHTER);
+    if(var.isValid() && var.canConvert(QVariant::Int)){
+        switch(var.toInt())
+        {
+            case MdCharmGlobal::ScanHighlighter:
+                return MdCharmGlobal::ScanHighlighter;
+            default:
+                return MdCharmGlobal::RuleHighlighter;
+        }
+    } else {
+        setMarkdownHighlighter(MdCharmGlobal::RuleHighlighter);
+        return MdCharmGlobal::RuleHighlighter;
+    }
+}
+
+void Configuration::setLazyHighlight(bool b)
+{
+    settings->setValue(LAZY_HIGHLIGHT, b);
+}
+
+bool Configuration::isLazyHighlight()
+{
+    QVariant var = settings->value(LAZY_HIGHLIGHT);
+    if(var.isValid() && var.canConvert(QVariant::Bool)){
+        return var.toBool();
+    } else {
+        setLazyHighlight(true);
+        return true;
+    }
+}
+
 QVariant Configuration::getLastStateValue(const QString &key) const
 {
     return settings->value(LAST_STATE_GROUP+key);
@@ -66,6 +66,7 @@ public:
     MdCharmGlobal::UTF8BOM getUtf8BOMOptions();
     QString getLanguageSpellCheckDictPath(const QString &lan);
     QString getLanguageSpellCheckUserDictPath();
+    QString getLanguageSpellCheckCachePath(const QString &lan);
     const QStringList getAllAvailableSpellCheckDictNames();
     bool isCheckSpell();
     void setCheckSpell(bool b);
@@ -103,6 +104,18 @@ public:
     void setRightMarginColumn(int column);
     void setMarkdownEngineType(MarkdownToHtml::MarkdownType type);
     MarkdownToHtml::MarkdownType getMarkdownEngineType() const;
+    void setIncrementalPreview(bool b);
+    bool isIncrementalPreview();
+    void setPreviewDebounceInterval(int msec);
+    int getPreviewDebounceInterval();
+    void setRenderCacheSize(int mb);
+    int getRenderCacheSize();
+    void setRecordTimings(bool b);
+    bool isRecordTimings();
+    void setMarkdownHighlighter(int type);
+    int getMarkdownHighlighter();
+    void setLazyHighlight(bool b);
+    bool isLazyHighlight();
     QVariant getLastStateValue(const QString &key) const;
     void setLastStateValue(const QString &key, const QVariant &value);
     QString getKeyboardShortcut(int s);
@@ -153,6 +166,12 @@ private:
     static const QString LAST_IGNORE_REVISION;
     static const QString RIGHT_MARGIN_COLUMN;
     static const QString MARKDOWN_ENGINE;
+    static const QString INCREMENTAL_PREVIEW;
+    static const QString PREVIEW_DEBOUNCE_INTERVAL;
+    static const QString RENDER_CACHE_SIZE;
+    static const QString RECORD_TIMINGS;
+    static const QString MARKDOWN_HIGHLIGHTER;
+    static const QString LAZY_HIGHLIGHT;
     static const QString LAST_STATE_GROUP;
     static const QString SHORTCUTS_GROUP;
 
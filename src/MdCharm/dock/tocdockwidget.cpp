@@ -5,7 +5,7 @@
 #include "tocdockwidget.h"
 #include "ui_tocdockwidget.h"
 #include "configuration.h"
-#include "util/updatetocthread.h"
+#include "timingprofiler.h"
 
 #include <QtWebKit>
 #include <QWebFrame>
@@ -18,8 +18,6 @@ TOCDockWidget::TOCDockWidget(QWidget *parent) :
 
     ui->webView->page()->setLinkDelegationPolicy(QWebPage::DelegateAllLinks);
 
-    thread = new UpdateTocThread(this);
-
     QFile htmlTemplate(":/markdown/toc.html");
     if(htmlTemplate.open(QIODevice::ReadOnly))
     {
@@ -29,9 +27,9 @@ TOCDockWidget::TOCDockWidget(QWidget *parent) :
     }
 
     connect(this, SIGNAL(visibilityChanged(bool)), this, SLOT(visibleChange(bool)));
-    connect(thread, SIGNAL(finished()), this, SLOT(workerFinished()));
-    connect(thread, SIGNAL(workerResult(QString)), this, SLOT(updateTocContent(QString)));
     connect(ui->webView, SIGNAL(linkClicked(QUrl)), this, SIGNAL(anchorClicked(QUrl)));
+    //an outline given while the template loads has no body to go to
+    connect(ui->webView, SIGNAL(loadFinished(bool)), this, SLOT(showOutline()));
 }
 
 void TOCDockWidget::visibleChange(bool b)
@@ -40,43 +38,24 @@ void TOCDockWidget::visibleChange(bool b)
     conf->setTocDockWidgetVisible(b);
 }
 
-void TOCDockWidget::workerFinished()
-{
-    mutex.lock();
-
-    if(!this->content.isEmpty() && thread->isFinished()){
-        thread->setContent(this->type, this->content);
-        thread->start();
-        this->content.clear();
-    }
-
-    mutex.unlock();
-}
-
 TOCDockWidget::~TOCDockWidget()
 {
     delete ui;
-    thread->quit();
-    delete thread;
 }
 
-void TOCDockWidget::updateToc(MarkdownToHtml::MarkdownType type, const QString &content)
+void TOCDockWidget::updateToc(const MarkdownOutline &outline)
 {
-    mutex.lock();
-
-    if(!thread->isRunning()){
-        thread->setContent(type, content);
-        thread->start();
-        this->content.clear();
-    } else {
-        this->type = type;
-        this->content = content;
-    }
-
-    mutex.unlock();
+    if(outline==this->outline)
+        return;
+    this->outline = outline;
+    showOutline();
 }
 
-void TOCDockWidget::updateTocContent(const QString &result)
+void TOCDockWidget::showOutline()
 {
-    ui->webView->page()->currentFrame()->findFirstElement("body").setInnerXml(result);
+    PROFILE_SCOPE("toc.update");
+    std::string html;
+    outline.toTocHtml(html);
+    ui->webView->page()->currentFrame()->findFirstElement("body")
+            .setInnerXml(QString::fromUtf8(html.c_str(), html.length()));
 }
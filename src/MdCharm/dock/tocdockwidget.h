@@ -6,12 +6,9 @@
 #define TOCDOCKWIDGET_H
 
 #include <QDockWidget>
-#include <QMutex>
 #include <QUrl>
 
-#include "markdowntohtml.h"
-
-class UpdateTocThread;
+#include "markdownoutline.h"
 
 namespace Ui {
 class TOCDockWidget;
@@ -26,23 +23,19 @@ public:
     ~TOCDockWidget();
 
 public slots:
-    void updateToc(MarkdownToHtml::MarkdownType type, const QString &content);
+    void updateToc(const MarkdownOutline &outline);
 
 signals:
     void anchorClicked(const QUrl &link);
 
 private slots:
     void visibleChange(bool b);
-    void workerFinished();
-    void updateTocContent(const QString &result);
+    void showOutline();
 
 private:
     Ui::TOCDockWidget *ui;
 
-    QMutex mutex;
-    MarkdownToHtml::MarkdownType type;
-    QString content;
-    UpdateTocThread *thread;
+    MarkdownOutline outline;//the one on the page
 };
 
 #endif // TOCDOCKWIDGET_H
@@ -71,7 +71,7 @@ MarkdownEditAreaWidget* EditAreaTabWidgetManager::addMarkdownEditAreaWidget(
     connect(newMEAW, SIGNAL(updateActions()), this, SLOT(updateStatus()));
     connect(newMEAW, SIGNAL(addToRecentFileList(QString)),
             this, SIGNAL(addToRecentFileList(QString)));
-    connect(newMEAW, SIGNAL(textChanged()), this, SIGNAL(currentTabTextChanged()));
+    connect(newMEAW, SIGNAL(outlineChanged()), this, SIGNAL(currentTabOutlineChanged()));
     return newMEAW;
 }
 
@@ -507,6 +507,7 @@ void EditAreaTabWidgetManager::cloneToOtherViewSlot(int index)
             connect(meaw, SIGNAL(updateActions()), this, SLOT(updateStatus()));
             connect(meaw, SIGNAL(addToRecentFileList(QString)),
                     this, SIGNAL(addToRecentFileList(QString)));
+            connect(meaw, SIGNAL(outlineChanged()), this, SIGNAL(currentTabOutlineChanged()));
         }
     }
     int newIndex = otherView->addEditAreaTab(copy, copy->isModified() ? QIcon(Resource::ModifiedIconStr) : QIcon(Resource::UnmodifiedIconStr), view->tabText(index));
@@ -699,6 +700,7 @@ void EditAreaTabWidgetManager::restoreTabsState(const QList<StateModel> &sml)
                         connect(meaw, SIGNAL(updateActions()), this, SLOT(updateStatus()));
                         connect(meaw, SIGNAL(addToRecentFileList(QString)),
                                 this, SIGNAL(addToRecentFileList(QString)));
+                        connect(meaw, SIGNAL(outlineChanged()), this, SIGNAL(currentTabOutlineChanged()));
                     }
                 }
                 view->addEditAreaTab(copy,
@@ -47,7 +47,7 @@ signals:
     void addToRecentFileList(QString);
     void updateActions();
     void showStatusMessage(const QString &msg);
-    void currentTabTextChanged();
+    void currentTabOutlineChanged();
 public slots:
     void closeCurrentTab();
     void checkFileStatusWhenMainWindowActived();
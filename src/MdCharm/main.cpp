@@ -57,7 +57,7 @@ int main(int argc, char** argv)
 #endif
     handler->appendArgument(conf->configFileDirPath().append("/sysinfo.txt"));
     if(conf->isCheckSpell())
-        MdCharmGlobal::getInstance();
+        MdCharmGlobal::getInstance();//starts loading the dictionary in the background
     QStringList argsList = app.arguments();
     argsList.removeFirst();
 
@@ -14,11 +14,14 @@
 #include <QTextDocumentWriter>
 #include <QTextDocument>
 #include <QDir>
+#include <QTimer>
 #include <QtGui>
 #include <QWebElement>
 
 #include "markdowneditareawidget.h"
 #include "markdowntohtml.h"
+#include "markdownrenderer.h"
+#include "html.h"
 #include "resource.h"
 #include "utils.h"
 #include "util/zip/zipwriter.h"
@@ -32,6 +35,9 @@
 #include "mdcharmform.h"
 #include "dock/projectdockwidget.h"
 #include "basewebview/markdownwebview.h"
+#include "util/previewrenderthread.h"
+#include "util/documentutf8mirror.h"
+#include "timingprofiler.h"
 
 //------------------MarkdownWebkitHandler---------------------------------------
 
@@ -65,11 +71,15 @@ MarkdownEditAreaWidget::MarkdownEditAreaWidget(MdCharmForm *mainForm, const QStr
 {
     inited = false;
 //    lastRevision = -2;
+    appliedRevision = -1;
+    previewNeedsFull = true;
     this->baseUrl = baseUrl;
     em.setEditorType(EditorModel::MARKDOWN);
+    htmlRenderer = new MarkdownRenderer(sdhtml_renderer);
 
     initGui();
     initContent(filePath);
+    utf8Mirror = new DocumentUtf8Mirror(editor->document(), this);
     initConfiguration();
     initPreviewerMatter();
     initSignalsAndSlots();
@@ -85,6 +95,14 @@ void MarkdownEditAreaWidget::initPreviewerMatter()
                      this, SLOT(addJavascriptObject()));
     QObject::connect(previewer->page(), SIGNAL(linkHovered(QString,QString,QString)),
                      this, SIGNAL(showStatusMessage(QString)));
+    renderThread = new PreviewRenderThread(this);
+    connect(renderThread, SIGNAL(renderFinished(int,int,QString,QStringList,QString,MarkdownOutline)),
+            this, SLOT(previewRenderFinished(int,int,QString,QStringList,QString,MarkdownOutline)),
+            Qt::QueuedConnection);
+    renderThread->start(QThread::LowPriority);
+    previewTimer = new QTimer(this);
+    previewTimer->setSingleShot(true);
+    connect(previewTimer, SIGNAL(timeout()), this, SLOT(requestPreviewRender()));
     initHtmlEngine();
 }
 
@@ -99,13 +117,14 @@ void MarkdownEditAreaWidget::initHtmlEngine()
     QString htmlContent = htmlTemplate.readAll();
     htmlTemplate.close();
 
-    std::string textResult = convertMarkdownToHtml();
-
     previewer->setHtml(htmlContent.arg(conf->getMarkdownCSS())
                        .arg("<script type=\"text/javascript\" src=\"qrc:/jquery.js\"></script>")
                        .arg("<script type=\"text/javascript\" src=\"qrc:/markdown/markdown.js\"></script>")
-                       .arg(QString::fromUtf8(textResult.c_str(), textResult.length())),
+                       .arg(convertMarkdownToHtml()),
                        baseUrl);
+    //the new page has no block elements, the next update renders everything
+    previewNeedsFull = true;
+    appliedRevision = editor->document()->revision();
 }
 
 void MarkdownEditAreaWidget::initGui()
@@ -167,7 +186,12 @@ void MarkdownEditAreaWidget::initContent(const QString &filePath)
     QAbstractTextDocumentLayout *layout = new QPlainTextDocumentLayout(doc.data());
     doc->setDocumentLayout(layout);
     editor->setDocument(doc.data());
-    highlighter = new MarkdownHighLighter(doc.data());
+    if(conf->getMarkdownHighlighter()==MdCharmGlobal::ScanHighlighter)
+        highlighter = new MarkdownScanHighLighter(doc.data());
+    else
+        highlighter = new MarkdownHighLighter(doc.data());
+    if(conf->isLazyHighlight())
+        highlighter->enableLazyHighlight(editor);
     //deal file content
     if(filePath.isEmpty())
     {
@@ -212,9 +236,9 @@ void MarkdownEditAreaWidget::initContent(const QString &filePath)
 
 void MarkdownEditAreaWidget::initSignalsAndSlots()
 {
-    if(conf->getPreviewOption()==MdCharmGlobal::WriteRead)
-        connect(editor, SIGNAL(textChanged()),
-                         this, SLOT(parseMarkdown()));
+    //the toc needs the renders even when the preview is hidden
+    connect(editor, SIGNAL(textChanged()),
+                     this, SLOT(schedulePreviewUpdate()));
     if(conf->isSyncScrollbar()){
         connect(editorScrollBar, SIGNAL(valueChanged(int)),
                 this, SLOT(scrollPreviewTo(int)));
@@ -236,6 +260,8 @@ void MarkdownEditAreaWidget::initSignalsAndSlots()
     connect(editor, SIGNAL(overWriteModeChanged()),
                      this, SLOT(overWriteModeChanged()));
     connect(editor, SIGNAL(textChanged()), this, SIGNAL(textChanged()));
+    connect(editor->document(), SIGNAL(contentsChange(int,int,int)),
+            this, SLOT(documentContentsChange(int,int,int)));
 
     connect(findAndReplaceWidget, SIGNAL(findText(QString,QTextDocument::FindFlags,bool, bool)),
                      editor, SLOT(findAndHighlightText(QString, QTextDocument::FindFlags,bool, bool)));
@@ -261,8 +287,83 @@ void MarkdownEditAreaWidget::parseMarkdown()
 //    if (lastRevision == editor->document()->revision())
 //        return;
 //    lastRevision = editor->document()->revision();
-    std::string textResult = convertMarkdownToHtml();
-    previewer->page()->mainFrame()->findFirstElement("body").setInnerXml(QString::fromUtf8(textResult.c_str(), textResult.length()));
+    //synchronous, the callers (export, switching the preview) need the page now
+    PROFILE_SCOPE("preview.parseMarkdown");
+    previewTimer->stop();
+    previewer->page()->mainFrame()->findFirstElement("body").setInnerXml(convertMarkdownToHtml());
+    //the page has no block elements any more
+    previewNeedsFull = true;
+    appliedRevision = editor->document()->revision();
+}
+
+void MarkdownEditAreaWidget::schedulePreviewUpdate()
+{
+    //restart the timer, a burst of edits is rendered once
+    previewTimer->start(conf->getPreviewDebounceInterval());
+}
+
+void MarkdownEditAreaWidget::requestPreviewRender()
+{
+    renderThread->requestRender(editor->document()->revision(), conf->getMarkdownEngineType(),
+                                utf8Mirror->utf8(),
+                                previewNeedsFull || !conf->isIncrementalPreview());
+    previewNeedsFull = false;
+}
+
+void MarkdownEditAreaWidget::previewRenderFinished(int revision, int result, const QString &html,
+                                                   const QStringList &removedIds, const QString &afterId,
+                                                   const MarkdownOutline &outline)
+{
+    if(revision<appliedRevision){
+        //the page has been rendered synchronously meanwhile, the worker's
+        //blocks do not match it
+        previewNeedsFull = true;
+        return;
+    }
+    appliedRevision = revision;
+    setOutline(outline);
+    if(previewer->isHidden()){
+        //showing the preview renders it again with parseMarkdown()
+        return;
+    }
+    if(result==MarkdownBlockRenderer::FullRender){
+        PROFILE_SCOPE("preview.setInnerXml");
+        previewer->page()->mainFrame()->findFirstElement("body").setInnerXml(html);
+    } else if(result==MarkdownBlockRenderer::PatchRender
+              && !applyPreviewPatch(removedIds, afterId, html)){
+        //the page does not match the last render, e.g. it has been reloaded
+        previewNeedsFull = true;
+        requestPreviewRender();
+    }
+}
+
+bool MarkdownEditAreaWidget::applyPreviewPatch(const QStringList &removedIds, const QString &afterId,
+                                               const QString &html)
+{
+    PROFILE_SCOPE("preview.applyPatch");
+    QWebFrame *frame = previewer->page()->mainFrame();
+    QWebElement anchor;
+    if(!afterId.isEmpty()){
+        anchor = frame->findFirstElement(QString::fromLatin1("#")+afterId);
+        if(anchor.isNull())
+            return false;
+    }
+    QList<QWebElement> removed;
+    for(int i=0; i<removedIds.size(); i++){
+        QWebElement element = frame->findFirstElement(QString::fromLatin1("#")+removedIds.at(i));
+        if(element.isNull())
+            return false;
+        removed.append(element);
+    }
+    for(int i=0; i<removed.size(); i++)
+        removed[i].removeFromDocument();
+    if(html.isEmpty())
+        return true;
+    if(anchor.isNull())
+        frame->findFirstElement("body").prependInside(html);
+    else
+        anchor.appendOutside(html);
+    return true;
 }
 
 void MarkdownEditAreaWidget::reFind()
@@ -313,12 +414,11 @@ void MarkdownEditAreaWidget::exportToPdf(const QString &filePath)
 
 void MarkdownEditAreaWidget::exportToODT(const QString &filePath)
 {
-    std::string textResult = convertMarkdownToHtml();
     QTextDocument textDocument;
     Configuration *conf = Configuration::getInstance();
     QFont font(conf->getFontFamily(), conf->getFontSize());
     textDocument.setDefaultFont(font);
-    textDocument.setHtml(QString::fromUtf8(textResult.c_str(), textResult.length()));
+    textDocument.setHtml(convertMarkdownToHtml());
 //    QTextDocumentWriter writer(filePath, QByteArray("odf"));
 //    writer.write(&textDocument);
     ODTWriter odtWriter(textDocument, filePath);
@@ -336,12 +436,10 @@ void MarkdownEditAreaWidget::exportToHtml(const QString &filePath)
     QString htmlContent = htmlTemplate.readAll();
     htmlTemplate.close();
 
-    std::string textResult = convertMarkdownToHtml();
-
     htmlContent = htmlContent.arg(conf->getMarkdownCSS())
                        .arg("")
                        .arg("")
-                       .arg(QString::fromUtf8(textResult.c_str(), textResult.length()));
+                       .arg(convertMarkdownToHtml());
     Utils::saveFile(filePath, htmlContent.toUtf8());
 }
 
@@ -415,7 +513,6 @@ void MarkdownEditAreaWidget::saveFileAs()
 
 void MarkdownEditAreaWidget::switchPreview(int type)
 {
-    disconnect(editor, SIGNAL(textChanged()), this, SLOT(parseMarkdown()));
     switch(type){
         case MdCharmGlobal::WriteMode:
             previewer->setVisible(false);
@@ -424,7 +521,6 @@ void MarkdownEditAreaWidget::switchPreview(int type)
         case MdCharmGlobal::WriteRead:
             previewer->setVisible(true);
             editor->setVisible(true);
-            connect(editor, SIGNAL(textChanged()), this, SLOT(parseMarkdown()));
             parseMarkdown();
             break;
         case MdCharmGlobal::ReadMode:
@@ -624,6 +720,14 @@ void MarkdownEditAreaWidget::cursorPositionChanged()
     emit updateStatusBar();
 }
 
+void MarkdownEditAreaWidget::documentContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    //the whole document is replaced (reload, setText), diffing it against
+    //the last render is useless
+    if(position==0 && charsRemoved>0 && charsAdded>=editor->document()->characterCount()-1)
+        previewNeedsFull = true;
+}
+
 void MarkdownEditAreaWidget::overWriteModeChanged()
 {
     em.overWriteChanged();
@@ -785,20 +889,41 @@ void MarkdownEditAreaWidget::paintRequestSlot(QPrinter *printer)
 
 MarkdownEditAreaWidget::~MarkdownEditAreaWidget()
 {
+    renderThread->stop();
+    renderThread->wait();
     markdownWebkitHandler->deleteLater();
+    delete htmlRenderer;
+}
+
+QString MarkdownEditAreaWidget::convertMarkdownToHtml()
+{
+    //the mirror and the renderer's html are read in place, the only copy
+    //is the one QtWebKit needs
+    const QByteArray &content = utf8Mirror->utf8();
+    htmlRenderer->render(conf->getMarkdownEngineType(), content.constData(), content.length());
+    setOutline(htmlRenderer->getOutline());
+    return QString::fromUtf8(htmlRenderer->getHtml(), htmlRenderer->getHtmlSize());
+}
+
+void MarkdownEditAreaWidget::setOutline(const MarkdownOutline &outline)
+{
+    if(outline==this->outline)
+        return;
+    this->outline = outline;
+    emit outlineChanged();
 }
 
-std::string MarkdownEditAreaWidget::convertMarkdownToHtml()
+const MarkdownOutline& MarkdownEditAreaWidget::getOutline() const
 {
-    QByteArray content = editor->toPlainText().toUtf8();
-    std::string textResult;
-    MarkdownToHtml::translateMarkdownToHtml(conf->getMarkdownEngineType(), content.data(), content.length(), textResult);
-    return textResult;
+    return outline;
 }
 
 void MarkdownEditAreaWidget::jumpToPreviewAnchor(const QString &anchor)
 {
     previewer->page()->currentFrame()->scrollToAnchor(anchor);
+    int line = outline.findLine(anchor.toUtf8().constData());
+    if(line>=0 && !editor->isHidden())
+        gotoLine(line+1);
 }
 
 //-------------------------------- Clone ---------------------------------------
@@ -807,12 +932,15 @@ MarkdownEditAreaWidget::MarkdownEditAreaWidget(MarkdownEditAreaWidget &src) :
 {
     mainForm = src.mainForm;
     inited = false;
+    appliedRevision = -1;
+    previewNeedsFull = true;
     baseUrl = src.baseUrl;
     doc = QSharedPointer<QTextDocument>(src.doc);
     em.setEditorType(EditorModel::MARKDOWN);
 
     initGui();
     editor->setDocument(doc.data());
+    utf8Mirror = new DocumentUtf8Mirror(editor->document(), this);
     initConfiguration();
     initPreviewerMatter();
     initSignalsAndSlots();
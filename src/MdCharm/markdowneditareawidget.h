@@ -2,6 +2,7 @@
 #define MARKDOWNEDITAREAWIDGET_H
 
 #include "editareawidget.h"
+#include "markdownoutline.h"
 
 #include <QUrl>
 #include <QTextDocument>
@@ -19,6 +20,10 @@ class FindAndReplace;
 class QScrollBar;
 class HighLighter;
 class MdCharmForm;
+class PreviewRenderThread;
+class QTimer;
+class MarkdownRenderer;
+class DocumentUtf8Mirror;
 
 //This class is useless
 class MarkdownWebkitHandler : public QObject
@@ -67,6 +72,7 @@ public:
     QTextDocument* document();
 
     void jumpToPreviewAnchor(const QString &anchor);
+    const MarkdownOutline& getOutline() const;
 
 private:
     explicit MarkdownEditAreaWidget(MarkdownEditAreaWidget &src);
@@ -78,7 +84,10 @@ private:
     void initSignalsAndSlots();
     void insertLinkOrPicture(int type);
     void insertCode();
-    std::string convertMarkdownToHtml();
+    QString convertMarkdownToHtml();
+    bool applyPreviewPatch(const QStringList &removedIds, const QString &afterId,
+                           const QString &html);
+    void setOutline(const MarkdownOutline &outline);
 public:
     virtual EditAreaWidget* clone();
     QString getProDir();
@@ -92,6 +101,13 @@ private:
     HighLighter *highlighter;
     FindAndReplace *findAndReplaceWidget;
     QSharedPointer<QTextDocument> doc;
+    PreviewRenderThread *renderThread;
+    MarkdownRenderer *htmlRenderer;//for the synchronous renders
+    DocumentUtf8Mirror *utf8Mirror;//the text the renderers read
+    MarkdownOutline outline;//headers of the last render, for the toc
+    QTimer *previewTimer;
+    int appliedRevision;
+    bool previewNeedsFull;
 //    int lastRevision;
 
     bool inited;
@@ -103,9 +119,12 @@ signals:
     void addToRecentFileList(const QString &path);
     void focusInSignal();
     void textChanged();
+    void outlineChanged();
     
 public slots:
     void parseMarkdown();
+    void schedulePreviewUpdate();
+    void requestPreviewRender();
     void reFind();
     void addJavascriptObject();
     virtual void copy();
@@ -127,6 +146,10 @@ public slots:
     void hideFind();
 private slots:
     void cursorPositionChanged();
+    void documentContentsChange(int position, int charsRemoved, int charsAdded);
+    void previewRenderFinished(int revision, int result, const QString &html,
+                               const QStringList &removedIds, const QString &afterId,
+                               const MarkdownOutline &outline);
     void overWriteModeChanged();
     void scrollPreviewTo(int value);
     void scrollPreviewTo();
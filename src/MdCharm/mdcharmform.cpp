@@ -32,6 +32,8 @@
 #include "dock/projectdockwidget.h"
 #include "dock/tocdockwidget.h"
 #include "editareatabwidgetmanager.h"
+#include "rendercache.h"
+#include "timingprofiler.h"
 
 MdCharmForm::MdCharmForm(QWidget *parent) :
     QMainWindow(parent)
@@ -43,6 +45,8 @@ MdCharmForm::MdCharmForm(QWidget *parent) :
     cu = new CheckUpdates();
     mcsd = NULL;
     appTitle = QString::fromLatin1("MdCharm");
+    RenderCache::instance()->setBudget((size_t)conf->getRenderCacheSize()*1024*1024);
+    TimingProfiler::instance()->setEnabled(conf->isRecordTimings());
     initGui();
     initMenuContent();
     initToolBarContent();
@@ -509,7 +513,7 @@ void MdCharmForm::initSignalsAndSlots()
     connect(editAreaTabWidgetManager, SIGNAL(addToRecentFileList(QString)), this, SLOT(addToRecentFileList(QString)));
     connect(editAreaTabWidgetManager, SIGNAL(updateActions()), this, SLOT(updateActions()));
     connect(editAreaTabWidgetManager, SIGNAL(showStatusMessage(QString)), statusBar, SLOT(showMessage(QString)));
-    connect(editAreaTabWidgetManager, SIGNAL(currentTabTextChanged()), this, SLOT(updateTocContent()));
+    connect(editAreaTabWidgetManager, SIGNAL(currentTabOutlineChanged()), this, SLOT(updateTocContent()));
 
     connect(exportDirAction, SIGNAL(triggered()), this, SLOT(exportDirSlot()));
 
@@ -718,7 +722,7 @@ void MdCharmForm::updateActions()
     findNextAction->setEnabled(em.isFindVisible());
     findPreviousAction->setEnabled(em.isFindVisible());
 
-    tocDockWidget->updateToc(conf->getMarkdownEngineType(), editArea->getText());
+    updateTocContent();
 }
 
 void MdCharmForm::updatePreviewOptionActions(int type)
@@ -1330,7 +1334,9 @@ void MdCharmForm::updateTocContent()
     EditAreaWidget *editArea = editAreaTabWidgetManager->getCurrentWidget();
     if(!editArea)
         return;
-    tocDockWidget->updateToc(conf->getMarkdownEngineType(), editArea->getText());
+    MarkdownEditAreaWidget *meaw = qobject_cast<MarkdownEditAreaWidget *>(editArea);
+    //the outline comes with the preview render, the toc does not parse
+    tocDockWidget->updateToc(meaw ? meaw->getOutline() : MarkdownOutline());
 }
 
 void MdCharmForm::jumpToAnchor(const QUrl &url)
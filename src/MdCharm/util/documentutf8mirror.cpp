@@ -0,0 +1,132 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#include <QTextDocument>
+#include <QTextCursor>
+
+#include "documentutf8mirror.h"
+#include "timingprofiler.h"
+
+DocumentUtf8Mirror::DocumentUtf8Mirror(QTextDocument *document, QObject *parent) :
+    QObject(parent)
+{
+    this->document = document;
+    valid = false;
+    chars = 0;
+    hintPosition = 0;
+    hintOffset = 0;
+    connect(document, SIGNAL(contentsChange(int,int,int)),
+            this, SLOT(contentsChange(int,int,int)));
+}
+
+const QByteArray& DocumentUtf8Mirror::utf8()
+{
+    if(!valid){
+        PROFILE_SCOPE("preview.toPlainText");
+        QString plainText = document->toPlainText();
+        text = plainText.toUtf8();
+        chars = plainText.length();
+        hintPosition = 0;
+        hintOffset = 0;
+        valid = true;
+    }
+    return text;
+}
+
+void DocumentUtf8Mirror::invalidate()
+{
+    valid = false;
+    text.clear();
+}
+
+/**
+ * @brief DocumentUtf8Mirror::byteOffset Convert a utf-16 position to an
+ *        offset in text, walking from the last converted position.
+ * @return -1 if the position is not on a character boundary of text
+ */
+int DocumentUtf8Mirror::byteOffset(int position)
+{
+    const unsigned char *data = (const unsigned char *)text.constData();
+    int size = text.size();
+    int current = hintPosition;
+    int offset = hintOffset;
+    if(position<current/2){
+        current = 0;
+        offset = 0;
+    }
+    while(current<position && offset<size){
+        unsigned char c = data[offset];
+        if(c<0x80)
+            offset++;
+        else if(c<0xE0)
+            offset += 2;
+        else if(c<0xF0)
+            offset += 3;
+        else
+            offset += 4;
+        //four bytes are a surrogate pair in utf-16
+        current += c>=0xF0 ? 2 : 1;
+    }
+    while(current>position && offset>0){
+        do {
+            offset--;
+        } while(offset>0 && (data[offset]&0xC0)==0x80);
+        current -= data[offset]>=0xF0 ? 2 : 1;
+    }
+    if(current!=position || offset>size)
+        return -1;
+    hintPosition = current;
+    hintOffset = offset;
+    return offset;
+}
+
+void DocumentUtf8Mirror::contentsChange(int position, int charsRemoved, int charsAdded)
+{
+    if(!valid)
+        return;
+    PROFILE_SCOPE("preview.mirrorUpdate");
+    //the last paragraph separator is not part of the plain text
+    int documentChars = document->characterCount()-1;
+    if(position<0 || charsRemoved<0 || charsAdded<0
+            || position+charsRemoved>chars
+            || position+charsAdded>documentChars
+            || chars-charsRemoved+charsAdded!=documentChars){
+        invalidate();
+        return;
+    }
+    int begin = byteOffset(position);
+    int end = begin<0 ? -1 : byteOffset(position+charsRemoved);
+    if(end<0){
+        invalidate();
+        return;
+    }
+
+    QTextCursor cursor(document);
+    cursor.setPosition(position);
+    cursor.setPosition(position+charsAdded, QTextCursor::KeepAnchor);
+    QString added = cursor.selectedText();
+    //the same replacements as QTextDocument::toPlainText()
+    QChar *c = added.data();
+    QChar *e = c+added.length();
+    for(; c<e; c++){
+        switch(c->unicode()){
+        case 0xfdd0://QTextBeginningOfFrame
+        case 0xfdd1://QTextEndOfFrame
+        case QChar::ParagraphSeparator:
+        case QChar::LineSeparator:
+            *c = QLatin1Char('\n');
+            break;
+        case QChar::Nbsp:
+            *c = QLatin1Char(' ');
+            break;
+        default:
+            break;
+        }
+    }
+    QByteArray addedUtf8 = added.toUtf8();
+    text.replace(begin, end-begin, addedUtf8);
+    chars = documentChars;
+    hintPosition = position+charsAdded;
+    hintOffset = begin+addedUtf8.size();
+}
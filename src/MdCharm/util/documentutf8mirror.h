@@ -0,0 +1,44 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#ifndef DOCUMENTUTF8MIRROR_H
+#define DOCUMENTUTF8MIRROR_H
+
+#include <QObject>
+#include <QByteArray>
+
+class QTextDocument;
+
+/**
+ * @brief Keeps the plain text of a document encoded as UTF-8, the same bytes
+ *        as toPlainText().toUtf8(). Each edit re-encodes only the changed
+ *        range. If a change does not add up with the mirror (e.g. the first
+ *        change of a new document), the whole text is encoded again the next
+ *        time utf8() is called.
+ */
+class DocumentUtf8Mirror : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DocumentUtf8Mirror(QTextDocument *document, QObject *parent = 0);
+    const QByteArray& utf8();
+    void invalidate();
+
+private slots:
+    void contentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    int byteOffset(int position);
+
+private:
+    QTextDocument *document;
+    QByteArray text;
+    bool valid;
+    int chars;//utf-16 length of text
+    //the last offset found, edits are usually close to the previous one
+    int hintPosition;
+    int hintOffset;
+};
+
+#endif // DOCUMENTUTF8MIRROR_H
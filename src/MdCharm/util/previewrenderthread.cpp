@@ -0,0 +1,107 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#include "previewrenderthread.h"
+#include "timingprofiler.h"
+
+PreviewRenderThread::PreviewRenderThread(QObject *parent) :
+    QThread(parent)
+{
+    hasJob = false;
+    stopped = false;
+    cancelled = false;
+    revision = -1;
+    full = false;
+    type = MarkdownToHtml::PHPMarkdownExtra;
+    qRegisterMetaType<MarkdownOutline>("MarkdownOutline");
+}
+
+PreviewRenderThread::~PreviewRenderThread()
+{
+    stop();
+    wait();
+}
+
+void PreviewRenderThread::requestRender(int revision, MarkdownToHtml::MarkdownType type,
+                                        const QByteArray &content, bool full)
+{
+    QMutexLocker locker(&mutex);
+    this->revision = revision;
+    this->type = type;
+    this->content = content;
+    //a dropped full request still has to be honoured by the next one
+    this->full = this->full || full;
+    hasJob = true;
+    cancelled = true;
+    condition.wakeOne();
+}
+
+void PreviewRenderThread::stop()
+{
+    QMutexLocker locker(&mutex);
+    stopped = true;
+    cancelled = true;
+    condition.wakeOne();
+}
+
+bool PreviewRenderThread::isCancelled() const
+{
+    return cancelled;
+}
+
+void PreviewRenderThread::run()
+{
+    forever {
+        mutex.lock();
+        while(!hasJob && !stopped)
+            condition.wait(&mutex);
+        if(stopped){
+            mutex.unlock();
+            return;
+        }
+        int jobRevision = revision;
+        bool jobFull = full;
+        MarkdownToHtml::MarkdownType jobType = type;
+        QByteArray jobContent = content;
+        content = QByteArray();
+        full = false;
+        hasJob = false;
+        cancelled = false;
+        mutex.unlock();
+
+        if(jobFull)
+            renderer.invalidate();
+        std::string html;
+        MarkdownBlockRenderer::Patch patch;
+        MarkdownBlockRenderer::RenderResult result;
+        {
+            PROFILE_SCOPE("preview.render");
+            result = renderer.render(jobType, jobContent.constData(), jobContent.length(), html, patch, this);
+        }
+        if(result==MarkdownBlockRenderer::Cancelled){
+            //the full request is not done yet
+            if(jobFull){
+                mutex.lock();
+                full = true;
+                mutex.unlock();
+            }
+            continue;
+        }
+        if(result==MarkdownBlockRenderer::NoChange)
+            continue;
+
+        QStringList removedIds;
+        QString afterId;
+        const std::string *outHtml = &html;
+        if(result==MarkdownBlockRenderer::PatchRender){
+            outHtml = &patch.insertedHtml;
+            for(size_t i=0; i<patch.removedIds.size(); i++)
+                removedIds.append(QString::fromLatin1(MarkdownBlockRenderer::blockElementId(patch.removedIds[i]).c_str()));
+            if(patch.afterId)
+                afterId = QString::fromLatin1(MarkdownBlockRenderer::blockElementId(patch.afterId).c_str());
+        }
+        emit renderFinished(jobRevision, result, QString::fromUtf8(outHtml->c_str(), outHtml->length()),
+                            removedIds, afterId, renderer.getOutline());
+    }
+}
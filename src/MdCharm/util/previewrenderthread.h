@@ -0,0 +1,67 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#ifndef PREVIEWRENDERTHREAD_H
+#define PREVIEWRENDERTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QStringList>
+#include <QByteArray>
+#include <QMetaType>
+
+#include "markdowntohtml.h"
+#include "blockrenderer.h"
+#include "markdownoutline.h"
+
+Q_DECLARE_METATYPE(MarkdownOutline)
+
+/**
+ * @brief Renders the preview of one editor on a worker thread.
+ *
+ * Only the newest request is kept: a request replaces the pending one, and
+ * cancels the running one between two blocks. A render that finishes is
+ * always the newest one, so every result must be applied in order.
+ */
+class PreviewRenderThread : public QThread, public RenderCanceller
+{
+    Q_OBJECT
+public:
+    explicit PreviewRenderThread(QObject *parent = 0);
+    ~PreviewRenderThread();
+    void requestRender(int revision, MarkdownToHtml::MarkdownType type,
+                       const QByteArray &content, bool full);
+    void stop();
+    virtual bool isCancelled() const;
+
+signals:
+    /**
+     * @param result one of MarkdownBlockRenderer::RenderResult
+     * @param html the whole body for FullRender, the inserted blocks for PatchRender
+     * @param removedIds element ids of the blocks to remove for PatchRender
+     * @param afterId element id of the block to insert after, empty for the beginning of body
+     * @param outline the headers of the whole document
+     */
+    void renderFinished(int revision, int result, const QString &html,
+                        const QStringList &removedIds, const QString &afterId,
+                        const MarkdownOutline &outline);
+
+protected:
+    void run();
+
+private:
+    QMutex mutex;
+    QWaitCondition condition;
+    bool hasJob;
+    bool stopped;
+    volatile bool cancelled;
+    int revision;
+    bool full;
+    MarkdownToHtml::MarkdownType type;
+    QByteArray content;//utf-8, shared with the editor's mirror until it changes
+    MarkdownBlockRenderer renderer;
+};
+
+#endif // PREVIEWRENDERTHREAD_H
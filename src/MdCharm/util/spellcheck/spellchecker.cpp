@@ -8,8 +8,9 @@
 #endif
 
 #include <QFile>
+#include <QFileInfo>
+#include <QDir>
 #include <QTextStream>
-#include <QRegExp>
 #include <QTextCodec>
 #include <QStringList>
 
@@ -122,7 +123,8 @@ int SpellCheckTokenizer::nextWordEnd() const
 //    }
 //}
 
-SpellChecker::SpellChecker(const QString &dictionaryPath, const QString &userDictionary, const QString &lan)
+SpellChecker::SpellChecker(const QString &dictionaryPath, const QString &userDictionary,
+                           const QString &cachePath, const QString &lan)
 {
     this->lan = lan;
     this->userDictionary = userDictionary;
@@ -130,24 +132,23 @@ SpellChecker::SpellChecker(const QString &dictionaryPath, const QString &userDic
     QString affixFilePath = dictionaryPath + ".aff";
     QByteArray dictFilePathBA = dictFilePath.toLocal8Bit();
     QByteArray affixFilePathBA = affixFilePath.toLocal8Bit();
+#ifdef Q_OS_WIN
+    //The word table is mapped from the cache while the .dic and .aff files
+    //are unchanged, and compiled into it again otherwise
+    QDir().mkpath(QFileInfo(cachePath).absolutePath());
+    QByteArray cachePathBA = cachePath.toLocal8Bit();
+    hunspell = new Hunspell(affixFilePathBA.constData(), dictFilePathBA.constData(),
+                            NULL, cachePathBA.constData());
+#else
+    Q_UNUSED(cachePath)
     hunspell = new Hunspell(affixFilePathBA.constData(), dictFilePathBA.constData());
+#endif
 
-    encoding = "ISO8859-1";
-    QFile affixFile(affixFilePath);
-    if(affixFile.open(QIODevice::ReadOnly)) {
-        QTextStream stream(&affixFile);
-        QRegExp enc_detector("^\\s*SET\\s+([A-Z0-9\\-]+)\\s*", Qt::CaseInsensitive);
-        for(QString line = stream.readLine(); !line.isEmpty(); line=stream.readLine()) {
-            if(enc_detector.indexIn(line) > -1) {
-                encoding = enc_detector.cap(1);
-                qDebug("Encoding set to %s", encoding.toLocal8Bit().constData());
-                break;
-            }
-        }
-        affixFile.close();
-    }
+    //Hunspell has read the SET line of the affix file already, and defaults
+    //to ISO8859-1 as well
+    encoding = QString::fromLatin1(hunspell->get_dic_encoding());
     codec = QTextCodec::codecForName(encoding.toLatin1().constData());
-    if(userDictionary.isEmpty()) {
+    if(!userDictionary.isEmpty()) {
         QFile userDictionaryFile(userDictionary);
         if(userDictionaryFile.open(QIODevice::ReadOnly)) {
             QTextStream stream(&userDictionaryFile);
@@ -219,7 +220,7 @@ void SpellChecker::put_word(const QString &word)
 void SpellChecker::addToUserWordlist(const QString &word)
 {
     put_word(word);
-    if(userDictionary.isEmpty()) {
+    if(!userDictionary.isEmpty()) {
         QFile userDictionaryFile(userDictionary);
         if(userDictionaryFile.open(QIODevice::Append)) {
             QTextStream stream(&userDictionaryFile);
@@ -36,7 +36,13 @@ private:
 class SpellChecker
 {
 public:
-    SpellChecker(const QString &dictionaryPath, const QString &userDictionary, const QString &lan);
+    /**
+     * @brief cachePath is where the compiled word table of the dictionary is
+     * kept between runs. It is only used with the bundled Hunspell, the
+     * system library has no cache.
+     */
+    SpellChecker(const QString &dictionaryPath, const QString &userDictionary,
+                 const QString &cachePath, const QString &lan);
     ~SpellChecker();
 
     bool spell(const QString &word);
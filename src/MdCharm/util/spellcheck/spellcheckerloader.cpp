@@ -0,0 +1,52 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#include "spellcheckerloader.h"
+#include "spellchecker.h"
+#include "timingprofiler.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+//Hunspell instances share a reference counted utf-8 table, so two
+//dictionaries are never loaded at the same time
+static QMutex loadMutex;
+
+SpellCheckerLoader::SpellCheckerLoader(const QString &dictionaryPath, const QString &userDictionary,
+                                       const QString &cachePath, const QString &lan, QObject *parent) :
+    QThread(parent)
+{
+    this->dictionaryPath = dictionaryPath;
+    this->userDictionary = userDictionary;
+    this->cachePath = cachePath;
+    this->lan = lan;
+    spellChecker = NULL;
+}
+
+SpellCheckerLoader::~SpellCheckerLoader()
+{
+    wait();
+    delete spellChecker;
+}
+
+QString SpellCheckerLoader::getLan() const
+{
+    return lan;
+}
+
+SpellChecker* SpellCheckerLoader::takeSpellChecker()
+{
+    if(!isFinished())
+        return NULL;
+    SpellChecker *result = spellChecker;
+    spellChecker = NULL;
+    return result;
+}
+
+void SpellCheckerLoader::run()
+{
+    QMutexLocker locker(&loadMutex);
+    PROFILE_SCOPE("spellcheck.load");
+    spellChecker = new SpellChecker(dictionaryPath, userDictionary, cachePath, lan);
+}
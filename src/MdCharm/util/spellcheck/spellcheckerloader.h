@@ -0,0 +1,45 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#ifndef SPELLCHECKERLOADER_H
+#define SPELLCHECKERLOADER_H
+
+#include <QThread>
+#include <QString>
+
+class SpellChecker;
+
+/**
+ * @brief Loads the dictionary of one language on a worker thread, so that
+ * parsing a large .aff/.dic pair does not hold up the UI.
+ *
+ * The spell checker is built by the thread and handed over once it has
+ * finished; it is then only used from the UI thread.
+ */
+class SpellCheckerLoader : public QThread
+{
+    Q_OBJECT
+public:
+    SpellCheckerLoader(const QString &dictionaryPath, const QString &userDictionary,
+                       const QString &cachePath, const QString &lan, QObject *parent = 0);
+    ~SpellCheckerLoader();
+    QString getLan() const;
+    /**
+     * @brief The loaded spell checker, which the caller owns from now on.
+     * NULL until the thread has finished.
+     */
+    SpellChecker* takeSpellChecker();
+
+protected:
+    void run();
+
+private:
+    QString dictionaryPath;
+    QString userDictionary;
+    QString cachePath;
+    QString lan;
+    SpellChecker *spellChecker;
+};
+
+#endif // SPELLCHECKERLOADER_H
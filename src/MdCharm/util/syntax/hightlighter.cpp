@@ -1,25 +1,145 @@
 #include <cassert>
+#include <climits>
 
 #include <QApplication>
+#include <QPlainTextEdit>
+#include <QScrollBar>
+#include <QElapsedTimer>
+#include <QTimer>
 
 #include "hightlighter.h"
-#include "util/test/qregularexpression.h"
+#include "timingprofiler.h"
+
+//blocks highlighted around the viewport in lazy mode
+static const int LazyHighlightMargin = 64;
+//time spent on pending blocks before yielding to the event loop
+static const int LazyHighlightSliceMsec = 10;
+//already highlighted blocks skipped between two looks at the clock
+static const int LazyHighlightClockStride = 256;
 
 HighLighter::HighLighter(QTextDocument *parent) :
-    QSyntaxHighlighter(parent)
+    QSyntaxHighlighter(parent),
+    idleTimer(NULL),
+    firstVisibleBlock(0),
+    lastVisibleBlock(0),
+    nextPendingBlock(0),
+    highlightedRun(0)
 {
 }
 
 HighLighter::HighLighter(QTextEdit *parent) :
-    QSyntaxHighlighter(parent)
+    QSyntaxHighlighter(parent),
+    idleTimer(NULL),
+    firstVisibleBlock(0),
+    lastVisibleBlock(0),
+    nextPendingBlock(0),
+    highlightedRun(0)
 {
 
 }
 
-void HighLighter::addTextCharFormat(const int weight, const QColor color, bool isItalic,
-                                    const QString &regExp)
+/*!
+ * In lazy mode a block is highlighted at once only when it is near the
+ * viewport of \a view (or was already highlighted). The other blocks keep the
+ * state -1 and are highlighted in idle-time slices, starting from where the
+ * user scrolled to. It must be enabled before the content is loaded.
+ */
+void HighLighter::enableLazyHighlight(QPlainTextEdit *view)
+{
+    lazyView = view;
+    idleTimer = new QTimer(this);
+    idleTimer->setSingleShot(true);
+    idleTimer->setInterval(0);
+    connect(idleTimer, SIGNAL(timeout()), this, SLOT(highlightPendingBlocks()));
+    connect(view->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(updateVisibleBlocks()));
+    updateVisibleBlocks();
+}
+
+void HighLighter::updateVisibleBlocks()
+{
+    if(!lazyView)
+        return;
+    firstVisibleBlock = lazyView->cursorForPosition(QPoint(0, 0)).blockNumber();
+    int lineSpacing = qMax(1, lazyView->fontMetrics().lineSpacing());
+    lastVisibleBlock = firstVisibleBlock+lazyView->viewport()->height()/lineSpacing+1;
+    QTextDocument *doc = document();
+    if(!doc)
+        return;
+    //what the user is looking at first, then on from there
+    for(QTextBlock block = doc->findBlockByNumber(qMax(0, firstVisibleBlock-LazyHighlightMargin));
+        block.isValid() && block.blockNumber()<=lastVisibleBlock+LazyHighlightMargin;
+        block = block.next())
+    {
+        if(block.userState()<0)
+            highlightPendingBlock(block);
+    }
+    //nothing left to do unless a block was left pending since the last scan
+    if(highlightedRun>=doc->blockCount())
+        return;
+    nextPendingBlock = firstVisibleBlock;
+    highlightedRun = 0;
+    idleTimer->start();
+}
+
+void HighLighter::highlightPendingBlocks()
+{
+    QTextDocument *doc = document();
+    if(!doc)
+        return;
+    QElapsedTimer timer;
+    timer.start();
+    QTextBlock block = doc->findBlockByNumber(nextPendingBlock);
+    if(!block.isValid())
+        block = doc->begin();
+    int blockCount = doc->blockCount();
+    int sinceClock = 0;
+    //done once a whole round of the document needed no work
+    while(highlightedRun<blockCount)
+    {
+        if(block.userState()<0)
+        {
+            highlightPendingBlock(block);
+            highlightedRun = 0;
+            sinceClock = LazyHighlightClockStride;
+        }
+        else
+        {
+            highlightedRun++;
+            sinceClock++;
+        }
+        block = block.next();
+        if(!block.isValid())
+            block = doc->begin();
+        if(sinceClock>=LazyHighlightClockStride)
+        {
+            sinceClock = 0;
+            if(timer.elapsed()>=LazyHighlightSliceMsec)
+            {
+                nextPendingBlock = block.blockNumber();
+                idleTimer->start();
+                return;
+            }
+        }
+    }
+    //stays done when blocks are added highlighted, until one is left pending
+    highlightedRun = INT_MAX;
+}
+
+void HighLighter::highlightPendingBlock(const QTextBlock &block)
+{
+    forcedBlock = block;
+    rehighlightBlock(block);
+    forcedBlock = QTextBlock();
+}
+
+bool HighLighter::isVisibleBlock(int blockNumber) const
+{
+    return blockNumber>=firstVisibleBlock-LazyHighlightMargin
+            && blockNumber<=lastVisibleBlock+LazyHighlightMargin;
+}
+
+QTextCharFormat HighLighter::createFormat(const int weight, const QColor color, bool isItalic)
 {
-    HighlightingRule rule;
     QTextCharFormat format;
     if(weight!=QFont::Normal)
         format.setFontWeight(weight);
@@ -27,23 +147,47 @@ void HighLighter::addTextCharFormat(const int weight, const QColor color, bool i
         format.setForeground(color);
     if(isItalic)
         format.setFontItalic(isItalic);
-    rule.pattern = regExp;
-    rule.format = format;
-    highlightingRules.append(rule);
+    return format;
+}
+
+HighlightingRule HighLighter::createRule(const int weight, const QColor color, bool isItalic,
+                                         const QString &regExp)
+{
+    HighlightingRule rule;
+    rule.pattern = QRegularExpression(regExp, QRegularExpression::DotMatchesEverythingOption);
+#ifdef MDCHARM_DEBUG
+    if(!rule.pattern.isValid())
+    {
+        qDebug(regExp.toLatin1());
+    }
+#endif
+    //compile and study it now, the rule is matched against every block
+    rule.pattern.optimize();
+    rule.format = createFormat(weight, color, isItalic);
+    return rule;
 }
 
 void HighLighter::highlightBlock(const QString &text)
 {
+    //a block that was never highlighted has a negative state
+    if(lazyView && currentBlockState()<0 && currentBlock()!=forcedBlock
+            && !isVisibleBlock(currentBlock().blockNumber()))
+    {
+        setCurrentBlockState(-1);
+        highlightedRun = 0;
+        if(!idleTimer->isActive())
+            idleTimer->start();
+        return;
+    }
+    highlightText(text);
+}
+
+void HighLighter::highlightText(const QString &text)
+{
+    PROFILE_SCOPE("editor.highlightBlock");
     foreach(const HighlightingRule &rule, highlightingRules)
     {
-        QRegularExpression re(rule.pattern, QRegularExpression::DotMatchesEverythingOption);
-#ifdef MDCHARM_DEBUG
-        if(!re.isValid())
-        {
-            qDebug(rule.pattern.toLatin1());
-        }
-#endif
-        QRegularExpressionMatchIterator remi = re.globalMatch(text);
+        QRegularExpressionMatchIterator remi = rule.pattern.globalMatch(text);
         while(remi.hasNext())
         {
             QRegularExpressionMatch rem = remi.next();
@@ -64,56 +208,367 @@ void HighLighter::highlightMultiLine(const QString &text)
 MarkdownHighLighter::MarkdownHighLighter(QTextDocument *parent) :
     HighLighter(parent)
 {
+    highlightingRules = sharedRules();
+}
+
+MarkdownHighLighter::~MarkdownHighLighter()
+{
+}
+
+const QVector<HighlightingRule>& MarkdownHighLighter::sharedRules()
+{
+    //built once and shared (implicitly) by every markdown editor
+    static QVector<HighlightingRule> rules;
+    if(!rules.isEmpty())
+        return rules;
     //html tags
-    addTextCharFormat(QFont::Bold, Qt::darkMagenta, false, QString::fromLatin1("<[^<>@]*>"));
+    rules.append(createRule(QFont::Bold, Qt::darkMagenta, false, QString::fromLatin1("<[^<>@]*>")));
     //html symbols
-    addTextCharFormat(QFont::Bold, Qt::darkCyan, false, QString::fromLatin1("&[^; ]*;"));
+    rules.append(createRule(QFont::Bold, Qt::darkCyan, false, QString::fromLatin1("&[^; ]*;")));
     //quote inside tag
-    addTextCharFormat(QFont::Bold, Qt::darkYellow, false, QString::fromLatin1("\"[^\"<]*\"(?=[^<]*>)"));
+    rules.append(createRule(QFont::Bold, Qt::darkYellow, false, QString::fromLatin1("\"[^\"<]*\"(?=[^<]*>)")));
     //html comment
-    addTextCharFormat(QFont::Bold, Qt::gray, false, QString::fromLatin1("<!--[^<>]*-->"));
+    rules.append(createRule(QFont::Bold, Qt::gray, false, QString::fromLatin1("<!--[^<>]*-->")));
     //italic
-    addTextCharFormat(QFont::Normal, Qt::darkCyan, true, QString::fromLatin1("(\\s|^)[\\*_]{1}[^\\s]{1}[^\\*_]+[\\*_]{1}(\\s|\\.|,|;|:|\\-|\\?|$)"));
+    rules.append(createRule(QFont::Normal, Qt::darkCyan, true, QString::fromLatin1("(\\s|^)[\\*_]{1}[^\\s]{1}[^\\*_]+[\\*_]{1}(\\s|\\.|,|;|:|\\-|\\?|$)")));
     //bold
-    addTextCharFormat(QFont::Bold, Qt::darkCyan, false, QString::fromLatin1("(\\s|^)[\\*_]{2}[^\\s]{1}[^\\*_]+[\\*_]{2}(\\s|\\.|,|;|:|\\-|\\?|$)"));
+    rules.append(createRule(QFont::Bold, Qt::darkCyan, false, QString::fromLatin1("(\\s|^)[\\*_]{2}[^\\s]{1}[^\\*_]+[\\*_]{2}(\\s|\\.|,|;|:|\\-|\\?|$)")));
     //bold and italic
-    addTextCharFormat(QFont::Bold, Qt::darkCyan, true, QString::fromLatin1("(\\s|^)[\\*_]{3}[^\\*_]+[\\*_]{3}(\\s|\\.|,|;|:|\\-|\\?|$)"));
+    rules.append(createRule(QFont::Bold, Qt::darkCyan, true, QString::fromLatin1("(\\s|^)[\\*_]{3}[^\\*_]+[\\*_]{3}(\\s|\\.|,|;|:|\\-|\\?|$)")));
     //link and images
-    addTextCharFormat(QFont::Normal, Qt::blue, false, QString::fromLatin1("(?<=\\[)[^\\[\\]]*(?=\\])"));
-    addTextCharFormat(QFont::Normal, Qt::blue, false, QString::fromLatin1("(?<=\\]\\()[^\\(\\)]*(?=\\))"));
+    rules.append(createRule(QFont::Normal, Qt::blue, false, QString::fromLatin1("(?<=\\[)[^\\[\\]]*(?=\\])")));
+    rules.append(createRule(QFont::Normal, Qt::blue, false, QString::fromLatin1("(?<=\\]\\()[^\\(\\)]*(?=\\))")));
     //blockquote
-    addTextCharFormat(QFont::Normal, Qt::darkGray, false, QString::fromLatin1("^\\s{0,3}>"));
+    rules.append(createRule(QFont::Normal, Qt::darkGray, false, QString::fromLatin1("^\\s{0,3}>")));
     //header
-    addTextCharFormat(QFont::Bold, Qt::darkMagenta, false, QString::fromLatin1("^#.*$"));
-    addTextCharFormat(QFont::Bold, Qt::darkMagenta, false, QString::fromLatin1("^==+$"));
+    rules.append(createRule(QFont::Bold, Qt::darkMagenta, false, QString::fromLatin1("^#.*$")));
+    rules.append(createRule(QFont::Bold, Qt::darkMagenta, false, QString::fromLatin1("^==+$")));
     //bullet
-    addTextCharFormat(QFont::Normal, Qt::darkRed, false, QString::fromLatin1("^[\\*\\+\\-]\\s"));
+    rules.append(createRule(QFont::Normal, Qt::darkRed, false, QString::fromLatin1("^[\\*\\+\\-]\\s")));
     //code
-    addTextCharFormat(QFont::Normal, Qt::darkBlue, false, QString::fromLatin1("^([\\s]{4,}|\\t+).*$"));
+    rules.append(createRule(QFont::Normal, Qt::darkBlue, false, QString::fromLatin1("^([\\s]{4,}|\\t+).*$")));
+    return rules;
 }
 
-MarkdownHighLighter::~MarkdownHighLighter()
+MarkdownScanHighLighter::MarkdownScanHighLighter(QTextDocument *parent) :
+    HighLighter(parent)
+{
+}
+
+const MarkdownScanHighLighter::Formats& MarkdownScanHighLighter::formats()
+{
+    //the same look as the rules of MarkdownHighLighter
+    static Formats f;
+    static bool initialized = false;
+    if(initialized)
+        return f;
+    initialized = true;
+    f.tag = createFormat(QFont::Bold, Qt::darkMagenta, false);
+    f.entity = createFormat(QFont::Bold, Qt::darkCyan, false);
+    f.quote = createFormat(QFont::Bold, Qt::darkYellow, false);
+    f.comment = createFormat(QFont::Bold, Qt::gray, false);
+    f.italic = createFormat(QFont::Normal, Qt::darkCyan, true);
+    f.bold = createFormat(QFont::Bold, Qt::darkCyan, false);
+    f.boldItalic = createFormat(QFont::Bold, Qt::darkCyan, true);
+    f.link = createFormat(QFont::Normal, Qt::blue, false);
+    f.blockquote = createFormat(QFont::Normal, Qt::darkGray, false);
+    f.header = createFormat(QFont::Bold, Qt::darkMagenta, false);
+    f.bullet = createFormat(QFont::Normal, Qt::darkRed, false);
+    f.code = createFormat(QFont::Normal, Qt::darkBlue, false);
+    return f;
+}
+
+void MarkdownScanHighLighter::highlightText(const QString &text)
+{
+    const Formats &f = formats();
+    const QChar *s = text.constData();
+    int len = text.length();
+    int state = previousBlockState();
+    setCurrentBlockState(Normal);
+
+    if(state==InBacktickFence || state==InTildeFence)
+    {
+        setFormat(0, len, f.code);
+        QChar fence = state==InBacktickFence ? QLatin1Char('`') : QLatin1Char('~');
+        int fenceEnd = fenceLength(text, fence);
+        bool closed = fenceEnd>0 && text.mid(fenceEnd).trimmed().isEmpty();
+        if(!closed)
+            setCurrentBlockState(state);
+        return;
+    }
+
+    int i = 0;
+    if(state==InHtmlComment)
+    {
+        int end = text.indexOf(QLatin1String("-->"));
+        if(end==-1)
+        {
+            setFormat(0, len, f.comment);
+            setCurrentBlockState(InHtmlComment);
+            return;
+        }
+        i = end+3;
+        setFormat(0, i, f.comment);
+    }
+    else
+    {
+        //constructs which take the whole line
+        bool backtickFence = fenceLength(text, QLatin1Char('`'))>0;
+        if(backtickFence || fenceLength(text, QLatin1Char('~'))>0)
+        {
+            setFormat(0, len, f.code);
+            setCurrentBlockState(backtickFence ? InBacktickFence : InTildeFence);
+            return;
+        }
+        int indent = 0;
+        while(indent<len && s[indent].isSpace())
+            indent++;
+        if(len>0 && (indent>=4 || s[0]==QLatin1Char('\t')))
+        {
+            setFormat(0, len, f.code);
+            return;
+        }
+        if(len>0 && s[0]==QLatin1Char('#'))
+        {
+            setFormat(0, len, f.header);
+            return;
+        }
+        if(len>=2)
+        {
+            int k = 0;
+            while(k<len && s[k]==QLatin1Char('='))
+                k++;
+            if(k==len)
+            {
+                setFormat(0, len, f.header);
+                return;
+            }
+        }
+        //line prefixes, the rest of the line is scanned below
+        if(indent<len && s[indent]==QLatin1Char('>'))
+        {
+            i = indent+1;
+            setFormat(0, i, f.blockquote);
+        }
+        else if(len>=2 && (s[0]==QLatin1Char('*') || s[0]==QLatin1Char('+') || s[0]==QLatin1Char('-'))
+                && s[1].isSpace())
+        {
+            i = 2;
+            setFormat(0, i, f.bullet);
+        }
+    }
+
+    while(i<len)
+    {
+        switch(s[i].unicode())
+        {
+            case '`':
+                i = highlightCodeSpan(text, i);
+                break;
+            case '<':
+                i = highlightAngle(text, i);
+                break;
+            case '&':
+                i = highlightEntity(text, i);
+                break;
+            case '*':
+            case '_':
+                i = highlightEmphasis(text, i);
+                break;
+            case '[':
+                i = highlightLink(text, i);
+                break;
+            default:
+                i++;
+                break;
+        }
+    }
+}
+
+//returns the position after the "```" or "~~~" of a fence line, 0 if it is not one
+int MarkdownScanHighLighter::fenceLength(const QString &text, QChar fence)
 {
+    int len = text.length();
+    int i = 0;
+    while(i<len && i<3 && text.at(i)==QLatin1Char(' '))
+        i++;
+    int start = i;
+    while(i<len && text.at(i)==fence)
+        i++;
+    return i-start>=3 ? i : 0;
+}
+
+int MarkdownScanHighLighter::highlightCodeSpan(const QString &text, int start)
+{
+    const QChar *s = text.constData();
+    int len = text.length();
+    int i = start;
+    while(i<len && s[i]==QLatin1Char('`'))
+        i++;
+    int ticks = i-start;
+    while(i<len)
+    {
+        if(s[i]!=QLatin1Char('`'))
+        {
+            i++;
+            continue;
+        }
+        int closeStart = i;
+        while(i<len && s[i]==QLatin1Char('`'))
+            i++;
+        if(i-closeStart==ticks)
+        {
+            setFormat(start, i-start, formats().code);
+            return i;
+        }
+    }
+    return start+ticks;
+}
+
+int MarkdownScanHighLighter::highlightAngle(const QString &text, int start)
+{
+    const Formats &f = formats();
+    const QChar *s = text.constData();
+    int len = text.length();
+    if(text.midRef(start, 4)==QLatin1String("<!--"))
+    {
+        int end = text.indexOf(QLatin1String("-->"), start+4);
+        if(end==-1)
+        {
+            setFormat(start, len-start, f.comment);
+            setCurrentBlockState(InHtmlComment);
+            return len;
+        }
+        setFormat(start, end+3-start, f.comment);
+        return end+3;
+    }
+    int i = start+1;
+    while(i<len && s[i]!=QLatin1Char('<') && s[i]!=QLatin1Char('>') && s[i]!=QLatin1Char('@'))
+        i++;
+    if(i>=len || s[i]!=QLatin1Char('>'))
+        return start+1;
+    setFormat(start, i+1-start, f.tag);
+    //quoted attribute values
+    for(int k=start+1; k<i; k++)
+    {
+        if(s[k]!=QLatin1Char('"'))
+            continue;
+        int quoteEnd = k+1;
+        while(quoteEnd<i && s[quoteEnd]!=QLatin1Char('"'))
+            quoteEnd++;
+        if(quoteEnd>=i)
+            break;
+        setFormat(k, quoteEnd+1-k, f.quote);
+        k = quoteEnd;
+    }
+    return i+1;
+}
+
+int MarkdownScanHighLighter::highlightEntity(const QString &text, int start)
+{
+    const QChar *s = text.constData();
+    int len = text.length();
+    int i = start+1;
+    while(i<len && s[i]!=QLatin1Char(';') && s[i]!=QLatin1Char(' '))
+        i++;
+    if(i>=len || s[i]!=QLatin1Char(';'))
+        return start+1;
+    setFormat(start, i+1-start, formats().entity);
+    return i+1;
+}
+
+static inline bool isEmphasisChar(QChar c)
+{
+    return c==QLatin1Char('*') || c==QLatin1Char('_');
+}
+
+static inline bool isEmphasisBoundary(QChar c)
+{
+    return c.isSpace() || c==QLatin1Char('.') || c==QLatin1Char(',') || c==QLatin1Char(';')
+            || c==QLatin1Char(':') || c==QLatin1Char('-') || c==QLatin1Char('?');
+}
+
+int MarkdownScanHighLighter::highlightEmphasis(const QString &text, int start)
+{
+    const Formats &f = formats();
+    const QChar *s = text.constData();
+    int len = text.length();
+    int i = start;
+    while(i<len && isEmphasisChar(s[i]))
+        i++;
+    int marks = i-start;
+    if(marks>3 || (start>0 && !s[start-1].isSpace()))
+        return i;
+    //at least two chars, the first one not a space
+    if(i>=len || s[i].isSpace())
+        return i;
+    int closeStart = i+1;
+    while(closeStart<len && !isEmphasisChar(s[closeStart]))
+        closeStart++;
+    if(closeStart==i+1 || closeStart>=len)
+        return i;
+    int end = closeStart;
+    while(end<len && isEmphasisChar(s[end]))
+        end++;
+    if(end-closeStart!=marks || (end<len && !isEmphasisBoundary(s[end])))
+        return i;
+    const QTextCharFormat &format = marks==1 ? f.italic : (marks==2 ? f.bold : f.boldItalic);
+    setFormat(start, end-start, format);
+    return end;
+}
+
+int MarkdownScanHighLighter::highlightLink(const QString &text, int start)
+{
+    const Formats &f = formats();
+    const QChar *s = text.constData();
+    int len = text.length();
+    int i = start+1;
+    while(i<len && s[i]!=QLatin1Char('[') && s[i]!=QLatin1Char(']'))
+        i++;
+    if(i>=len)
+        return start+1;
+    if(s[i]==QLatin1Char('['))
+        return i;
+    setFormat(start+1, i-start-1, f.link);
+    i++;
+    if(i>=len || s[i]!=QLatin1Char('('))
+        return i;
+    int urlEnd = i+1;
+    while(urlEnd<len && s[urlEnd]!=QLatin1Char('(') && s[urlEnd]!=QLatin1Char(')'))
+        urlEnd++;
+    if(urlEnd>=len || s[urlEnd]!=QLatin1Char(')'))
+        return i+1;
+    setFormat(i+1, urlEnd-i-1, f.link);
+    return urlEnd+1;
 }
 
 CSSHighLighter::CSSHighLighter(QTextDocument *parent) :
     HighLighter(parent)
 {
-    addTextCharFormat(QFont::Normal, Qt::red, false, QString::fromLatin1("-?[A-Za-z_-]+(?=\\s*:)"));
-    //id
-    addTextCharFormat(QFont::Normal, Qt::darkCyan, false, QString::fromLatin1("#([a-zA-Z0-9\\-_]|[\\x80-\\xFF]|\\\\[0-9A-Fa-f]{1,6})*"));
-    //class
-    addTextCharFormat(QFont::Normal, Qt::darkCyan, false, QString::fromLatin1("(?<= |^)\\.([a-zA-Z0-9\\-_]|[\\x80-\\xFF]|\\\\[0-9A-Fa-f]{1,6})*"));
-    //number
-    addTextCharFormat(QFont::Normal, Qt::darkBlue, false, QString::fromLatin1("(?<=:)[ 0-9.%]*"));
-    //value
-    addTextCharFormat(QFont::Normal, Qt::darkGreen, false, QString::fromLatin1("[-+]?[0-9.]+(em|ex|ch|rem|vw|vh|vm|px|in|cm|mm|pt|pc|deg|rad|grad|turn|ms|s|Hz|kHz)\\b"));
+    highlightingRules = sharedRules();
 
     commentsFormat.setForeground(Qt::darkGreen);
     commentsStart = QRegExp("/\\*");
     commentsEnd = QRegExp("\\*/");
 }
 
+const QVector<HighlightingRule>& CSSHighLighter::sharedRules()
+{
+    static QVector<HighlightingRule> rules;
+    if(!rules.isEmpty())
+        return rules;
+    rules.append(createRule(QFont::Normal, Qt::red, false, QString::fromLatin1("-?[A-Za-z_-]+(?=\\s*:)")));
+    //id
+    rules.append(createRule(QFont::Normal, Qt::darkCyan, false, QString::fromLatin1("#([a-zA-Z0-9\\-_]|[\\x80-\\xFF]|\\\\[0-9A-Fa-f]{1,6})*")));
+    //class
+    rules.append(createRule(QFont::Normal, Qt::darkCyan, false, QString::fromLatin1("(?<= |^)\\.([a-zA-Z0-9\\-_]|[\\x80-\\xFF]|\\\\[0-9A-Fa-f]{1,6})*")));
+    //number
+    rules.append(createRule(QFont::Normal, Qt::darkBlue, false, QString::fromLatin1("(?<=:)[ 0-9.%]*")));
+    //value
+    rules.append(createRule(QFont::Normal, Qt::darkGreen, false, QString::fromLatin1("[-+]?[0-9.]+(em|ex|ch|rem|vw|vh|vm|px|in|cm|mm|pt|pc|deg|rad|grad|turn|ms|s|Hz|kHz)\\b")));
+    return rules;
+}
+
 void CSSHighLighter::highlightMultiLine(const QString &text)
 {
     int startIndex = 0;
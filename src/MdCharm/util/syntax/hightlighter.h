@@ -2,16 +2,22 @@
 #define HIGHTLIGHTER_H
 
 #include <QSyntaxHighlighter>
+#include <QTextBlock>
+#include <QPointer>
+
+#include "util/test/qregularexpression.h"
 
 #ifdef QT_V5
 #include <QtWidgets>
 #endif
 
 class QTextDocument;
+class QPlainTextEdit;
+class QTimer;
 
 struct HighlightingRule
 {
-    QString pattern;
+    QRegularExpression pattern;
     QTextCharFormat format;
 };
 
@@ -21,13 +27,32 @@ class HighLighter : public QSyntaxHighlighter
 public:
     HighLighter(QTextDocument *parent);
     HighLighter(QTextEdit *parent);
-    void addTextCharFormat(const int weight, const QColor color, bool isItalic,
-                           const QString &regExp);
+    static QTextCharFormat createFormat(const int weight, const QColor color, bool isItalic);
+    static HighlightingRule createRule(const int weight, const QColor color, bool isItalic,
+                                       const QString &regExp);
+    void enableLazyHighlight(QPlainTextEdit *view);
 protected:
     virtual void highlightBlock(const QString &text);
+    virtual void highlightText(const QString &text);
     virtual void highlightMultiLine(const QString &text);
+private slots:
+    void updateVisibleBlocks();
+    void highlightPendingBlocks();
+private:
+    bool isVisibleBlock(int blockNumber) const;
+    void highlightPendingBlock(const QTextBlock &block);
 protected:
     QVector<HighlightingRule> highlightingRules;
+private:
+    //lazy mode, only the blocks around the viewport are highlighted at once
+    QPointer<QPlainTextEdit> lazyView;
+    QTimer *idleTimer;
+    QTextBlock forcedBlock;
+    int firstVisibleBlock;
+    int lastVisibleBlock;
+    int nextPendingBlock;
+    //blocks in a row the idle scan found highlighted, across slices
+    int highlightedRun;
 };
 
 class MarkdownHighLighter: public HighLighter
@@ -36,6 +61,53 @@ class MarkdownHighLighter: public HighLighter
 public:
     MarkdownHighLighter(QTextDocument *parent = 0);
     ~MarkdownHighLighter();
+private:
+    static const QVector<HighlightingRule>& sharedRules();
+};
+
+/*
+ * Highlights the same markdown constructs as MarkdownHighLighter, but with a
+ * hand-written scanner that walks every line once instead of running one
+ * regex per rule. Fenced code blocks and html comments can span lines, their
+ * state is kept in the block state.
+ */
+class MarkdownScanHighLighter: public HighLighter
+{
+    Q_OBJECT
+public:
+    MarkdownScanHighLighter(QTextDocument *parent = 0);
+protected:
+    virtual void highlightText(const QString &text);
+private:
+    enum BlockState
+    {
+        Normal = 0,
+        InBacktickFence,
+        InTildeFence,
+        InHtmlComment
+    };
+    struct Formats
+    {
+        QTextCharFormat tag;
+        QTextCharFormat entity;
+        QTextCharFormat quote;
+        QTextCharFormat comment;
+        QTextCharFormat italic;
+        QTextCharFormat bold;
+        QTextCharFormat boldItalic;
+        QTextCharFormat link;
+        QTextCharFormat blockquote;
+        QTextCharFormat header;
+        QTextCharFormat bullet;
+        QTextCharFormat code;
+    };
+    static const Formats& formats();
+    static int fenceLength(const QString &text, QChar fence);
+    int highlightCodeSpan(const QString &text, int start);
+    int highlightAngle(const QString &text, int start);
+    int highlightEntity(const QString &text, int start);
+    int highlightEmphasis(const QString &text, int start);
+    int highlightLink(const QString &text, int start);
 };
 
 class CSSHighLighter: public HighLighter
@@ -45,6 +117,8 @@ public:
     CSSHighLighter(QTextDocument *parent = 0);
 protected:
     virtual void highlightMultiLine(const QString &text);
+private:
+    static const QVector<HighlightingRule>& sharedRules();
 private:
     QTextCharFormat commentsFormat;
     QRegExp commentsStart;
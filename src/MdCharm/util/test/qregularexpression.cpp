@@ -60,7 +60,12 @@ struct QRegularExpressionPrivate : QSharedData
     void cleanCompiledPattern();
     void compilePattern();
     void getPatternInfo();
-    pcre16_extra *optimizePattern();
+
+    enum OptimizePatternOption {
+        LazyOptimizeOption,
+        ImmediateOptimizeOption
+    };
+    pcre16_extra *optimizePattern(OptimizePatternOption option);
 
     QRegularExpressionMatchPrivate *doMatch(const QString &subject,
                                             int offset,
@@ -357,13 +362,13 @@ static bool isJitEnabled()
     the memory pointed by studyData isn't. Therefore, the current studyData
     value is returned and used by doMatch.
 */
-pcre16_extra *QRegularExpressionPrivate::optimizePattern()
+pcre16_extra *QRegularExpressionPrivate::optimizePattern(OptimizePatternOption option)
 {
     Q_ASSERT(compiledPattern);
 
     QMutexLocker lock(&mutex);
 
-    if (studyData || (++usedCount != qt_qregularexpression_optimize_after_use_count))
+    if (studyData || ((option == LazyOptimizeOption) && (++usedCount != qt_qregularexpression_optimize_after_use_count)))
         return studyData;
 
     static const bool enableJit = isJitEnabled();
@@ -475,7 +480,7 @@ QRegularExpressionMatchPrivate *QRegularExpressionPrivate::doMatch(const QString
                                                                               capturingCount);
 
     // this is mutex protected
-    const pcre16_extra *currentStudyData = const_cast<QRegularExpressionPrivate *>(this)->optimizePattern();
+    const pcre16_extra *currentStudyData = const_cast<QRegularExpressionPrivate *>(this)->optimizePattern(LazyOptimizeOption);
 
     int pcreOptions = convertToPcreOptions(matchOptions);
 
@@ -760,6 +765,21 @@ bool QRegularExpression::isValid() const
     return d->compiledPattern;
 }
 
+/*!
+    Compiles the pattern immediately, including JIT compiling it (if the JIT is
+    enabled) for optimization, instead of waiting for it to be used a few
+    times. Use it for patterns that are created once and matched very often.
+
+    \sa isValid()
+*/
+void QRegularExpression::optimize() const
+{
+    if (!isValid()) // will compile the pattern
+        return;
+
+    d.data()->optimizePattern(QRegularExpressionPrivate::ImmediateOptimizeOption);
+}
+
 /*!
     Returns a textual description of the error found when checking the validity
     of the regular expression, or "no error" if no error was found.
@@ -90,6 +90,8 @@ public:
 
     int captureCount() const;
 
+    void optimize() const;
+
     enum MatchType {
         NormalMatch = 0,
         PartialPreferCompleteMatch,
@@ -13,6 +13,7 @@
 #include "configuration.h"
 #include "resource.h"
 #include "util/spellcheck/spellchecker.h"
+#include "util/spellcheck/spellcheckerloader.h"
 
 //------------------------ MdCharmGlobal ---------------------------------------
 
@@ -72,6 +73,9 @@ MdCharmGlobal::MdCharmGlobal()
 
 MdCharmGlobal::~MdCharmGlobal()
 {
+    foreach (SpellCheckerLoader *loader, spellCheckerLoaders.values()) {
+        delete loader;//waits for it
+    }
     foreach (SpellChecker *sc, spellCheckerManager.values()) {
         delete sc;
     }
@@ -79,7 +83,7 @@ MdCharmGlobal::~MdCharmGlobal()
 
 bool MdCharmGlobal::loadSpellCheck(const QString &lan)
 {
-    if(spellCheckerManager.contains(lan)){
+    if(spellCheckerManager.contains(lan) || spellCheckerLoaders.contains(lan)){
        return true;
     }
     if(conf->isCheckSpell() &&
@@ -89,7 +93,13 @@ bool MdCharmGlobal::loadSpellCheck(const QString &lan)
         QString filePath = conf->getLanguageSpellCheckDictPath(lan);
         if(!filePath.isEmpty()){
             QString withoutSuffixFilePath = filePath.left(filePath.lastIndexOf('.'));
-            spellCheckerManager[lan] = new SpellChecker(withoutSuffixFilePath, conf->getLanguageSpellCheckUserDictPath(), lan);
+            SpellCheckerLoader *loader = new SpellCheckerLoader(withoutSuffixFilePath,
+                                                                conf->getLanguageSpellCheckUserDictPath(),
+                                                                conf->getLanguageSpellCheckCachePath(lan),
+                                                                lan, this);
+            connect(loader, SIGNAL(finished()), this, SLOT(spellCheckerLoaded()));
+            spellCheckerLoaders[lan] = loader;
+            loader->start(QThread::LowPriority);
             return true;
         } else {
             conf->setCheckSpell(false);
@@ -109,9 +119,23 @@ SpellChecker* MdCharmGlobal::getSpellChecker(const QString &lan)
         return spellCheckerManager.value(lan);
     if(spellCheckerLanguageList.indexOf(lan)==-1)
         return NULL;
-    if(!loadSpellCheck(lan))
-        return NULL;
-    return spellCheckerManager.value(lan);
+    loadSpellCheck(lan);
+    return NULL;
+}
+
+void MdCharmGlobal::spellCheckerLoaded()
+{
+    SpellCheckerLoader *loader = qobject_cast<SpellCheckerLoader *>(sender());
+    if(!loader)
+        return;
+    QString lan = loader->getLan();
+    SpellChecker *sc = loader->takeSpellChecker();
+    spellCheckerLoaders.remove(lan);
+    loader->deleteLater();
+    if(!sc)
+        return;
+    spellCheckerManager[lan] = sc;
+    emit spellCheckerReady(lan);
 }
 
 QStringList MdCharmGlobal::getSpellCheckerLanguageList()
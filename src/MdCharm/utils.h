@@ -12,6 +12,7 @@
 #include "markdowntohtml.h"
 
 class SpellChecker;
+class SpellCheckerLoader;
 class Configuration;
 
 class MdCharmGlobal : public QWidget
@@ -56,6 +57,11 @@ public:
         WriteRead,
         ReadMode
     };
+    enum MarkdownHighlighter
+    {
+        RuleHighlighter,//one regex pass per rule
+        ScanHighlighter//single pass scanner
+    };
 
     enum Shortcuts
     {
@@ -129,18 +135,32 @@ private:
     static MdCharmGlobal *instance;
     Configuration *conf;
     QMap<QString, SpellChecker*> spellCheckerManager;
+    QMap<QString, SpellCheckerLoader*> spellCheckerLoaders;
     QStringList spellCheckerLanguageList;
     QMap<QString, QString> cacheSpellCheckDictLocaleName;
 private:
     MdCharmGlobal();
     ~MdCharmGlobal();
-    bool loadSpellCheck(const QString &lan);
 public:
     static MdCharmGlobal *getInstance();
+    /**
+     * @brief Starts loading the dictionary of lan on a worker thread, unless
+     * it is loaded or being loaded already.
+     * @return false if there is no dictionary for lan
+     */
+    bool loadSpellCheck(const QString &lan);
+    /**
+     * @brief The spell checker of lan, or NULL while its dictionary is still
+     * loading. Never blocks: spellCheckerReady() is emitted once it is usable.
+     */
     SpellChecker* getSpellChecker(const QString &lan);
     QStringList getSpellCheckerLanguageList();
     QString getDictLocaleName(const QString &dictName);
     QString getShortDescriptionText(int s);
+signals:
+    void spellCheckerReady(const QString &lan);
+private slots:
+    void spellCheckerLoaded();
 };
 
 class Utils
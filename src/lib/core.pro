@@ -44,12 +44,25 @@ HEADERS += \
     core/markdowntohtml.h \
     core/languagedefinationxmlparser.h \
     core/highlighter.h \
-    core/codesyntaxhighlighter.h
+    core/codesyntaxhighlighter.h \
+    core/blockrenderer.h \
+    core/highlightbatch.h \
+    core/markdownrenderer.h \
+    core/markdownoutline.h \
+    core/outline.h \
+    core/rendercache.h \
+    core/timingprofiler.h
 
 SOURCES += \
     core/markdowntohtml.cpp \
     core/languagedefinationxmlparser.cpp \
     core/highlighter.cpp \
-    core/codesyntaxhighlighter.cpp
+    core/codesyntaxhighlighter.cpp \
+    core/blockrenderer.cpp \
+    core/highlightbatch.cpp \
+    core/markdownrenderer.cpp \
+    core/markdownoutline.cpp \
+    core/rendercache.cpp \
+    core/timingprofiler.cpp
 
 
@@ -0,0 +1,362 @@
+#include "blockrenderer.h"
+#include "markdown.h"
+#include "html.h"
+#include "buffer.h"
+#include "rendercache.h"
+#include "timingprofiler.h"
+
+using namespace std;
+
+namespace {
+static const char *BLOCK_ID_PREFIX = "mdcharm-block-";
+}
+
+MarkdownBlockRenderer::MarkdownBlockRenderer()
+{
+    markdown = NULL;
+    callbacks = new sd_callbacks;
+    options = new html_renderopt;
+    work = bufnew(MarkdownToHtml::OUTPUT_UNIT);
+    type = MarkdownToHtml::PHPMarkdownExtra;
+    valid = false;
+    definitionsHash = 0;
+    nextId = 1;
+}
+
+MarkdownBlockRenderer::~MarkdownBlockRenderer()
+{
+    if(markdown)
+        sd_markdown_free(markdown);
+    bufrelease(work);
+    delete callbacks;
+    delete options;
+}
+
+/**
+ * @brief MarkdownBlockRenderer::invalidate Forget the last render, the next
+ *        call of render() returns a full render.
+ */
+void MarkdownBlockRenderer::invalidate()
+{
+    valid = false;
+    text.clear();
+    blocks.clear();
+    outline.clear();
+}
+
+string MarkdownBlockRenderer::blockElementId(unsigned int id)
+{
+    char number[16];
+    sprintf(number, "%u", id);
+    return string(BLOCK_ID_PREFIX).append(number);
+}
+
+void MarkdownBlockRenderer::resetMarkdown(MarkdownToHtml::MarkdownType type)
+{
+    if(markdown)
+        sd_markdown_free(markdown);
+    sdhtml_renderer(callbacks, options, HTML_TOC);
+    options->highlight_batch = &highlightBatch;
+    options->outline = &blockOutline;
+    markdown = sd_markdown_new(MarkdownToHtml::extensionFlags(type), 16, callbacks, options);
+    this->type = type;
+    invalidate();
+}
+
+/**
+ * @brief MarkdownBlockRenderer::render Render data, reusing the blocks of the
+ *        last render that the edit did not touch.
+ * @return FullRender -> outHtml is the whole body
+ * @return PatchRender -> patch describes how to update the last body
+ * @return NoChange -> the output is the same as the last render
+ * @return Cancelled -> canceller stopped the render, the last render is kept
+ */
+MarkdownBlockRenderer::RenderResult
+MarkdownBlockRenderer::render(MarkdownToHtml::MarkdownType type,
+                              const char *data, const int length,
+                              string &outHtml, Patch &patch,
+                              const RenderCanceller *canceller)
+{
+    outHtml.clear();
+    patch.removedIds.clear();
+    patch.afterId = 0;
+    patch.insertedHtml.clear();
+    if(type==MarkdownToHtml::MultiMarkdown){
+        //MultiMarkdown has no block level api, always render the whole document
+        invalidate();
+        if(length>0 && !RenderCache::instance()->find(type, data, length, outHtml, outline)){
+            MarkdownToHtml::translateMultiMarkdownToHtml(type, data, length, outHtml);
+            //it has no header callback, read them from its html
+            outline.addHtmlHeaders(outHtml.data(), outHtml.size());
+            RenderCache::instance()->insert(type, data, length, outHtml.data(), outHtml.size(), outline);
+        }
+        return FullRender;
+    }
+    if(!markdown || type!=this->type)
+        resetMarkdown(type);
+    if(!markdown)
+        return NoChange;
+    highlightBatch.clear();
+    options->highlight_batch = HighlightBatch::canBatch(data, length) ? &highlightBatch : NULL;
+
+    buf *newText = bufnew(64);
+    if(!newText)
+        return NoChange;
+    unsigned int hash = sd_markdown_prepare(newText, (const uint8_t *)data, length, markdown);
+    //footnote numbers depend on the whole document, so do the definitions of
+    //references, render everything again when they may have changed
+    bool hasFootnotes = sd_markdown_has_footnotes(markdown);
+    RenderResult result;
+    if(!valid || hasFootnotes || hash!=definitionsHash){
+        PROFILE_SCOPE("render.sundownAll");
+        result = renderAll(newText, outHtml, canceller);
+    } else {
+        PROFILE_SCOPE("render.sundownChanged");
+        result = renderChanged(newText, outHtml, patch, canceller);
+    }
+
+    if(result==Cancelled){
+        sd_markdown_finish(NULL, markdown);
+        bufrelease(newText);
+        outHtml.clear();
+        patch.removedIds.clear();
+        patch.afterId = 0;
+        patch.insertedHtml.clear();
+        return Cancelled;
+    }
+    if(result==FullRender){
+        work->size = 0;
+        sd_markdown_finish(work, markdown);
+        highlightBatch.run();
+        highlightBatch.splice((const char *)work->data, work->size, outHtml);
+    } else {
+        sd_markdown_finish(NULL, markdown);
+    }
+    if(result!=NoChange)
+        buildOutline();
+    text.assign((const char *)newText->data, newText->size);
+    definitionsHash = hash;
+    valid = true;
+    bufrelease(newText);
+    return result;
+}
+
+MarkdownBlockRenderer::RenderResult
+MarkdownBlockRenderer::renderAll(const buf *newText, string &outHtml,
+                                 const RenderCanceller *canceller)
+{
+    vector<Block> rendered;
+    options->toc_data.header_count = 0;
+    //also called when a patch render gives up, drop the code it queued
+    highlightBatch.clear();
+    size_t offset = 0;
+    while(offset<newText->size){
+        if(canceller && canceller->isCancelled())
+            return Cancelled;
+        Block block;
+        renderBlock(newText, offset, block);
+        offset += block.size;
+        rendered.push_back(block);
+    }
+    highlightBlocks(rendered);
+    for(size_t i=0; i<rendered.size(); i++)
+        appendBlockHtml(outHtml, rendered[i]);
+    blocks.swap(rendered);
+    return FullRender;
+}
+
+MarkdownBlockRenderer::RenderResult
+MarkdownBlockRenderer::renderChanged(const buf *newText, string &outHtml, Patch &patch,
+                                     const RenderCanceller *canceller)
+{
+    const char *oldData = text.data();
+    const char *newData = (const char *)newText->data;
+    const size_t oldLen = text.size();
+    const size_t newLen = newText->size;
+    const size_t minLen = oldLen < newLen ? oldLen : newLen;
+
+    size_t prefix = 0;
+    while(prefix<minLen && oldData[prefix]==newData[prefix])
+        prefix++;
+    if(prefix==oldLen && oldLen==newLen)
+        return NoChange;
+    size_t suffix = 0;
+    while(suffix<minLen-prefix && oldData[oldLen-1-suffix]==newData[newLen-1-suffix])
+        suffix++;
+    const size_t oldChangeEnd = oldLen-suffix;
+    const size_t newChangeEnd = newLen-suffix;
+
+    //the first block reaching into the changed text
+    size_t first = 0;
+    while(first<blocks.size() && blocks[first].offset+blocks[first].size<=prefix)
+        first++;
+    //the block before it looked at the first line of the changed one to find
+    //where it stops, so render it again too
+    size_t restart = first;
+    if(restart>0){
+        do {
+            restart--;
+        } while(restart>0 && blocks[restart].id==0);
+    }
+    //blocks which searched up to the end of the document may stop elsewhere now
+    for(size_t i=0; i<restart; i++){
+        if(blocks[i].unbounded){
+            restart = i;
+            break;
+        }
+    }
+
+    int headerCount = 0;
+    for(size_t i=0; i<restart; i++)
+        headerCount += blocks[i].headerCount;
+    options->toc_data.header_count = headerCount;
+
+    //render until the parser is back at the start of an unchanged old block
+    vector<Block> rendered;
+    size_t offset = restart<blocks.size() ? blocks[restart].offset : 0;
+    size_t resync = blocks.size();
+    size_t old = restart;
+    while(offset<newLen){
+        if(canceller && canceller->isCancelled())
+            return Cancelled;
+        if(offset>=newChangeEnd){
+            while(old<blocks.size() && blocks[old].offset+newLen<offset+oldLen)
+                old++;
+            if(old<blocks.size() && blocks[old].offset>=oldChangeEnd &&
+                    blocks[old].offset+newLen==offset+oldLen){
+                resync = old;
+                break;
+            }
+        }
+        Block block;
+        renderBlock(newText, offset, block);
+        offset += block.size;
+        rendered.push_back(block);
+    }
+
+    //header ids are numbered through the document, the following headers
+    //would keep stale ids if the number of headers changed
+    int oldHeaders = 0, newHeaders = 0, followingHeaders = 0;
+    for(size_t i=restart; i<resync; i++)
+        oldHeaders += blocks[i].headerCount;
+    for(size_t i=0; i<rendered.size(); i++)
+        newHeaders += rendered[i].headerCount;
+    for(size_t i=resync; i<blocks.size(); i++)
+        followingHeaders += blocks[i].headerCount;
+    if(oldHeaders!=newHeaders && followingHeaders>0)
+        return renderAll(newText, outHtml, canceller);
+
+    highlightBlocks(rendered);
+    for(size_t i=0; i<restart; i++){
+        if(blocks[i].id)
+            patch.afterId = blocks[i].id;
+    }
+    for(size_t i=restart; i<resync; i++){
+        if(blocks[i].id)
+            patch.removedIds.push_back(blocks[i].id);
+    }
+    for(size_t i=0; i<rendered.size(); i++)
+        appendBlockHtml(patch.insertedHtml, rendered[i]);
+
+    vector<Block> following(blocks.begin()+resync, blocks.end());
+    blocks.erase(blocks.begin()+restart, blocks.end());
+    blocks.insert(blocks.end(), rendered.begin(), rendered.end());
+    for(size_t i=0; i<following.size(); i++){
+        following[i].offset = following[i].offset+newLen-oldLen;
+        blocks.push_back(following[i]);
+    }
+    return PatchRender;
+}
+
+void MarkdownBlockRenderer::renderBlock(const buf *newText, size_t offset, Block &block)
+{
+    int unbounded = 0;
+    int headersBefore = options->toc_data.header_count;
+    work->size = 0;
+    blockOutline.clear();
+    block.offset = offset;
+    block.size = sd_markdown_render_block(work, newText->data+offset, newText->size-offset,
+                                          markdown, &unbounded);
+    block.unbounded = unbounded!=0;
+    block.headerCount = options->toc_data.header_count-headersBefore;
+    block.html.assign((const char *)work->data, work->size);
+    block.id = block.html.empty() ? 0 : nextId++;
+
+    const char *blockData = (const char *)newText->data+offset;
+    block.lineCount = MarkdownOutline::countLines(blockData, block.size);
+    block.headers.clear();
+    block.headerOffsets.clear();
+    //sundown recorded the same headers, the last ones are this block's
+    size_t recorded = sd_markdown_header_count(markdown);
+    bool matched = recorded>=blockOutline.size();
+    size_t first = matched ? recorded-blockOutline.size() : 0;
+    for(size_t i=0; i<blockOutline.size(); i++){
+        MarkdownOutline::Header header = blockOutline.at(i);
+        size_t headerOffset = matched ? sd_markdown_header_offset(markdown, first+i,
+                                                                 newText->data+offset, block.size)
+                                      : (size_t)-1;
+        if(headerOffset!=(size_t)-1)
+            header.line = (int)MarkdownOutline::countLines(blockData, headerOffset);
+        block.headers.push_back(header);
+        block.headerOffsets.push_back(headerOffset);
+    }
+}
+
+/**
+ * @brief MarkdownBlockRenderer::buildOutline Collect the headers of all
+ *        blocks, with their lines in the document.
+ */
+void MarkdownBlockRenderer::buildOutline()
+{
+    PROFILE_SCOPE("render.outline");
+    outline.clear();
+    size_t line = 0;
+    for(size_t i=0; i<blocks.size(); i++){
+        const Block &block = blocks[i];
+        for(size_t j=0; j<block.headers.size(); j++){
+            MarkdownOutline::Header header = block.headers[j];
+            if(block.headerOffsets[j]!=(size_t)-1)
+                header.line = (int)sd_markdown_source_line(markdown, block.offset+block.headerOffsets[j],
+                                                           line+header.line);
+            outline.addHeader(header);
+        }
+        line += block.lineCount;
+    }
+}
+
+/**
+ * @brief MarkdownBlockRenderer::getOutline The headers of the last render
+ *        which was not cancelled.
+ */
+const MarkdownOutline& MarkdownBlockRenderer::getOutline() const
+{
+    return outline;
+}
+
+/**
+ * @brief MarkdownBlockRenderer::highlightBlocks Highlight the fenced code the
+ *        rendered blocks queued and put it in place of their placeholders.
+ */
+void MarkdownBlockRenderer::highlightBlocks(vector<Block> &rendered)
+{
+    if(highlightBatch.isEmpty())
+        return;
+    highlightBatch.run();
+    string html;
+    for(size_t i=0; i<rendered.size(); i++){
+        html.clear();
+        highlightBatch.splice(rendered[i].html.data(), rendered[i].html.size(), html);
+        rendered[i].html.swap(html);
+    }
+}
+
+void MarkdownBlockRenderer::appendBlockHtml(string &outHtml, const Block &block)
+{
+    if(!block.id)
+        return;
+    outHtml.append("<div class=\"mdcharm-block\" id=\"")
+            .append(blockElementId(block.id))
+            .append("\">")
+            .append(block.html)
+            .append("</div>");
+}
@@ -0,0 +1,100 @@
+#ifndef BLOCKRENDERER_H
+#define BLOCKRENDERER_H
+
+#include <string>
+#include <vector>
+
+#include "markdowntohtml.h"
+#include "highlightbatch.h"
+#include "markdownoutline.h"
+
+struct sd_markdown;
+struct sd_callbacks;
+struct html_renderopt;
+struct buf;
+
+/**
+ * @brief Asked between two blocks whether a running render should stop.
+ */
+class RenderCanceller
+{
+public:
+    virtual ~RenderCanceller() {}
+    virtual bool isCancelled() const = 0;
+};
+
+/**
+ * @brief Renders markdown one top-level block at a time and remembers the
+ *        blocks of the last render, so that an edit only re-renders the
+ *        blocks it touched. Every block with output is wrapped in an element
+ *        with a stable id, the caller patches those elements in the preview.
+ */
+class MarkdownBlockRenderer
+{
+public:
+    enum RenderResult {
+        NoChange,
+        FullRender,
+        PatchRender,
+        Cancelled
+    };
+
+    struct Block
+    {
+        size_t offset;//offset in the prepared text
+        size_t size;
+        unsigned int id;//0 -> the block has no output
+        int headerCount;
+        bool unbounded;
+        std::string html;
+        size_t lineCount;
+        std::vector<MarkdownOutline::Header> headers;//line is the line in the block
+        std::vector<size_t> headerOffsets;//offset in the block, -1 if nested
+    };
+
+    struct Patch
+    {
+        std::vector<unsigned int> removedIds;
+        unsigned int afterId;//0 -> insert at the beginning of body
+        std::string insertedHtml;
+    };
+
+public:
+    MarkdownBlockRenderer();
+    ~MarkdownBlockRenderer();
+    void invalidate();
+    RenderResult render(MarkdownToHtml::MarkdownType type,
+                        const char *data, const int length,
+                        std::string &outHtml, Patch &patch,
+                        const RenderCanceller *canceller=NULL);
+    const MarkdownOutline& getOutline() const;
+    static std::string blockElementId(unsigned int id);
+private:
+    MarkdownBlockRenderer(const MarkdownBlockRenderer &);
+    void operator=(const MarkdownBlockRenderer &);
+    void resetMarkdown(MarkdownToHtml::MarkdownType type);
+    RenderResult renderAll(const buf *newText, std::string &outHtml,
+                           const RenderCanceller *canceller);
+    RenderResult renderChanged(const buf *newText, std::string &outHtml, Patch &patch,
+                               const RenderCanceller *canceller);
+    void renderBlock(const buf *newText, size_t offset, Block &block);
+    void highlightBlocks(std::vector<Block> &rendered);
+    void appendBlockHtml(std::string &outHtml, const Block &block);
+    void buildOutline();
+private:
+    sd_markdown *markdown;
+    sd_callbacks *callbacks;
+    html_renderopt *options;
+    buf *work;
+    HighlightBatch highlightBatch;
+    MarkdownOutline blockOutline;//headers of the block being rendered
+    MarkdownOutline outline;
+    MarkdownToHtml::MarkdownType type;
+    bool valid;
+    unsigned int definitionsHash;
+    unsigned int nextId;
+    std::string text;
+    std::vector<Block> blocks;
+};
+
+#endif // BLOCKRENDERER_H
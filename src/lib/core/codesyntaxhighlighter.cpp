@@ -1,5 +1,6 @@
 #include "codesyntaxhighlighter.h"
 #include "languagedefinationxmlparser.h"
+#include "buffer.h"
 
 using namespace std;
 
@@ -40,6 +41,16 @@ Language* LanguageManager::getLanguage(const string &name)
     return (*it).second;
 }
 
+int LanguageManager::getPatternCount()
+{
+    return RegExp::getCompiledCount();
+}
+
+int LanguageManager::getJitPatternCount()
+{
+    return RegExp::getJitCompiledCount();
+}
+
 LanguageManager* LanguageManager::getInstance()
 {
     if(!instance)
@@ -49,89 +60,89 @@ LanguageManager* LanguageManager::getInstance()
 
 CodeSyntaxHighlighter::CodeSyntaxHighlighter()
 {
+    ob = NULL;
+    subHighlighter = NULL;
     relevance = 0;
     top = NULL;
 }
 
-const string& CodeSyntaxHighlighter::highlight(const char *name, int len, const char *code, int codeLen)
+CodeSyntaxHighlighter::~CodeSyntaxHighlighter()
+{
+    delete subHighlighter;
+}
+
+void CodeSyntaxHighlighter::highlight(struct buf *ob, const char *name, int len, const char *code, int codeLen)
 {
     LanguageManager *lanManger = LanguageManager::getInstance();
     Language *targetLanguage = lanManger->getLanguage(string(name, len));
     if(!targetLanguage){
-        result = escape(code, codeLen);
-        return result;
+        this->ob = ob;
+        escape(code, codeLen);
+        return;
     }
-    return highlight(targetLanguage, code, codeLen);
+    highlight(ob, targetLanguage, code, codeLen);
 }
 
-const string& CodeSyntaxHighlighter::highlight(Language *lan, const char *code, int len)
+void CodeSyntaxHighlighter::highlight(struct buf *ob, Language *lan, const char *code, int len)
 {
-    result.clear();
+    this->ob = ob;
     modeBuffer.clear();
     while(!parentStack.empty())
         parentStack.pop();
+    runParents.clear();
     top = NULL;
     this->lan = lan;
     relevance = 0;
     int index = 0;
+    //convert the code once, every terminator search below runs against it
+    codeSubject.assign(code, len);
     while(true){
-        FindResult fr;
-        if(top){
-            top->getTerminatorsRe().setLastIndex(index);
-            fr = top->getTerminatorsRe().exec(code, len);
-        } else {
-            lan->getTerminatorsRe().setLastIndex(index);
-            fr = lan->getTerminatorsRe().exec(code, len);
-        }
+        FindResult fr = top ? top->getTerminatorsRe().exec(codeSubject, index)
+                            : lan->getTerminatorsRe().exec(codeSubject, index);
         if(!fr.isValid())
             break;
-        string match(code+fr.start, fr.end-fr.start);
-        int count = processLexem(string(code+index, fr.start-index), &match);
+        int count = processLexem(code+index, fr.start-index, code+fr.start, fr.end-fr.start);
         index = fr.start+count;
     }
-    string left(code+index, len-index);
-    processLexem(left);
+    processLexem(code+index, len-index);
     while(!parentStack.empty()){
-        result.append("</span>");
+        bufputs(ob, "</span>");
         parentStack.pop();
     }
-//    printf("%s\n", result.c_str());
-    return result;
 }
 
-int CodeSyntaxHighlighter::processLexem(const string &subCode, const string *matchCode)
+int CodeSyntaxHighlighter::processLexem(const char *subCode, int subLen, const char *matchCode, int matchLen)
 {
-//    printf("subCode: %s\n", subCode.c_str());
-//    printf("matchCode: %s\n", matchCode->c_str());
-//    return 0;
-    modeBuffer += subCode;
+    modeBuffer.append(subCode, subLen);
     if(matchCode==NULL){
-        result += processBuffer();
+        processBuffer();
         return 0;
     }
+    matchSubject.assign(matchCode, matchLen);
     Contain* con = NULL;
     if(top){
-        con = top->findMatchedContain(*matchCode);
+        if(!isStarts(top))
+            con = top->findMatchedContain(matchSubject);
         if(!con && top->isRefLanguageContains())
-            con = lan->findMatchedContain(*matchCode);
+            con = lan->findMatchedContain(matchSubject);
     } else {
-        con = lan->findMatchedContain(*matchCode);
+        con = lan->findMatchedContain(matchSubject);
     }
     if(con){
-        result += processBuffer();
-        processMatch(con, *matchCode);
-        return con->isReturnBegin() ? 0 : matchCode->length();
+        processBuffer();
+        processMatch(con, matchCode, matchLen);
+        return con->isReturnBegin() ? 0 : matchLen;
     }
 
-    Contain *endContain = findEndContain(top, *matchCode);
+    Contain *endContain = findEndContain(top);
     if(endContain){
         if(!(endContain->isReturnEnd()||endContain->isExcludeEnd())){
-            modeBuffer += *matchCode;
+            modeBuffer.append(matchCode, matchLen);
         }
-        result += processBuffer();
-        while(top!=endContain->getParent() && top){
+        processBuffer();
+        while(top!=getParent(endContain) && top){
             if(top->isShowClassName())
-                result += "</span>";
+                bufputs(ob, "</span>");
             if(!parentStack.empty()){
                 top = parentStack.top();
                 parentStack.pop();
@@ -139,172 +150,187 @@ int CodeSyntaxHighlighter::processLexem(const string &subCode, const string *mat
                 top = NULL;
             }
         }
-//        if(parentStack.empty())
-//            top = NULL;
         if(endContain->isExcludeEnd()){
-            result += escape(matchCode->c_str(), matchCode->length());
+            escape(matchCode, matchLen);
         }
         modeBuffer.clear();
         if(endContain->getStarts())
-            processMatch(endContain->getStarts(), "");
-        return endContain->isReturnEnd() ? 0 : matchCode->length();
+            processMatch(endContain->getStarts(), "", 0);
+        return endContain->isReturnEnd() ? 0 : matchLen;
     }
-    modeBuffer += *matchCode;
-    return matchCode->length()>0 ? matchCode->length() : 1;
+    modeBuffer.append(matchCode, matchLen);
+    return matchLen>0 ? matchLen : 1;
 }
 
-string CodeSyntaxHighlighter::processBuffer()
+void CodeSyntaxHighlighter::processBuffer()
 {
     //language no sub language
-    if(top)
-        return top->isHaveSubLanguage() ? processSubLanguage(top) : processKeywords(top);
-    else
-        return processKeywords();
+    if(top){
+        if(top->isHaveSubLanguage())
+            processSubLanguage(top);
+        else
+            processKeywords(top);
+    } else {
+        processKeywords();
+    }
 }
 
-string CodeSyntaxHighlighter::processKeywords()
+void CodeSyntaxHighlighter::processKeywords()
 {
-    string buffer = escape(modeBuffer.c_str(), modeBuffer.length());
     if(lan->getKeywords().empty())
-        return buffer;
-    string keywordResult;
-    int lastIndex = 0;
-    lan->getLexemsRe().setLastIndex(0);
-    FindResult fr = lan->getLexemsRe().exec(buffer.c_str(), buffer.length());
-    while(fr.isValid()){
-        keywordResult.append(buffer.substr(lastIndex, fr.start-lastIndex));
-        string keyword = buffer.substr(fr.start, fr.end-fr.start);
-        int km = keywordMatch(keyword);
-        if(km!=Keywords::NotFound){
-            keywordResult.append("<span class=\"")
-                    .append(Keywords::getKeyTypeString(km))
-                    .append("\">")
-                    .append(keyword)
-                    .append("</span>");
-        } else {
-            keywordResult.append(keyword);
-        }
-        lastIndex = lan->getLexemsRe().getLastIndex();
-        fr = lan->getLexemsRe().exec(buffer.c_str(), buffer.length());
-    }
-    return keywordResult + buffer.substr(lastIndex);
+        escape(modeBuffer.c_str(), modeBuffer.length());
+    else
+        highlightKeywords(lan->getLexemsRe(), NULL);
 }
 
-string CodeSyntaxHighlighter::processKeywords(Contain *contain)
+void CodeSyntaxHighlighter::processKeywords(Contain *contain)
 {
-    string buffer = escape(modeBuffer.c_str(), modeBuffer.length());
     if(contain->getKeywords().empty()&&!contain->isRefLanguageKeywords())
-        return buffer;
-    string keywordResult;
+        escape(modeBuffer.c_str(), modeBuffer.length());
+    else
+        highlightKeywords(contain->getLexemsRe(), contain);
+}
+
+void CodeSyntaxHighlighter::highlightKeywords(RegExp &lexemsRe, Contain *contain)
+{
+    //lexems are searched in the raw buffer, which is converted only once,
+    //and every piece is escaped when it is written
+    const char *buffer = modeBuffer.c_str();
+    bufferSubject.assign(buffer, modeBuffer.length());
     int lastIndex = 0;
-    contain->getLexemsRe().setLastIndex(0);
-    FindResult fr = contain->getLexemsRe().exec(buffer.c_str(), buffer.length());
+    FindResult fr = lexemsRe.exec(bufferSubject, 0);
     while(fr.isValid()){
-        keywordResult.append(buffer.substr(lastIndex, fr.start-lastIndex));
-        string keyword = buffer.substr(fr.start, fr.end-fr.start);
-        int km = keywordMatch(keyword, contain);
+        escape(buffer+lastIndex, fr.start-lastIndex);
+        const char *keyword = buffer+fr.start;
+        int keywordLen = fr.end-fr.start;
+        int km = keywordMatch(keyword, keywordLen, contain);
         if(km!=Keywords::NotFound){
-            keywordResult.append("<span class=\"")
-                    .append(Keywords::getKeyTypeString(km))
-                    .append("\">")
-                    .append(keyword)
-                    .append("</span>");
+            bufputs(ob, "<span class=\"");
+            bufputs(ob, Keywords::getKeyTypeString(km));
+            bufputs(ob, "\">");
+            escape(keyword, keywordLen);
+            bufputs(ob, "</span>");
         } else {
-            keywordResult.append(keyword);
+            escape(keyword, keywordLen);
         }
-        lastIndex = contain->getLexemsRe().getLastIndex();
-        fr = contain->getLexemsRe().exec(buffer.c_str(), buffer.length());
+        lastIndex = fr.end;
+        fr = lexemsRe.exec(bufferSubject, lastIndex);
     }
-    return keywordResult + buffer.substr(lastIndex);
+    escape(buffer+lastIndex, modeBuffer.length()-lastIndex);
 }
 
-string CodeSyntaxHighlighter::processSubLanguage(Contain *top)
+void CodeSyntaxHighlighter::processSubLanguage(Contain *top)
 {
-    CodeSyntaxHighlighter *subHighlighter = new CodeSyntaxHighlighter;
     LanguageManager *languageManager = LanguageManager::getInstance();
     Language* sub = languageManager->getLanguage(top->getSubLanguage());
-    if(!sub)
-        return escape(modeBuffer.c_str(), modeBuffer.length());
-    string r = "<span class=\""+top->getSubLanguage()+"\">";
-    r += subHighlighter->highlight(sub, modeBuffer.c_str(), modeBuffer.length());
-    r += "</span>";
-    delete subHighlighter;
-    return r;
+    if(!sub){
+        escape(modeBuffer.c_str(), modeBuffer.length());
+        return;
+    }
+    if(!subHighlighter)
+        subHighlighter = new CodeSyntaxHighlighter;
+    const string &subLanguage = top->getSubLanguage();
+    bufputs(ob, "<span class=\"");
+    bufput(ob, subLanguage.c_str(), subLanguage.length());
+    bufputs(ob, "\">");
+    subHighlighter->highlight(ob, sub, modeBuffer.c_str(), modeBuffer.length());
+    bufputs(ob, "</span>");
 }
 
-void CodeSyntaxHighlighter::processMatch(Contain *contain, const string &match)
+void CodeSyntaxHighlighter::processMatch(Contain *contain, const char *match, int matchLen)
 {
-    string markup;
-    if(contain->isShowClassName())
-        markup.append("<span class=\"").append(contain->getRealName()).append("\">");
-    if(contain->isReturnBegin()){
-        result += markup;
-        modeBuffer.clear();
-    } else if (contain->isExcludeBegin()){
-        result += escape(match.c_str(), match.length()) + markup;
-        modeBuffer.clear();
-    } else {
-        result += markup;
-        modeBuffer = match;
+    const string &className = contain->getRealName();
+    if(contain->isExcludeBegin() && !contain->isReturnBegin())
+        escape(match, matchLen);
+    if(contain->isShowClassName()){
+        bufputs(ob, "<span class=\"");
+        bufput(ob, className.c_str(), className.length());
+        bufputs(ob, "\">");
     }
-    //TODO: top = Object.create(mode, {parent: {value: top}});
-//    parentStack.push(contain);
+    if(contain->isReturnBegin() || contain->isExcludeBegin())
+        modeBuffer.clear();
+    else
+        modeBuffer.assign(match, matchLen);
+    //top = Object.create(mode, {parent: {value: top}}), kept in this run only
     if(top){
-        contain->setParent(top);
+        setParent(contain, top);
         parentStack.push(top);
     }
     top = contain;
     relevance += contain->getRelevance();
 }
 
-int CodeSyntaxHighlighter::keywordMatch(const string &match, Contain *contain)
+int CodeSyntaxHighlighter::keywordMatch(const char *match, int len, Contain *contain)
 {
-    string matchStr(match);
-    if(!lan->isCaseSensitive()){//to lower case if not case sensitive
-        for(unsigned int i=0;i<match.length(); i++){
-            matchStr[i]=tolower(match[i]);
-        }
-    }
-    return (contain&&!contain->isRefLanguageKeywords()) ? contain->matchKeyword(matchStr) : lan->matchKeyword(matchStr);
+    //the keyword tables fold the case themselves if the language is not case sensitive
+    return (contain&&!contain->isRefLanguageKeywords()) ? contain->matchKeyword(match, len) : lan->matchKeyword(match, len);
 }
 
-Contain* CodeSyntaxHighlighter::findEndContain(Contain *contain, const string &match)
+//the end regexes are tested against the current match
+Contain* CodeSyntaxHighlighter::findEndContain(Contain *contain)
 {
     if(!contain)
         return NULL;
-    if(!contain->getEnd().empty() && contain->getEndRe().test(match.c_str(), match.length())){
+    if(!contain->getEnd().empty() && contain->getEndRe().test(matchSubject)){
         return contain;
     }
     if(contain->isEndWithParent()){
-        return findEndContain(contain->getParent(), match);
+        return findEndContain(getParent(contain));
     }
     return NULL;
 }
 
-string CodeSyntaxHighlighter::escape(const char* src, int len)
+//a contain gets the contain it was entered from as parent for the rest of the
+//run, until then the parent from the language definition is used
+Contain* CodeSyntaxHighlighter::parentOf(Contain *contain)
+{
+    for(size_t i=0; i<runParents.size(); i++){
+        if(runParents[i].first==contain)
+            return runParents[i].second;
+    }
+    return contain->getDefinedParent();
+}
+
+void CodeSyntaxHighlighter::setParent(Contain *contain, Contain *parent)
+{
+    for(size_t i=0; i<runParents.size(); i++){
+        if(runParents[i].first==contain){
+            runParents[i].second = parent;
+            return;
+        }
+    }
+    runParents.push_back(make_pair(contain, parent));
+}
+
+Contain* CodeSyntaxHighlighter::getParent(Contain *contain)
+{
+    Contain *parent = parentOf(contain);
+    if(parent && parent->getStarts() && parent->getStarts()==contain)
+        return getParent(parent);
+    return parent;
+}
+
+bool CodeSyntaxHighlighter::isStarts(Contain *contain)
+{
+    Contain *parent = parentOf(contain);
+    return parent && parent->getStarts() && parent->getStarts()==contain;
+}
+
+void CodeSyntaxHighlighter::escape(const char* src, int len)
 {
-    string result;
-    if(len==0)
-        return result;
-    result.resize(len*2);
-    result.resize(0);
     int index=0;
     for(int i=0; i<len; i++){
-        if(src[i]=='&'){
-            result.append(src+index, i-index);
-            result.append("&amp;");
-            index = i+1;
-        } else if(src[i]=='<'){
-            result.append(src+index, i-index);
-            result.append("&lt;");
-            index = i+1;
-        } else if(src[i]=='>'){
-            result.append(src+index, i-index);
-            result.append("&gt;");
-            index = i+1;
+        const char *entity;
+        switch(src[i]){
+            case '&': entity = "&amp;"; break;
+            case '<': entity = "&lt;"; break;
+            case '>': entity = "&gt;"; break;
+            default: continue;
         }
+        bufput(ob, src+index, i-index);
+        bufputs(ob, entity);
+        index = i+1;
     }
     if(len>index)
-        result.append(src+index, len-index);
-    return result;
+        bufput(ob, src+index, len-index);
 }
@@ -4,6 +4,9 @@
 #include <map>
 #include <string>
 #include <stack>
+#include <vector>
+
+#include "languagedefinationxmlparser.h"
 
 #ifdef MARKDOWN_LIB
     #include "../../dllglobal.h"
@@ -11,9 +14,7 @@
     #define AS_DYNAMIC_LIB
 #endif
 
-class Language;
-class Contain;
-struct StackItem;
+struct buf;
 
 class AS_DYNAMIC_LIB LanguageManager
 {
@@ -21,6 +22,8 @@ public:
     ~LanguageManager();
     void addLanguage(const std::string &name, char *content);
     Language* getLanguage(const std::string &name);
+    int getPatternCount();
+    int getJitPatternCount();
     static LanguageManager* getInstance();
 private:
     LanguageManager();
@@ -29,30 +32,49 @@ private:
     static LanguageManager *instance;
 };
 
+/*
+ * Writes the highlighted html straight into a sundown buffer. The mode buffer
+ * and the regex subjects are members which keep their capacity, so no heap
+ * allocation is needed per lexeme once they have grown.
+ *
+ * The languages are only read while highlighting, all state of a run lives in
+ * the highlighter, so different highlighters can run on different threads.
+ */
 class CodeSyntaxHighlighter
 {
 public:
     CodeSyntaxHighlighter();
-    const std::string& highlight(const char *name, int len, const char *code, int codeLen);
-    const std::string& highlight(Language* lan, const char *code, int len);
+    ~CodeSyntaxHighlighter();
+    void highlight(struct buf *ob, const char *name, int len, const char *code, int codeLen);
+    void highlight(struct buf *ob, Language* lan, const char *code, int len);
 private:
-    int processLexem(const std::string &subCode, const std::string *matchCode=NULL);
-    std::string processBuffer();
-    std::string processKeywords();
-    std::string processKeywords(Contain *contain);
-    std::string processSubLanguage(Contain *top);
-
-    void processMatch(Contain* contain, const std::string& match);
-    int keywordMatch(const std::string &match, Contain *contain=NULL);
-    std::string escape(const char *src, int len);
-    Contain* findEndContain(Contain *contain, const std::string& match);
+    int processLexem(const char *subCode, int subLen, const char *matchCode=NULL, int matchLen=0);
+    void processBuffer();
+    void processKeywords();
+    void processKeywords(Contain *contain);
+    void highlightKeywords(RegExp &lexemsRe, Contain *contain);
+    void processSubLanguage(Contain *top);
+
+    void processMatch(Contain* contain, const char *match, int matchLen);
+    int keywordMatch(const char *match, int len, Contain *contain=NULL);
+    void escape(const char *src, int len);
+    Contain* findEndContain(Contain *contain);
+    Contain* parentOf(Contain *contain);
+    void setParent(Contain *contain, Contain *parent);
+    Contain* getParent(Contain *contain);
+    bool isStarts(Contain *contain);
 private:
-    std::string result;
+    struct buf *ob;
     std::string modeBuffer;
+    RegExpSubject codeSubject;
+    RegExpSubject matchSubject;
+    RegExpSubject bufferSubject;
+    CodeSyntaxHighlighter *subHighlighter;
     Language *lan;
     Contain* top;
     int relevance;
     std::stack<Contain *> parentStack;
+    std::vector<std::pair<Contain *, Contain *> > runParents;//contain -> parent of this run
 };
 
 #endif // CODESYNTAXHIGHLIGHTER_H
@@ -0,0 +1,153 @@
+#include <string.h>
+
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include "highlightbatch.h"
+#include "codesyntaxhighlighter.h"
+#include "markdowntohtml.h"
+#include "buffer.h"
+#include "timingprofiler.h"
+
+using namespace std;
+
+namespace {
+//the placeholder is "\x02<index>\x03". sundown copies control characters of
+//the document into the html as they are, so the placeholders are only used
+//for documents without PLACEHOLDER_START, see canBatch()
+const char PLACEHOLDER_START = '\x02';
+const char PLACEHOLDER_END = '\x03';
+
+//shared with the pool threads, a worker which is started after all jobs were
+//taken finds nothing to do and does not touch the jobs any more
+struct HighlightTasks
+{
+    HighlightTasks(HighlightBatch::Job *jobs, int count) :
+        jobs(jobs), count(count), next(0) {}
+    HighlightBatch::Job *jobs;
+    int count;
+    QAtomicInt next;
+    QSemaphore finished;
+};
+
+void highlightJobs(HighlightTasks *tasks)
+{
+    CodeSyntaxHighlighter highlighter;
+    buf *ob = NULL;
+    int i;
+    while((i = tasks->next.fetchAndAddOrdered(1))<tasks->count){
+        if(!ob)
+            ob = bufnew(MarkdownToHtml::OUTPUT_UNIT);
+        ob->size = 0;
+        HighlightBatch::Job &job = tasks->jobs[i];
+        highlighter.highlight(ob, job.name.c_str(), job.name.length(),
+                              job.code.c_str(), job.code.length());
+        job.html.assign((const char *)ob->data, ob->size);
+        tasks->finished.release();
+    }
+    if(ob)
+        bufrelease(ob);
+}
+
+class HighlightRunnable : public QRunnable
+{
+public:
+    HighlightRunnable(const QSharedPointer<HighlightTasks> &tasks) : tasks(tasks) {}
+    void run() { highlightJobs(tasks.data()); }
+private:
+    QSharedPointer<HighlightTasks> tasks;
+};
+}
+
+HighlightBatch::HighlightBatch()
+{
+    count = 0;
+    highlighted = 0;
+    spliced = 0;
+}
+
+void HighlightBatch::add(struct buf *ob, const char *name, int len, const char *code, int codeLen)
+{
+    //name may point into ob, copy it before writing the placeholder
+    if(count==jobs.size())
+        jobs.push_back(Job());
+    Job &job = jobs[count];
+    job.name.assign(name, len);
+    job.code.assign(code, codeLen);
+    bufprintf(ob, "%c%u%c", PLACEHOLDER_START, (unsigned int)count, PLACEHOLDER_END);
+    count++;
+}
+
+/**
+ * @brief HighlightBatch::run Highlight the blocks added since the last run.
+ *        The calling thread takes jobs too, so the batch finishes even when
+ *        the pool has no free thread.
+ */
+void HighlightBatch::run()
+{
+    if(highlighted>=count)
+        return;
+    PROFILE_SCOPE("render.highlightCode");
+    QSharedPointer<HighlightTasks> tasks(new HighlightTasks(&jobs[highlighted], count-highlighted));
+    int workers = qMin(tasks->count-1, QThreadPool::globalInstance()->maxThreadCount());
+    for(int i=0; i<workers; i++)
+        QThreadPool::globalInstance()->start(new HighlightRunnable(tasks));
+    highlightJobs(tasks.data());
+    tasks->finished.acquire(tasks->count);
+    highlighted = count;
+}
+
+/**
+ * @brief HighlightBatch::splice Append html to outHtml, replacing the
+ *        placeholders by the highlighted blocks. The html of one render may
+ *        be spliced in several pieces, as long as they come in order.
+ */
+void HighlightBatch::splice(const char *html, size_t size, string &outHtml)
+{
+    const char *end = html+size;
+    const char *p = html;
+    while(p<end){
+        const char *start = (const char *)memchr(p, PLACEHOLDER_START, end-p);
+        if(!start)
+            break;
+        const char *digit = start+1;
+        size_t index = 0;
+        while(digit<end && *digit>='0' && *digit<='9')
+            index = index*10+(*digit++-'0');
+        if(digit<end && *digit==PLACEHOLDER_END && digit>start+1
+                && index==spliced && index<highlighted){
+            outHtml.append(p, start-p);
+            outHtml.append(jobs[index].html);
+            spliced++;
+            p = digit+1;
+        } else {
+            outHtml.append(p, start+1-p);
+            p = start+1;
+        }
+    }
+    outHtml.append(p, end-p);
+}
+
+void HighlightBatch::clear()
+{
+    count = 0;
+    highlighted = 0;
+    spliced = 0;
+}
+
+bool HighlightBatch::isEmpty() const
+{
+    return count==0;
+}
+
+/**
+ * @brief HighlightBatch::canBatch Whether the html of data can hold
+ *        placeholders: no text of the document can pass for one.
+ */
+bool HighlightBatch::canBatch(const char *data, size_t length)
+{
+    return !memchr(data, PLACEHOLDER_START, length);
+}
@@ -0,0 +1,44 @@
+#ifndef HIGHLIGHTBATCH_H
+#define HIGHLIGHTBATCH_H
+
+#include <string>
+#include <vector>
+
+struct buf;
+
+/**
+ * @brief Collects the fenced code blocks of a render. The renderer writes a
+ *        placeholder instead of the highlighted code, run() highlights all
+ *        blocks at once on the global thread pool and splice() replaces the
+ *        placeholders with the results, in the order they were added.
+ *        Documents for which canBatch() is false highlight their code inline.
+ */
+class HighlightBatch
+{
+public:
+    struct Job
+    {
+        std::string name;
+        std::string code;
+        std::string html;
+    };
+
+public:
+    HighlightBatch();
+    void add(struct buf *ob, const char *name, int len, const char *code, int codeLen);
+    void run();
+    void splice(const char *html, size_t size, std::string &outHtml);
+    void clear();
+    bool isEmpty() const;
+    static bool canBatch(const char *data, size_t length);
+private:
+    HighlightBatch(const HighlightBatch &);
+    void operator=(const HighlightBatch &);
+private:
+    std::vector<Job> jobs;//kept by clear(), their strings are reused
+    size_t count;
+    size_t highlighted;//jobs before it are done
+    size_t spliced;//the next placeholder expected by splice
+};
+
+#endif // HIGHLIGHTBATCH_H
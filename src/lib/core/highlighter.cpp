@@ -2,6 +2,7 @@
 #include <stdio.h>
 
 #include "codesyntaxhighlighter.h"
+#include "highlightbatch.h"
 #include "highlighter.h"
 #include "buffer.h"
 
@@ -10,6 +11,10 @@ using namespace std;
 void highlighter(struct buf *ob, const char *name, int len, const char *code, int codeLen)
 {
     CodeSyntaxHighlighter highlighter;
-    const string& result = highlighter.highlight(name, len, code, codeLen);
-    bufput(ob, (const void*)result.c_str(), result.length());
+    highlighter.highlight(ob, name, len, code, codeLen);
+}
+
+void highlighter_batch_add(void *batch, struct buf *ob, const char *name, int len, const char *code, int codeLen)
+{
+    static_cast<HighlightBatch *>(batch)->add(ob, name, len, code, codeLen);
 }
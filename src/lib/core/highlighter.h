@@ -8,6 +8,7 @@ extern "C" {
 #endif
 
 void highlighter(struct buf *ob, const char *name, int len, const char *code, int codeLen);
+void highlighter_batch_add(void *batch, struct buf *ob, const char *name, int len, const char *code, int codeLen);
 
 #ifdef __cplusplus
 }
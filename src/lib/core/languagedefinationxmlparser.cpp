@@ -1,17 +1,131 @@
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 #include <cassert>
 #include <stdio.h>
-#include <QString>
+#include <QThreadStorage>
 
 #include "languagedefinationxmlparser.h"
 
 using namespace std;
 using namespace rapidxml;
+
+namespace {
+//pcre's default jit stack is 32K on the machine stack, which the larger
+//terminator regexes can exceed, so every highlighting thread gets its own
+class JitStack
+{
+public:
+    JitStack() { stack = pcre16_jit_stack_alloc(32*1024, 512*1024); }
+    ~JitStack() { if(stack) pcre16_jit_stack_free(stack); }
+    pcre16_jit_stack *stack;
+};
+
+QThreadStorage<JitStack *> jitStacks;
+
+pcre16_jit_stack* jitStackForCurrentThread(void *)
+{
+    if(!jitStacks.hasLocalData())
+        jitStacks.setLocalData(new JitStack);
+    return jitStacks.localData()->stack;//NULL falls back to the machine stack
+}
+}
+//--------------------------- RegExpSubject ------------------------------------
+RegExpSubject::RegExpSubject()
+{
+    assign("", 0);
+}
+
+RegExpSubject::RegExpSubject(const char *code, int len)
+{
+    assign(code, len);
+}
+
+void RegExpSubject::assign(const char *code, int len)
+{
+    const unsigned char *s = (const unsigned char *)code;
+    text.clear();
+    utf8Offsets.clear();
+    text.reserve(len+1);
+    utf8Offsets.reserve(len+1);
+    utf16Offsets.resize(len+1);
+    int i = 0;
+    while(i<len){
+        unsigned int c = s[i];
+        unsigned int cp = 0xFFFD;
+        int seqLen = 1;
+        int need = 0;
+        unsigned int min = 0;
+        if(c<0x80){
+            cp = c;
+        } else if(c>=0xC2 && c<=0xDF){
+            need = 1; cp = c&0x1F; min = 0x80;
+        } else if(c>=0xE0 && c<=0xEF){
+            need = 2; cp = c&0x0F; min = 0x800;
+        } else if(c>=0xF0 && c<=0xF4){
+            need = 3; cp = c&0x07; min = 0x10000;
+        }
+        if(need){
+            int j = 1;
+            for(; j<=need && i+j<len && (s[i+j]&0xC0)==0x80; j++)
+                cp = (cp<<6)|(s[i+j]&0x3F);
+            if(j<=need || cp<min || cp>0x10FFFF || (cp>=0xD800 && cp<=0xDFFF))
+                cp = 0xFFFD;//invalid sequence, replace the lead byte only
+            else
+                seqLen = need+1;
+        }
+        for(int k=0; k<seqLen; k++)
+            utf16Offsets[i+k] = text.size();
+        if(cp>=0x10000){
+            cp -= 0x10000;
+            text.push_back(0xD800+(cp>>10));
+            utf8Offsets.push_back(i);
+            text.push_back(0xDC00+(cp&0x3FF));
+        } else {
+            text.push_back(cp);
+        }
+        utf8Offsets.push_back(i);
+        i += seqLen;
+    }
+    utf16Offsets[len] = text.size();
+    utf8Offsets.push_back(len);
+    text.push_back(0);
+}
+
+const unsigned short* RegExpSubject::utf16() const
+{
+    return &text[0];
+}
+
+int RegExpSubject::utf16Length() const
+{
+    return text.size()-1;
+}
+
+int RegExpSubject::utf8Length() const
+{
+    return utf16Offsets.size()-1;
+}
+
+int RegExpSubject::toUtf16(int utf8Index) const
+{
+    return utf16Offsets[utf8Index];
+}
+
+int RegExpSubject::toUtf8(int utf16Index) const
+{
+    return utf8Offsets[utf16Index];
+}
+
 //------------------------------ RegExp ----------------------------------------
+int RegExp::compiledCount = 0;
+int RegExp::jitCompiledCount = 0;
+
 RegExp::RegExp()
 {
     re = NULL;
-    lastIndex = 0;
+    extra = NULL;
+    jit = false;
 }
 
 bool RegExp::compile(const string &pattern, bool isCaseSensitive, bool isGlobal)
@@ -22,59 +136,95 @@ bool RegExp::compile(const string &pattern, bool isCaseSensitive, bool isGlobal)
     if(!isCaseSensitive){
         option |= PCRE_CASELESS;
     }
-    QString realPattern = QString::fromUtf8(pattern.c_str(), pattern.length());
+    RegExpSubject realPattern(pattern.c_str(), pattern.length());
     re = pcre16_compile(realPattern.utf16(), option, &error, &errorOffset, NULL);
     assert(re);
     global = isGlobal;
-    return re ? true : false;
+    if(!re)
+        return false;
+    compiledCount++;
+    //without jit support study still returns the interpreter's start-up data
+    extra = pcre16_study(re, PCRE_STUDY_JIT_COMPILE, &error);
+    int jitInfo = 0;
+    if(extra && pcre16_fullinfo(re, extra, PCRE_INFO_JIT, &jitInfo)==0 && jitInfo){
+        jit = true;
+        jitCompiledCount++;
+        pcre16_assign_jit_stack(extra, jitStackForCurrentThread, NULL);
+    }
+    return true;
+}
+
+int RegExp::match(const RegExpSubject &subject, int start, int *ovector, int ovecSize) const
+{
+    int rc = pcre16_exec(re, extra, subject.utf16(), subject.utf16Length(), start, 0, ovector, ovecSize);
+    if(rc==PCRE_ERROR_JIT_STACKLIMIT)//retry with the interpreter
+        rc = pcre16_exec(re, NULL, subject.utf16(), subject.utf16Length(), start, 0, ovector, ovecSize);
+    return rc;
 }
 
-FindResult RegExp::exec(const char *code, int len)
+FindResult RegExp::exec(const RegExpSubject &subject, int lastIndex) const
 {
     if(!re)
         return FindResult();
-    if(global && lastIndex>=len)
+    if(global && lastIndex>=subject.utf8Length())
         return FindResult();
+    int start = global ? subject.toUtf16(lastIndex) : 0;
     int spce[21];
-    memset(spce, 0, 21);
-    QString realCode = QString::fromUtf8(code, len);
-    int rc = pcre16_exec(re, NULL, realCode.utf16(), len, global ? lastIndex : 0, 0, spce, 21);
+    int rc = match(subject, start, spce, 21);
     if(rc<0)
         return FindResult();
     else {
-        FindResult fr(spce[0], spce[1]);
-        lastIndex = spce[1];
-        return fr;
+        return FindResult(subject.toUtf8(spce[0]), subject.toUtf8(spce[1]));
     }
 }
 
-bool RegExp::test(const char *code, int len)
+FindResult RegExp::exec(const char *code, int len, int lastIndex) const
+{
+    if(!re)
+        return FindResult();
+    if(global && lastIndex>=len)
+        return FindResult();
+    RegExpSubject subject(code, len);
+    return exec(subject, lastIndex);
+}
+
+bool RegExp::test(const RegExpSubject &subject) const
 {
     int spec[21];
-    memset(spec, 0, 21);
-    QString realCode = QString::fromUtf8(code, len);
-    int rc = pcre16_exec(re, NULL, realCode.utf16(), len, 0, 0, spec, 21);
+    int rc = match(subject, 0, spec, 21);
     return rc>=0;
 }
 
+bool RegExp::test(const char *code, int len) const
+{
+    RegExpSubject subject(code, len);
+    return test(subject);
+}
 
-int RegExp::getLastIndex() const
+bool RegExp::isValid() const
 {
-    return lastIndex;
+    return re ? true : false;
 }
 
-void RegExp::setLastIndex(int index)
+bool RegExp::isJitCompiled() const
 {
-    lastIndex = index;
+    return jit;
 }
 
-bool RegExp::isValid() const
+int RegExp::getCompiledCount()
 {
-    return re ? true : false;
+    return compiledCount;
+}
+
+int RegExp::getJitCompiledCount()
+{
+    return jitCompiledCount;
 }
 
 RegExp::~RegExp()
 {
+    if(extra)
+        pcre16_free_study(extra);
     if(re)
         pcre16_free(re);
 }
@@ -109,6 +259,90 @@ const char* Keywords::getKeyTypeString(int kt)
     return errorTexts[kt];
 }
 
+//---------------------------- KeywordTable ------------------------------------
+KeywordTable::KeywordTable()
+{
+    mask = 0;
+    caseSensitive = true;
+}
+
+void KeywordTable::build(const list<Keywords> &keywords, bool isCaseSensitive)
+{
+    caseSensitive = isCaseSensitive;
+    entries.clear();
+    slots.clear();
+    unsigned int size = 8;
+    while(size<keywords.size()*2)
+        size <<= 1;
+    mask = size-1;
+    slots.resize(size, -1);
+    entries.reserve(keywords.size());
+    for(list<Keywords>::const_iterator it=keywords.begin(); it!=keywords.end(); it++){
+        Keywords kw = *it;
+        Entry e;
+        e.keyword = kw.getKeyword();
+        if(!caseSensitive){
+            for(unsigned int i=0; i<e.keyword.length(); i++)
+                e.keyword[i] = tolower(e.keyword[i]);
+        }
+        e.hash = hash(e.keyword.c_str(), e.keyword.length());
+        e.type = kw.getType();
+        unsigned int slot = e.hash&mask;
+        bool duplicate = false;
+        while(slots[slot]!=-1){
+            const Entry &other = entries[slots[slot]];
+            if(other.hash==e.hash && other.keyword==e.keyword){
+                duplicate = true;//the first definition wins, as in the list
+                break;
+            }
+            slot = (slot+1)&mask;
+        }
+        if(duplicate)
+            continue;
+        slots[slot] = entries.size();
+        entries.push_back(e);
+    }
+}
+
+int KeywordTable::find(const char *k, int len) const
+{
+    if(entries.empty())
+        return Keywords::NotFound;
+    unsigned int h = hash(k, len);
+    unsigned int slot = h&mask;
+    while(slots[slot]!=-1){
+        const Entry &e = entries[slots[slot]];
+        if(e.hash==h && equals(e.keyword, k, len))
+            return e.type;
+        slot = (slot+1)&mask;
+    }
+    return Keywords::NotFound;
+}
+
+unsigned int KeywordTable::hash(const char *k, int len) const
+{
+    //FNV-1a
+    unsigned int h = 2166136261u;
+    for(int i=0; i<len; i++){
+        unsigned char c = caseSensitive ? k[i] : tolower((unsigned char)k[i]);
+        h = (h^c)*16777619u;
+    }
+    return h;
+}
+
+bool KeywordTable::equals(const string &keyword, const char *k, int len) const
+{
+    if((int)keyword.length()!=len)
+        return false;
+    if(caseSensitive)
+        return memcmp(keyword.c_str(), k, len)==0;
+    for(int i=0; i<len; i++){
+        if(keyword[i]!=tolower((unsigned char)k[i]))
+            return false;
+    }
+    return true;
+}
+
 //---------------------------- HighlightUtli -----------------------------------
 string HighlighterUtil::joinKeywords(list<Keywords> keywords, char sep)
 {
@@ -220,7 +454,7 @@ void Contain::setSubLanugage(const char * subLanguage)
     this->subLanguage = subLanguage;
 }
 
-const string Contain::getSubLanguage()
+const string& Contain::getSubLanguage()
 {
     return subLanguage;
 }
@@ -228,6 +462,7 @@ const string Contain::getSubLanguage()
 void Contain::setName(const string &name)
 {
     this->name = name;
+    realName = name.substr(0, name.find_first_of('|'));
 }
 
 const char *Contain::getName()
@@ -235,10 +470,9 @@ const char *Contain::getName()
     return name.c_str();
 }
 
-std::string Contain::getRealName()
+const std::string& Contain::getRealName()
 {
-//    return name;
-    return name.substr(0, name.find_first_of('|'));
+    return realName;
 }
 
 void Contain::setBegin(const string &begin)
@@ -291,6 +525,7 @@ void Contain::addRefContain(Contain *contain)
 
 void Contain::compile(Language *lan)
 {
+    keywordTable.build(keywords, lan->isCaseSensitive());
     if(keywords.size()>0 || refLanguageKeywords)
         if(!lexems.empty())
             lexemsRe.compile(lexems, lan->isCaseSensitive(), true);
@@ -341,17 +576,13 @@ void Contain::compile(Language *lan)
         terminatorsRe.compile(HighlighterUtil::joinStrings(terminators, '|'), true, true);
 }
 
-Contain* Contain::findMatchedContain(const string &match)
+//the caller has to skip a contain which is the starts of its running parent
+Contain* Contain::findMatchedContain(const RegExpSubject &match)
 {
-    if(parent && parent->getStarts() && parent->getStarts()==this)
-        return NULL;
     for(list<Contain *>::iterator it=refContains.begin(); it!=refContains.end(); it++){
         Contain *contain = *it;
-        if(contain->getBeginRe().isValid()){
-            FindResult fr = contain->getBeginRe().exec(match.c_str(), match.length());
-            if(fr.isValid())
-                return contain;
-        }
+        if(contain->getBeginRe().isValid() && contain->getBeginRe().test(match))
+            return contain;
     }
     return NULL;
 }
@@ -398,6 +629,11 @@ Contain* Contain::getParent()
     return parent;
 }
 
+Contain* Contain::getDefinedParent()
+{
+    return parent;
+}
+
 const string& Contain::getTerminatorEnd()
 {
     return terminatorEnd;
@@ -442,13 +678,9 @@ const std::list<Keywords>& Contain::getKeywords()
     return keywords;
 }
 
-int Contain::matchKeyword(const string &k)
+int Contain::matchKeyword(const char *k, int len)
 {
-    for(list<Keywords>::iterator it=keywords.begin(); it!=keywords.end(); it++){
-        if(it->getKeyword()==k)
-            return it->getType();
-    }
-    return Keywords::NotFound;
+    return keywordTable.find(k, len);
 }
 
 void Contain::setStarts(Contain *contain)
@@ -558,13 +790,9 @@ const list<Keywords>& Language::getKeywords()
     return keywords;
 }
 
-int Language::matchKeyword(const string &k)
+int Language::matchKeyword(const char *k, int len)
 {
-    for(list<Keywords>::iterator it=keywords.begin(); it!=keywords.end(); it++){
-        if(it->getKeyword()==k)
-            return it->getType();
-    }
-    return Keywords::NotFound;
+    return keywordTable.find(k, len);
 }
 
 Contain *Language::findRefContain(const char *name)
@@ -576,15 +804,12 @@ Contain *Language::findRefContain(const char *name)
     return NULL;
 }
 
-Contain *Language::findMatchedContain(const string &match)
+Contain *Language::findMatchedContain(const RegExpSubject &match)
 {
     for(list<Contain *>::reverse_iterator it=contains.rbegin(); it!=contains.rend(); it++){
         Contain *contain = *it;
-        if(contain->getBeginRe().isValid() && !contain->isRef()){
-            FindResult fr = contain->getBeginRe().exec(match.c_str(), match.length());
-            if(fr.isValid())
-                return contain;
-        }
+        if(contain->getBeginRe().isValid() && !contain->isRef() && contain->getBeginRe().test(match))
+            return contain;
     }
     return NULL;
 }
@@ -593,6 +818,7 @@ void Language::printDebugInfo()
 {
     printf("-----------------------Debug Info------------------------------\n");
     printf("keywords number: %d\n", keywords.size());
+    printf("jit compiled patterns: %d/%d\n", RegExp::getJitCompiledCount(), RegExp::getCompiledCount());
     for(list<Contain *>::iterator it=contains.begin(); it!=contains.end(); it++){
         printf("name: %s\n", (*it)->getName());
     }
@@ -608,6 +834,7 @@ void Language::compileLanguage()
     if(compiled)
         return;
     compiled = true;
+    keywordTable.build(keywords, caseSensitive);
     if(keywords.size()>0){
         if(!lexems.empty()){
             lexemsRe.compile(lexems, caseSensitive, true);
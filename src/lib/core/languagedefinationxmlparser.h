@@ -3,8 +3,7 @@
 
 #include <string>
 #include <list>
-
-#include <QtXml/QDomDocument>
+#include <vector>
 
 #include "rapidxml.hpp"
 #include "pcre.h"
@@ -37,23 +36,56 @@ struct FindResult
     int end;
 };
 
+/*
+ * An utf8 text converted to utf16 once, so that pcre16 can run any number of
+ * regexes against it. It keeps the offset maps between the two encodings,
+ * callers pass and get utf8 byte offsets only. assign() reuses the buffers.
+ */
+class RegExpSubject
+{
+public:
+    RegExpSubject();
+    RegExpSubject(const char *code, int len);
+    void assign(const char *code, int len);
+    const unsigned short* utf16() const;
+    int utf16Length() const;
+    int utf8Length() const;
+    int toUtf16(int utf8Index) const;
+    int toUtf8(int utf16Index) const;
+private:
+    DISALLOW_COPY_AND_ASSIGN(RegExpSubject);
+private:
+    std::vector<unsigned short> text;//null terminated
+    std::vector<int> utf16Offsets;//utf8 byte -> utf16 index, len+1 items
+    std::vector<int> utf8Offsets;//utf16 index -> utf8 byte, utf16Length+1 items
+};
+
 class RegExp
 {
 public:
     RegExp();
     bool compile(const std::string &pattern, bool isCaseSensitive, bool isGlobal=false);
-    FindResult exec(const char* code, int len);
-    bool test(const char*code, int len);
-    int getLastIndex() const;
-    void setLastIndex(int index);
+    //a global regexp starts searching at lastIndex (an utf8 offset); the
+    //regexp itself keeps no search state, so it can be shared by threads
+    FindResult exec(const RegExpSubject &subject, int lastIndex=0) const;
+    FindResult exec(const char* code, int len, int lastIndex=0) const;
+    bool test(const RegExpSubject &subject) const;
+    bool test(const char*code, int len) const;
     bool isValid() const;
+    bool isJitCompiled() const;
+    static int getCompiledCount();
+    static int getJitCompiledCount();
     ~RegExp();
 private:
     DISALLOW_COPY_AND_ASSIGN(RegExp);
+    int match(const RegExpSubject &subject, int start, int *ovector, int ovecSize) const;
 private:
     pcre16* re;
+    pcre16_extra *extra;
+    bool jit;
     bool global;
-    int lastIndex;
+    static int compiledCount;
+    static int jitCompiledCount;
 };
 
 class Keywords
@@ -81,6 +113,34 @@ private:
     std::string k;
 };
 
+/*
+ * Open addressing hash table from keyword to Keywords::KeywordsType, built
+ * once when the language is compiled. For case insensitive languages the
+ * keywords are folded to lower case when inserted and while hashing a lookup,
+ * so a lookup never allocates.
+ */
+class KeywordTable
+{
+public:
+    KeywordTable();
+    void build(const std::list<Keywords> &keywords, bool isCaseSensitive);
+    int find(const char *k, int len) const;
+private:
+    unsigned int hash(const char *k, int len) const;
+    bool equals(const std::string &keyword, const char *k, int len) const;
+private:
+    struct Entry
+    {
+        unsigned int hash;
+        int type;
+        std::string keyword;
+    };
+    std::vector<Entry> entries;
+    std::vector<int> slots;//index into entries, -1 for empty
+    unsigned int mask;
+    bool caseSensitive;
+};
+
 class HighlighterUtil
 {
 public:
@@ -105,10 +165,10 @@ public:
     bool isRefLanguageKeywords();
     bool isHaveSubLanguage();
     void setSubLanugage(const char *subLanguage);
-    const std::string getSubLanguage();
+    const std::string& getSubLanguage();
     void setName(const std::string &name);
     const char * getName();
-    std::string getRealName();
+    const std::string& getRealName();
     void setBegin(const std::string &begin);
     const std::string getBegin();
     void setEnd(const std::string &end);
@@ -118,15 +178,18 @@ public:
     void addKeyword(Keywords::KeywordsType kt, const std::string &keyword);
     void addRefContain(Contain *contain);
     void compile(Language *lan);
-    Contain *findMatchedContain(const std::string &match);
+    Contain *findMatchedContain(const RegExpSubject &match);
     RegExp& getBeginRe();
     RegExp& getEndRe();
     RegExp& getTerminatorsRe();
     RegExp& getLexemsRe();
     bool isRef();
     void setRef(bool r);
+    //the parent given by the language definition, a running highlight
+    //tracks its own parents, see CodeSyntaxHighlighter::getParent
     void setParent(Contain *contain);
     Contain* getParent();
+    Contain* getDefinedParent();
     const std::string& getTerminatorEnd();
     bool isReturnBegin();
     void setReturnBegin(bool b);
@@ -136,7 +199,7 @@ public:
     bool isExcludeEnd();
     void setExcludeEnd(bool b);
     const std::list<Keywords>& getKeywords();
-    int matchKeyword(const std::string &k);
+    int matchKeyword(const char *k, int len);
     void setStarts(Contain *contain);
     Contain* getStarts();
     void setRefLanguageContains(bool b);
@@ -155,6 +218,7 @@ private:
     bool refLanguageContains;
     int relevance;
     std::string name;
+    std::string realName;
     std::string begin;
     RegExp beginRe;
     std::string end;
@@ -166,6 +230,7 @@ private:
     std::string terminatorEnd;
     RegExp terminatorsRe;
     std::list<Keywords> keywords;
+    KeywordTable keywordTable;
     std::list<Contain *> refContains;
     Contain *parent;
     Contain *starts;
@@ -192,9 +257,9 @@ public:
     void setLexems(const std::string &lexems);
     const std::string& getLexems();
     const std::list<Keywords>& getKeywords();
-    int matchKeyword(const std::string &k);
+    int matchKeyword(const char *k, int len);
     Contain *findRefContain(const char *name);
-    Contain *findMatchedContain(const std::string &match);
+    Contain *findMatchedContain(const RegExpSubject &match);
     void printDebugInfo();
     bool isCompiled();
     void compileLanguage();
@@ -212,6 +277,7 @@ private:
     RegExp terminatorsRe;
     //keywords type
     std::list<Keywords> keywords;
+    KeywordTable keywordTable;
 
     std::string illegal;
     RegExp illegalRe;
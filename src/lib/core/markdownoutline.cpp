@@ -0,0 +1,217 @@
+#include <string.h>
+#include <stdio.h>
+
+#include "markdownoutline.h"
+#include "outline.h"
+#include "buffer.h"
+
+using namespace std;
+
+namespace {
+//append html without its tags, the entities stay escaped
+void appendText(string &text, const char *html, size_t size)
+{
+    const char *end = html+size;
+    while(html<end){
+        const char *tag = (const char *)memchr(html, '<', end-html);
+        if(!tag){
+            text.append(html, end-html);
+            return;
+        }
+        text.append(html, tag-html);
+        const char *close = (const char *)memchr(tag, '>', end-tag);
+        if(!close)
+            return;
+        html = close+1;
+    }
+}
+
+//the value of attribute name in the tag [tag, end), empty if it has none
+string attributeValue(const char *tag, const char *end, const char *name)
+{
+    size_t nameLen = strlen(name);
+    for(const char *p=tag+1; p+nameLen+2<end; p++){
+        if((p[-1]==' ' || p[-1]=='\t') && memcmp(p, name, nameLen)==0
+                && p[nameLen]=='=' && (p[nameLen+1]=='"' || p[nameLen+1]=='\'')){
+            const char *value = p+nameLen+2;
+            const char *valueEnd = (const char *)memchr(value, p[nameLen+1], end-value);
+            if(valueEnd)
+                return string(value, valueEnd-value);
+        }
+    }
+    return string();
+}
+}
+
+void MarkdownOutline::clear()
+{
+    headers.clear();
+}
+
+bool MarkdownOutline::isEmpty() const
+{
+    return headers.empty();
+}
+
+size_t MarkdownOutline::size() const
+{
+    return headers.size();
+}
+
+const MarkdownOutline::Header& MarkdownOutline::at(size_t i) const
+{
+    return headers[i];
+}
+
+void MarkdownOutline::setLine(size_t i, int line)
+{
+    headers[i].line = line;
+}
+
+void MarkdownOutline::addHeader(const Header &header)
+{
+    headers.push_back(header);
+}
+
+/**
+ * @brief MarkdownOutline::addHeader Add a header whose content has been
+ *        rendered to html, the line is unknown yet.
+ */
+void MarkdownOutline::addHeader(int level, const char *html, size_t size, const string &anchor)
+{
+    headers.push_back(Header());
+    Header &header = headers.back();
+    header.level = level;
+    appendText(header.text, html, size);
+    header.anchor = anchor;
+    header.line = -1;
+}
+
+/**
+ * @brief MarkdownOutline::addHtmlHeaders Add the h1-h6 elements of a rendered
+ *        document, for the engines which give no header callback.
+ */
+void MarkdownOutline::addHtmlHeaders(const char *html, size_t size)
+{
+    const char *end = html+size;
+    const char *p = html;
+    while(p+3<end){
+        const char *tag = (const char *)memchr(p, '<', end-p-3);
+        if(!tag)
+            return;
+        p = tag+1;
+        if((tag[1]!='h' && tag[1]!='H') || tag[2]<'1' || tag[2]>'6'
+                || (tag[3]!='>' && tag[3]!=' '))
+            continue;
+        const char *tagEnd = (const char *)memchr(tag, '>', end-tag);
+        if(!tagEnd)
+            return;
+        const char closeTag[4] = {'<', '/', tag[1], tag[2]};
+        const char *content = tagEnd+1;
+        const char *contentEnd = content;
+        while(contentEnd+4<=end && memcmp(contentEnd, closeTag, 4)!=0)
+            contentEnd++;
+        if(contentEnd+4>end)
+            return;
+        addHeader(tag[2]-'0', content, contentEnd-content, attributeValue(tag, tagEnd, "id"));
+        p = contentEnd+4;
+    }
+}
+
+/**
+ * @brief MarkdownOutline::toTocHtml Nested lists of links to the headers, the
+ *        first header gives the top level.
+ */
+void MarkdownOutline::toTocHtml(string &html) const
+{
+    int currentLevel = 0;
+    int levelOffset = 0;
+    for(size_t i=0; i<headers.size(); i++){
+        const Header &header = headers[i];
+        if(i==0)
+            levelOffset = header.level-1;
+        int level = header.level-levelOffset;
+        if(level<1)
+            level = 1;
+        if(level>currentLevel){
+            while(level>currentLevel){
+                html.append("<ul>\n<li>\n");
+                currentLevel++;
+            }
+        } else if(level<currentLevel){
+            html.append("</li>\n");
+            while(level<currentLevel){
+                html.append("</ul>\n</li>\n");
+                currentLevel--;
+            }
+            html.append("<li>\n");
+        } else {
+            html.append("</li>\n<li>\n");
+        }
+        if(header.anchor.empty())
+            html.append("<a>");
+        else
+            html.append("<a href=\"#").append(header.anchor).append("\">");
+        html.append(header.text).append("</a>\n");
+    }
+    while(currentLevel>0){
+        html.append("</li>\n</ul>\n");
+        currentLevel--;
+    }
+}
+
+/**
+ * @brief MarkdownOutline::findLine The line of the header with anchor, -1 if
+ *        there is none or its line is unknown.
+ */
+int MarkdownOutline::findLine(const string &anchor) const
+{
+    for(size_t i=0; i<headers.size(); i++){
+        if(headers[i].anchor==anchor)
+            return headers[i].line;
+    }
+    return -1;
+}
+
+bool MarkdownOutline::operator==(const MarkdownOutline &other) const
+{
+    if(headers.size()!=other.headers.size())
+        return false;
+    for(size_t i=0; i<headers.size(); i++){
+        const Header &a = headers[i];
+        const Header &b = other.headers[i];
+        if(a.level!=b.level || a.line!=b.line || a.anchor!=b.anchor || a.text!=b.text)
+            return false;
+    }
+    return true;
+}
+
+bool MarkdownOutline::operator!=(const MarkdownOutline &other) const
+{
+    return !(*this==other);
+}
+
+size_t MarkdownOutline::countLines(const char *data, size_t size)
+{
+    size_t lines = 0;
+    const char *end = data+size;
+    while((data = (const char *)memchr(data, '\n', end-data))){
+        lines++;
+        data++;
+    }
+    return lines;
+}
+
+void outline_add_header(void *outline, const struct buf *text, const struct buf *id, int level, int toc_index)
+{
+    string anchor;
+    if(id){
+        anchor.assign((const char *)id->data, id->size);
+    } else if(toc_index>=0){
+        char number[24];
+        sprintf(number, "toc_%d", toc_index);
+        anchor = number;
+    }
+    static_cast<MarkdownOutline *>(outline)->addHeader(level, text ? (const char *)text->data : "",
+                                                       text ? text->size : 0, anchor);
+}
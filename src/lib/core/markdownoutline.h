@@ -0,0 +1,41 @@
+#ifndef MARKDOWNOUTLINE_H
+#define MARKDOWNOUTLINE_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief The headers of a rendered document, collected by the html renderer
+ *        while it renders them. The preview and the toc both use it, so the
+ *        document is parsed only once.
+ */
+class MarkdownOutline
+{
+public:
+    struct Header
+    {
+        int level;
+        std::string text;//html escaped, without tags
+        std::string anchor;//id of the header element, empty if it has none
+        int line;//line in the document starting from 0, -1 if unknown
+    };
+
+public:
+    void clear();
+    bool isEmpty() const;
+    size_t size() const;
+    const Header& at(size_t i) const;
+    void setLine(size_t i, int line);
+    void addHeader(const Header &header);
+    void addHeader(int level, const char *html, size_t size, const std::string &anchor);
+    void addHtmlHeaders(const char *html, size_t size);
+    void toTocHtml(std::string &html) const;
+    int findLine(const std::string &anchor) const;
+    bool operator==(const MarkdownOutline &other) const;
+    bool operator!=(const MarkdownOutline &other) const;
+    static size_t countLines(const char *data, size_t size);
+private:
+    std::vector<Header> headers;
+};
+
+#endif // MARKDOWNOUTLINE_H
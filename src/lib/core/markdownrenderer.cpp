@@ -0,0 +1,205 @@
+#include "markdownrenderer.h"
+#include "markdown.h"
+#include "html.h"
+#include "buffer.h"
+#include "rendercache.h"
+#include "timingprofiler.h"
+
+using namespace std;
+
+MarkdownRenderer::MarkdownRenderer(RenderFunc renderFunc)
+{
+    this->renderFunc = renderFunc;
+    markdown = NULL;
+    callbacks = new sd_callbacks;
+    options = new html_renderopt;
+    ob = bufnew(MarkdownToHtml::OUTPUT_UNIT);
+    type = MarkdownToHtml::PHPMarkdownExtra;
+    lastAllocationCount = 0;
+    //the toc renderer writes other html for the same text
+    cacheable = renderFunc==sdhtml_renderer;
+    html = "";
+    htmlSize = 0;
+}
+
+MarkdownRenderer::~MarkdownRenderer()
+{
+    if(markdown)
+        sd_markdown_free(markdown);
+    bufrelease(ob);
+    delete callbacks;
+    delete options;
+}
+
+void MarkdownRenderer::resetMarkdown(MarkdownToHtml::MarkdownType type)
+{
+    if(markdown)
+        sd_markdown_free(markdown);
+    renderFunc(callbacks, options, HTML_TOC);
+    options->highlight_batch = &highlightBatch;
+    options->outline = &outline;
+    markdown = sd_markdown_new(MarkdownToHtml::extensionFlags(type), 16, callbacks, options);
+    this->type = type;
+}
+
+/**
+ * @brief MarkdownRenderer::render Render the whole document. MultiMarkdown
+ *        is passed to its own engine, its html is appended to outHtml.
+ * @return NOTHING -> data is empty
+ * @return SUCCESS -> outHtml is the rendered document
+ * @return ERROR -> something wrong
+ */
+MarkdownToHtml::MarkdownToHtmlResult
+MarkdownRenderer::render(MarkdownToHtml::MarkdownType type,
+                         const char *data, const int length,
+                         string &outHtml)
+{
+    MarkdownToHtml::MarkdownToHtmlResult result = render(type, data, length);
+    if(result!=MarkdownToHtml::SUCCESS)
+        return result;
+    if(type!=MarkdownToHtml::MultiMarkdown)
+        outHtml.clear();
+    outHtml.append(html, htmlSize);
+    return MarkdownToHtml::SUCCESS;
+}
+
+/**
+ * @brief MarkdownRenderer::render Render the whole document and keep the
+ *        html in the renderer, see getHtml(). data is only borrowed for the
+ *        call; MultiMarkdown needs it to end with '\0'.
+ *        Documents rendered before, by any renderer, come from the
+ *        RenderCache. Otherwise, without fenced code blocks the html is
+ *        sundown's own output buffer. It stays valid until the next render.
+ */
+MarkdownToHtml::MarkdownToHtmlResult
+MarkdownRenderer::render(MarkdownToHtml::MarkdownType type,
+                         const char *data, const int length)
+{
+    html = "";
+    htmlSize = 0;
+    outline.clear();
+    if(length==0 && type!=MarkdownToHtml::MultiMarkdown)
+        return MarkdownToHtml::NOTHING;
+    if(cacheable && length>0
+            && RenderCache::instance()->find(type, data, length, splicedHtml, outline)){
+        html = splicedHtml.data();
+        htmlSize = splicedHtml.size();
+        return MarkdownToHtml::SUCCESS;
+    }
+
+    MarkdownToHtml::MarkdownToHtmlResult result;
+    if(type==MarkdownToHtml::MultiMarkdown){
+        splicedHtml.clear();
+        result = MarkdownToHtml::translateMultiMarkdownToHtml(type, data, length, splicedHtml);
+        html = splicedHtml.data();
+        htmlSize = splicedHtml.size();
+        //MultiMarkdown has no header callback, read them from its html
+        outline.addHtmlHeaders(html, htmlSize);
+    } else {
+        result = renderSundown(type, data, length);
+        if(result!=MarkdownToHtml::SUCCESS)
+            return result;
+        if(highlightBatch.isEmpty()){
+            html = ob->size ? (const char *)ob->data : "";
+            htmlSize = ob->size;
+        } else {
+            splicedHtml.clear();
+            splicedHtml.reserve(ob->size);
+            highlightBatch.splice((const char *)ob->data, ob->size, splicedHtml);
+            html = splicedHtml.data();
+            htmlSize = splicedHtml.size();
+        }
+    }
+    if(result==MarkdownToHtml::SUCCESS && cacheable && length>0)
+        RenderCache::instance()->insert(type, data, length, html, htmlSize, outline);
+    return result;
+}
+
+/**
+ * @brief MarkdownRenderer::getHtml The html of the last render(type, data, length),
+ *        not terminated by '\0'.
+ */
+const char* MarkdownRenderer::getHtml() const
+{
+    return html;
+}
+
+size_t MarkdownRenderer::getHtmlSize() const
+{
+    return htmlSize;
+}
+
+/**
+ * @brief MarkdownRenderer::renderSundown Render into ob and highlight the
+ *        fenced code blocks, the placeholders are not replaced yet.
+ */
+MarkdownToHtml::MarkdownToHtmlResult
+MarkdownRenderer::renderSundown(MarkdownToHtml::MarkdownType type,
+                                const char *data, const int length)
+{
+    size_t allocations = bufalloccount();
+    if(!markdown || type!=this->type)
+        resetMarkdown(type);
+    if(!markdown || !ob)
+        return MarkdownToHtml::ERROR;
+
+    memset(&options->toc_data, 0, sizeof(options->toc_data));
+    highlightBatch.clear();
+    options->highlight_batch = HighlightBatch::canBatch(data, length) ? &highlightBatch : NULL;
+    ob->size = 0;
+    {
+        PROFILE_SCOPE("render.sundown");
+        //sundown only reads the document, no need to copy it first
+        sd_markdown_render(ob, (const uint8_t *)data, length, markdown);
+        findHeaderLines();
+    }
+
+    //the fenced code blocks are highlighted together after the render
+    highlightBatch.run();
+    lastAllocationCount = bufalloccount()-allocations;
+    return MarkdownToHtml::SUCCESS;
+}
+
+/**
+ * @brief MarkdownRenderer::getOutline The headers of the last render.
+ */
+const MarkdownOutline& MarkdownRenderer::getOutline() const
+{
+    return outline;
+}
+
+/**
+ * @brief MarkdownRenderer::findHeaderLines Give the headers of the outline
+ *        their line in the document, the prepared text is still there.
+ */
+void MarkdownRenderer::findHeaderLines()
+{
+    const buf *text = sd_markdown_text(markdown);
+    //each header the outline got has been recorded by sundown too
+    if(!text || sd_markdown_header_count(markdown)!=outline.size())
+        return;
+    size_t offset = 0;
+    size_t line = 0;
+    for(size_t i=0; i<outline.size(); i++){
+        size_t headerOffset = sd_markdown_header_offset(markdown, i, text->data, text->size);
+        if(headerOffset==(size_t)-1)
+            continue;
+        if(headerOffset<offset){
+            offset = 0;
+            line = 0;
+        }
+        line += MarkdownOutline::countLines((const char *)text->data+offset, headerOffset-offset);
+        offset = headerOffset;
+        outline.setLine(i, (int)sd_markdown_source_line(markdown, offset, line));
+    }
+}
+
+/**
+ * @brief MarkdownRenderer::getLastAllocationCount The number of allocations
+ *        the sundown buffers and the arena did in the last render on the
+ *        rendering thread. The highlighted code is not counted.
+ */
+size_t MarkdownRenderer::getLastAllocationCount() const
+{
+    return lastAllocationCount;
+}
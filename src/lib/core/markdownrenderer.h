@@ -0,0 +1,62 @@
+#ifndef MARKDOWNRENDERER_H
+#define MARKDOWNRENDERER_H
+
+#include <string>
+
+#include "markdowntohtml.h"
+#include "highlightbatch.h"
+#include "markdownoutline.h"
+
+struct sd_markdown;
+struct sd_callbacks;
+struct html_renderopt;
+struct buf;
+
+/**
+ * @brief Renders whole documents with a sundown renderer that is kept between
+ *        renders: the callbacks, the work buffer pools, the reference tables
+ *        and the arena the definitions live in. Once they have grown to the
+ *        size of the document, rendering it again allocates nearly nothing.
+ *        One object must only be used by one thread at a time.
+ */
+class MarkdownRenderer
+{
+public:
+    typedef void (*RenderFunc)(struct sd_callbacks *callbacks, struct html_renderopt *options, unsigned int render_flags);
+
+public:
+    explicit MarkdownRenderer(RenderFunc renderFunc);
+    ~MarkdownRenderer();
+    MarkdownToHtml::MarkdownToHtmlResult render(MarkdownToHtml::MarkdownType type,
+                                                const char *data, const int length,
+                                                std::string &outHtml);
+    MarkdownToHtml::MarkdownToHtmlResult render(MarkdownToHtml::MarkdownType type,
+                                                const char *data, const int length);
+    const char* getHtml() const;
+    size_t getHtmlSize() const;
+    const MarkdownOutline& getOutline() const;
+    size_t getLastAllocationCount() const;
+private:
+    MarkdownRenderer(const MarkdownRenderer &);
+    void operator=(const MarkdownRenderer &);
+    void resetMarkdown(MarkdownToHtml::MarkdownType type);
+    MarkdownToHtml::MarkdownToHtmlResult renderSundown(MarkdownToHtml::MarkdownType type,
+                                                       const char *data, const int length);
+    void findHeaderLines();
+private:
+    RenderFunc renderFunc;
+    sd_markdown *markdown;
+    sd_callbacks *callbacks;
+    html_renderopt *options;
+    buf *ob;
+    HighlightBatch highlightBatch;
+    MarkdownOutline outline;
+    std::string splicedHtml;//the result when ob is not the final html
+    const char *html;
+    size_t htmlSize;
+    MarkdownToHtml::MarkdownType type;
+    size_t lastAllocationCount;
+    bool cacheable;
+};
+
+#endif // MARKDOWNRENDERER_H
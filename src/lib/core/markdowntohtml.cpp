@@ -3,9 +3,34 @@
 #include "markdown.h"
 #include "html.h"
 #include "buffer.h"
+#include "markdownrenderer.h"
+#include "timingprofiler.h"
+
+#include <QThreadStorage>
 
 using namespace std;
 
+namespace {
+//a MultiMarkdown context is used by one thread at a time, every rendering
+//thread gets its own and keeps it, with the parser buffers, for the next render
+class MultiMarkdownContext
+{
+public:
+    MultiMarkdownContext() { context = mmd_context_new(); }
+    ~MultiMarkdownContext() { mmd_context_free(context); }
+    mmd_context *context;
+};
+
+QThreadStorage<MultiMarkdownContext *> multiMarkdownContexts;
+
+mmd_context* multiMarkdownContextForCurrentThread()
+{
+    if(!multiMarkdownContexts.hasLocalData())
+        multiMarkdownContexts.setLocalData(new MultiMarkdownContext);
+    return multiMarkdownContexts.localData()->context;
+}
+}
+
 MarkdownToHtml::MarkdownToHtml()
 {
 }
@@ -45,40 +70,10 @@ MarkdownToHtml::translateMarkdownExtraToHtml(MarkdownToHtml::MarkdownType type,
     return renderToHtml(type, data, length, outHtml, sdhtml_renderer);
 }
 
-MarkdownToHtml::MarkdownToHtmlResult
-MarkdownToHtml::renderToHtml(MarkdownToHtml::MarkdownType type, const char *data, const int length, string &outHtml,
-                             void (*renderFunc)(struct sd_callbacks *callbacks, struct html_renderopt *options, unsigned int render_flags))
+unsigned int MarkdownToHtml::extensionFlags(MarkdownToHtml::MarkdownType type)
 {
-    if (length == 0) //length is 0, just return
-        return NOTHING;
-
-    buf *ib, *ob;
-    sd_callbacks callbacks;
-    html_renderopt options;
-    sd_markdown *markdown;
-    unsigned int extension=0;
-
-    ib = bufnew(length);
-    if (ib == NULL)
-    {
-        return ERROR;
-    }
-    bufgrow(ib, length);
-    ib->size = length;
-    memcpy(ib->data, data, length);
-
-    ob = bufnew(OUTPUT_UNIT);
-    if (ob == NULL)
-    {
-        bufrelease(ib);
-        return ERROR;
-    }
-
-    renderFunc(&callbacks, &options, HTML_TOC);
-    if(type==Markdown)
-        extension = 0;
-    else if(type==PHPMarkdownExtra)
-        extension = MKDEXT_NO_INTRA_EMPHASIS
+    if(type==PHPMarkdownExtra)
+        return MKDEXT_NO_INTRA_EMPHASIS
             |MKDEXT_TABLES
             |MKDEXT_FENCED_CODE
             |MKDEXT_AUTOLINK
@@ -88,29 +83,24 @@ MarkdownToHtml::renderToHtml(MarkdownToHtml::MarkdownType type, const char *data
             |MKDEXT_HEADER_ID_ATTRIBUTE
             |MKDEXT_FOOTNOTE
             ;
-    markdown = sd_markdown_new( extension, 16, &callbacks, &options);
-    if (markdown == NULL)
-    {
-        bufrelease(ib);
-        bufrelease(ob);
-        return ERROR;
-    }
-
-    sd_markdown_render(ob, ib->data, ib->size, markdown);
-    sd_markdown_free(markdown);
-
-    outHtml.assign((const char*)ob->data, ob->size);
+    return 0;
+}
 
-    bufrelease(ib);
-    bufrelease(ob);
-    return SUCCESS; // success
+MarkdownToHtml::MarkdownToHtmlResult
+MarkdownToHtml::renderToHtml(MarkdownToHtml::MarkdownType type, const char *data, const int length, string &outHtml,
+                             void (*renderFunc)(struct sd_callbacks *callbacks, struct html_renderopt *options, unsigned int render_flags))
+{
+    //one-off conversions, the editors keep their own MarkdownRenderer
+    MarkdownRenderer renderer(renderFunc);
+    return renderer.render(type, data, length, outHtml);
 }
 
 MarkdownToHtml::MarkdownToHtmlResult
 MarkdownToHtml::translateMultiMarkdownToHtml(MarkdownType type, const char *data,
                                              const int length, string &outHtml)
 {
-    char *result = markdown_to_string(data, 0, HTML_FORMAT);
+    PROFILE_SCOPE("render.multimarkdown");
+    char *result = mmd_context_to_string(multiMarkdownContextForCurrentThread(), data, 0, HTML_FORMAT);
     outHtml.append(result);
     free(result);
     return SUCCESS;
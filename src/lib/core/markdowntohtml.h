@@ -47,6 +47,7 @@ public:
                                                        const char* data,
                                                        const int length, std::string &toc);
 
+    static unsigned int extensionFlags(MarkdownType type);
     static MarkdownToHtmlResult renderToHtml(MarkdownType type,
                                              const char *data,
                                              const int length,
@@ -0,0 +1,16 @@
+#ifndef OUTLINE_H
+#define OUTLINE_H
+
+struct buf;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void outline_add_header(void *outline, const struct buf *text, const struct buf *id, int level, int toc_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OUTLINE_H
@@ -0,0 +1,176 @@
+#include <string.h>
+
+#include "rendercache.h"
+
+using namespace std;
+
+namespace {
+const size_t DEFAULT_BUDGET = 32*1024*1024;
+//bookkeeping of an entry besides its strings
+const size_t ENTRY_OVERHEAD = 128;
+
+RenderCache *cacheInstance = NULL;
+QMutex instanceMutex;
+
+//FNV-1a over 8 byte words with a final mix per word, the text is hashed
+//on every lookup so it has to be cheap
+unsigned long long hashText(const char *data, size_t length)
+{
+    const unsigned long long prime = 1099511628211ULL;
+    unsigned long long hash = 14695981039346656037ULL;
+    size_t i = 0;
+    for(; i+8<=length; i+=8){
+        unsigned long long word;
+        memcpy(&word, data+i, 8);
+        hash = (hash^word)*prime;
+        hash ^= hash>>29;
+    }
+    for(; i<length; i++)
+        hash = (hash^(unsigned char)data[i])*prime;
+    return hash;
+}
+
+size_t outlineBytes(const MarkdownOutline &outline)
+{
+    size_t bytes = 0;
+    for(size_t i=0; i<outline.size(); i++)
+        bytes += sizeof(MarkdownOutline::Header)+outline.at(i).text.size()+outline.at(i).anchor.size();
+    return bytes;
+}
+}
+
+bool RenderCache::Key::operator<(const Key &other) const
+{
+    if(hash!=other.hash)
+        return hash<other.hash;
+    if(length!=other.length)
+        return length<other.length;
+    if(type!=other.type)
+        return type<other.type;
+    return flags<other.flags;
+}
+
+RenderCache::RenderCache()
+{
+    bytes = 0;
+    budget = DEFAULT_BUDGET;
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+}
+
+RenderCache* RenderCache::instance()
+{
+    QMutexLocker locker(&instanceMutex);
+    if(!cacheInstance)
+        cacheInstance = new RenderCache;
+    return cacheInstance;
+}
+
+RenderCache::Key RenderCache::makeKey(MarkdownToHtml::MarkdownType type, const char *data, const int length)
+{
+    Key key;
+    key.hash = hashText(data, length);
+    key.length = length;
+    key.type = type;
+    key.flags = MarkdownToHtml::extensionFlags(type);
+    return key;
+}
+
+/**
+ * @brief RenderCache::find Copy the render of data to outHtml and outline.
+ * @return false if it is not cached
+ */
+bool RenderCache::find(MarkdownToHtml::MarkdownType type, const char *data, const int length,
+                       string &outHtml, MarkdownOutline &outline)
+{
+    if(!isOn())
+        return false;
+    Key key = makeKey(type, data, length);
+    QMutexLocker locker(&mutex);
+    map<Key, EntryList::iterator>::iterator found = index.find(key);
+    //same hash and length but other text: the hash collided
+    if(found==index.end() || memcmp(found->second->text.data(), data, length)!=0){
+        misses++;
+        return false;
+    }
+    hits++;
+    entries.splice(entries.begin(), entries, found->second);
+    outHtml.assign(found->second->html);
+    outline = found->second->outline;
+    return true;
+}
+
+void RenderCache::insert(MarkdownToHtml::MarkdownType type, const char *data, const int length,
+                         const char *html, size_t htmlSize, const MarkdownOutline &outline)
+{
+    if(!isOn())
+        return;
+    Key key = makeKey(type, data, length);
+    size_t entryBytes = length+htmlSize+outlineBytes(outline)+ENTRY_OVERHEAD;
+    QMutexLocker locker(&mutex);
+    //a document which would push out everything else is not worth keeping
+    if(entryBytes>budget/2 || index.find(key)!=index.end())
+        return;
+    evict(budget-entryBytes);
+    entries.push_front(Entry());
+    Entry &entry = entries.front();
+    entry.key = key;
+    entry.text.assign(data, length);
+    entry.html.assign(html, htmlSize);
+    entry.outline = outline;
+    entry.bytes = entryBytes;
+    index[key] = entries.begin();
+    bytes += entryBytes;
+}
+
+/**
+ * @brief RenderCache::setBudget The memory the cached renders may take, 0
+ *        turns the cache off.
+ */
+void RenderCache::setBudget(size_t bytes)
+{
+    QMutexLocker locker(&mutex);
+    budget = bytes;
+    evict(budget);
+}
+
+//checked before the text is hashed, which is the expensive part of a lookup
+bool RenderCache::isOn()
+{
+    QMutexLocker locker(&mutex);
+    return budget>0;
+}
+
+void RenderCache::clear()
+{
+    QMutexLocker locker(&mutex);
+    entries.clear();
+    index.clear();
+    bytes = 0;
+}
+
+RenderCache::Statistics RenderCache::getStatistics()
+{
+    QMutexLocker locker(&mutex);
+    Statistics statistics;
+    statistics.hits = hits;
+    statistics.misses = misses;
+    statistics.evictions = evictions;
+    statistics.entries = entries.size();
+    statistics.bytes = bytes;
+    statistics.budget = budget;
+    return statistics;
+}
+
+//drop the least recently used entries until they take at most budget bytes
+void RenderCache::evict(size_t budget)
+{
+    while(bytes>budget && !entries.empty()){
+        Entry &last = entries.back();
+        bytes -= last.bytes;
+        index.erase(last.key);
+        entries.pop_back();
+        evictions++;
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+#include <list>
+#include <map>
+#include <string>
+
+#include <QMutex>
+
+#include "markdowntohtml.h"
+#include "markdownoutline.h"
+
+/**
+ * @brief Process wide cache of whole document renders, so that tabs, split
+ *        views and exports of the same text render it once. Entries are
+ *        keyed by a hash of the text with the engine and its extensions,
+ *        and keep the text itself, so that a hash collision is a miss and
+ *        never the render of another document. The least recently used
+ *        entries are dropped to stay in the memory budget. All members are
+ *        thread safe.
+ */
+class RenderCache
+{
+public:
+    struct Statistics
+    {
+        unsigned long long hits;
+        unsigned long long misses;
+        unsigned long long evictions;
+        size_t entries;
+        size_t bytes;
+        size_t budget;
+    };
+
+public:
+    static RenderCache* instance();
+    bool find(MarkdownToHtml::MarkdownType type, const char *data, const int length,
+              std::string &outHtml, MarkdownOutline &outline);
+    void insert(MarkdownToHtml::MarkdownType type, const char *data, const int length,
+                const char *html, size_t htmlSize, const MarkdownOutline &outline);
+    void setBudget(size_t bytes);
+    void clear();
+    Statistics getStatistics();
+private:
+    struct Key
+    {
+        unsigned long long hash;
+        size_t length;
+        int type;
+        unsigned int flags;
+        bool operator<(const Key &other) const;
+    };
+    struct Entry
+    {
+        Key key;
+        std::string text;
+        std::string html;
+        MarkdownOutline outline;
+        size_t bytes;
+    };
+    typedef std::list<Entry> EntryList;
+
+private:
+    RenderCache();
+    RenderCache(const RenderCache &);
+    void operator=(const RenderCache &);
+    static Key makeKey(MarkdownToHtml::MarkdownType type, const char *data, const int length);
+    void evict(size_t budget);
+    bool isOn();
+private:
+    QMutex mutex;
+    EntryList entries;//most recently used first
+    std::map<Key, EntryList::iterator> index;
+    size_t bytes;
+    size_t budget;
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+};
+
+#endif // RENDERCACHE_H
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <QThread>
+
+#include "timingprofiler.h"
+
+using namespace std;
+
+namespace {
+const size_t MAX_EVENTS = 1000000;
+
+TimingProfiler *profilerInstance = NULL;
+QMutex instanceMutex;
+
+int bucketIndex(qint64 durationNs)
+{
+    unsigned long long us = durationNs/1000;
+    int i = 0;
+    while(us && i<TimingProfiler::BUCKET_COUNT-1){
+        us >>= 1;
+        i++;
+    }
+    return i;
+}
+}
+
+QAtomicInt TimingProfiler::enabled(0);
+
+/**
+ * @brief TimingProfiler::Stage::percentileMs The upper bound of the bucket
+ *        which holds the p-th percentile, or the maximum if that is less.
+ */
+double TimingProfiler::Stage::percentileMs(int p) const
+{
+    if(count==0)
+        return 0;
+    unsigned long long rank = (count*p+99)/100;
+    unsigned long long seen = 0;
+    for(int i=0; i<BUCKET_COUNT; i++){
+        seen += buckets[i];
+        if(seen>=rank){
+            double bound = (1ULL<<i)/1000.0;
+            double max = maxNs/1000000.0;
+            return bound<max ? bound : max;
+        }
+    }
+    return maxNs/1000000.0;
+}
+
+TimingProfiler::TimingProfiler()
+{
+    nextEvent = 0;
+    clock.start();
+}
+
+TimingProfiler* TimingProfiler::instance()
+{
+    QMutexLocker locker(&instanceMutex);
+    if(!profilerInstance)
+        profilerInstance = new TimingProfiler;
+    return profilerInstance;
+}
+
+void TimingProfiler::setEnabled(bool b)
+{
+    enabled.fetchAndStoreOrdered(b ? 1 : 0);
+}
+
+//nanoseconds since the profiler was created
+qint64 TimingProfiler::now()
+{
+    return clock.nsecsElapsed();
+}
+
+void TimingProfiler::record(const char *name, qint64 startNs, qint64 durationNs)
+{
+    Event event;
+    event.name = name;
+    event.startNs = startNs;
+    event.durationNs = durationNs;
+    event.thread = (void *)QThread::currentThreadId();
+    QMutexLocker locker(&mutex);
+    map<string, Stage>::iterator it = stages.find(name);
+    if(it==stages.end()){
+        Stage stage;
+        stage.name = name;
+        stage.count = 0;
+        stage.totalNs = 0;
+        stage.maxNs = 0;
+        memset(stage.buckets, 0, sizeof(stage.buckets));
+        it = stages.insert(make_pair(string(name), stage)).first;
+    }
+    Stage &stage = it->second;
+    stage.count++;
+    stage.totalNs += durationNs;
+    if((unsigned long long)durationNs>stage.maxNs)
+        stage.maxNs = durationNs;
+    stage.buckets[bucketIndex(durationNs)]++;
+
+    if(events.size()<MAX_EVENTS)
+        events.push_back(event);
+    else
+        events[nextEvent] = event;
+    nextEvent = (nextEvent+1)%MAX_EVENTS;
+}
+
+vector<TimingProfiler::Stage> TimingProfiler::getStages()
+{
+    QMutexLocker locker(&mutex);
+    vector<Stage> result;
+    for(map<string, Stage>::const_iterator it=stages.begin(); it!=stages.end(); ++it)
+        result.push_back(it->second);
+    return result;
+}
+
+void TimingProfiler::reset()
+{
+    QMutexLocker locker(&mutex);
+    stages.clear();
+    events.clear();
+    nextEvent = 0;
+}
+
+/**
+ * @brief TimingProfiler::writeChromeTrace Save the latest events in the trace
+ *        event format, as complete ("X") events.
+ */
+bool TimingProfiler::writeChromeTrace(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if(!file)
+        return false;
+    QMutexLocker locker(&mutex);
+    //threads get small numbers in the order they show up
+    map<void *, int> threads;
+    fputs("{\"traceEvents\":[\n", file);
+    size_t first = events.size()<MAX_EVENTS ? 0 : nextEvent;
+    for(size_t i=0; i<events.size(); i++){
+        const Event &event = events[(first+i)%events.size()];
+        map<void *, int>::iterator thread = threads.find(event.thread);
+        if(thread==threads.end())
+            thread = threads.insert(make_pair(event.thread, (int)threads.size()+1)).first;
+        fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"mdcharm\",\"ph\":\"X\","
+                "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                i ? ",\n" : "", event.name,
+                event.startNs/1000.0, event.durationNs/1000.0, thread->second);
+    }
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+    return fclose(file)==0;
+}
@@ -0,0 +1,100 @@
+#ifndef TIMINGPROFILER_H
+#define TIMINGPROFILER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QElapsedTimer>
+
+/**
+ * @brief Collects how long the stages of the edit to preview pipeline take.
+ *        Each stage gets a histogram, and the latest events are kept to be
+ *        saved as a Chrome trace (chrome://tracing). Stages are timed with
+ *        PROFILE_SCOPE; while the profiler is disabled that costs a relaxed
+ *        load of an int. All members are thread safe.
+ */
+class TimingProfiler
+{
+public:
+    static const int BUCKET_COUNT = 32;//bucket i counts [2^(i-1), 2^i) us
+    struct Stage
+    {
+        std::string name;
+        unsigned long long count;
+        unsigned long long totalNs;
+        unsigned long long maxNs;
+        unsigned int buckets[BUCKET_COUNT];
+        double percentileMs(int p) const;
+    };
+
+public:
+    static TimingProfiler* instance();
+    static bool isEnabled()
+    {
+#if QT_VERSION >= 0x050000
+        return enabled.load()!=0;//relaxed
+#else
+        return enabled!=0;
+#endif
+    }
+    void setEnabled(bool b);
+    qint64 now();
+    void record(const char *name, qint64 startNs, qint64 durationNs);
+    std::vector<Stage> getStages();
+    void reset();
+    bool writeChromeTrace(const char *path);
+private:
+    struct Event
+    {
+        const char *name;
+        qint64 startNs;
+        qint64 durationNs;
+        void *thread;
+    };
+
+private:
+    TimingProfiler();
+    TimingProfiler(const TimingProfiler &);
+    void operator=(const TimingProfiler &);
+private:
+    static QAtomicInt enabled;
+    QMutex mutex;
+    QElapsedTimer clock;
+    std::map<std::string, Stage> stages;
+    std::vector<Event> events;//a ring of the latest events
+    size_t nextEvent;
+};
+
+/**
+ * @brief Records the time from its construction to its destruction as one
+ *        event of the stage name, which must be a string literal.
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(const char *name)
+    {
+        this->name = TimingProfiler::isEnabled() ? name : NULL;
+        if(this->name)
+            start = TimingProfiler::instance()->now();
+    }
+    ~ScopedTimer()
+    {
+        if(name){
+            TimingProfiler *profiler = TimingProfiler::instance();
+            profiler->record(name, start, profiler->now()-start);
+        }
+    }
+private:
+    const char *name;
+    qint64 start;
+};
+
+#define PROFILE_SCOPE_CONCAT(a, b) a##b
+#define PROFILE_SCOPE_NAME(line) PROFILE_SCOPE_CONCAT(profileScopeTimer, line)
+#define PROFILE_SCOPE(name) ScopedTimer PROFILE_SCOPE_NAME(__LINE__)(name)
+
+#endif // TIMINGPROFILER_H
@@ -34,6 +34,7 @@ HEADERS +=  src/affentry.hxx \
             src/hunspell.hxx \
             src/hunzip.hxx \
             src/langnum.hxx \
+            src/mapfile.hxx \
             src/phonet.hxx \
             src/replist.hxx \
             src/suggestmgr.hxx \
@@ -50,6 +51,7 @@ SOURCES +=  src/affentry.cxx \
             src/hashmgr.cxx \
             src/hunspell.cxx \
             src/hunzip.cxx \
+            src/mapfile.cxx \
             src/phonet.cxx \
             src/replist.cxx \
             src/suggestmgr.cxx \
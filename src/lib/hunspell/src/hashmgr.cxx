@@ -5,14 +5,20 @@
 #include <string.h>
 #include <stdio.h> 
 #include <ctype.h>
+#include <stddef.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "hashmgr.hxx"
 #include "csutil.hxx"
 #include "atypes.hxx"
 
-// build a hash table from a munched word list
+// build a hash table from a munched word list, or map the one compiled
+// into cpath by a previous run when the dictionary has not changed since
 
-HashMgr::HashMgr(const char * tpath, const char * apath, const char * key)
+HashMgr::HashMgr(const char * tpath, const char * apath, const char * key,
+    const char * cpath)
 {
   tablesize = 0;
   tableptr = NULL;
@@ -30,9 +36,16 @@ HashMgr::HashMgr(const char * tpath, const char * apath, const char * key)
   aliasf = NULL;
   numaliasm = 0;
   aliasm = NULL;
+  cache = NULL;
+  cacheentries = NULL;
+  cacheentrylen = 0;
+  cacheflags = NULL;
+  cacheflaglen = 0;
   forbiddenword = FORBIDDENWORD; // forbidden word signing flag
   load_config(apath, key);
+  if (cpath && !key && load_cache(cpath, tpath, apath) == 0) return;
   int ec = load_tables(tpath, key);
+  if (!ec && cpath && !key) write_cache(cpath, tpath, apath);
   if (ec) {
     /* error condition - what should we do here */
     HUNSPELL_WARNING(stderr, "Hash Manager Error : %d\n",ec);
@@ -55,14 +68,16 @@ HashMgr::~HashMgr()
       struct hentry * nt = NULL;
       while(pt) {
         nt = pt->next;
-        if (pt->astr && (!aliasf || TESTAFF(pt->astr, ONLYUPCASEFLAG, pt->alen))) free(pt->astr);
-        free(pt);
+        if (pt->astr && (!aliasf || TESTAFF(pt->astr, ONLYUPCASEFLAG, pt->alen))) free_flags(pt->astr);
+        if ((char *) pt < cacheentries || (char *) pt >= cacheentries + cacheentrylen) free(pt);
         pt = nt;
       }
     }
     free(tableptr);
   }
   tablesize = 0;
+  if (cacheentries) free(cacheentries);
+  if (cache) delete cache;
 
   if (aliasf) {
     for (int j = 0; j < (numaliasf); j++) free(aliasf[j]);
@@ -169,7 +184,7 @@ int HashMgr::add_word(const char * word, int wbl, int wcl, unsigned short * aff,
     	    // remove hidden onlyupcase homonym
             if (!onlyupcase) {
 		if ((dp->astr) && TESTAFF(dp->astr, ONLYUPCASEFLAG, dp->alen)) {
-		    free(dp->astr);
+		    free_flags(dp->astr);
 		    dp->astr = hp->astr;
 		    dp->alen = hp->alen;
 		    free(hp);
@@ -187,7 +202,7 @@ int HashMgr::add_word(const char * word, int wbl, int wcl, unsigned short * aff,
     	    // remove hidden onlyupcase homonym
             if (!onlyupcase) {
 		if ((dp->astr) && TESTAFF(dp->astr, ONLYUPCASEFLAG, dp->alen)) {
-		    free(dp->astr);
+		    free_flags(dp->astr);
 		    dp->astr = hp->astr;
 		    dp->alen = hp->alen;
 		    free(hp);
@@ -203,7 +218,7 @@ int HashMgr::add_word(const char * word, int wbl, int wcl, unsigned short * aff,
     	    dp->next = hp;
        } else {
     	    // remove hidden onlyupcase homonym
-    	    if (hp->astr) free(hp->astr);
+    	    if (hp->astr) free_flags(hp->astr);
     	    free(hp);
        }
     return 0;
@@ -926,3 +941,314 @@ char * HashMgr::get_aliasm(int index) {
     HUNSPELL_WARNING(stderr, "error: bad morph. alias index: %d\n", index);
     return NULL;
 }
+
+// compiled hash table cache
+//
+// layout: header, bucket table, word entries, flag vectors. The entries
+// are struct hentry images whose pointers are stored as offsets + 1 (0 is
+// NULL); they are copied and relocated on load, while the bucket table and
+// the flag vectors are used in place, so those pages are shared by every
+// process that maps the same cache. The layout follows the compiler, the
+// header rejects caches of other builds.
+
+#define CACHE_MAGIC "HUNCACHE"
+#define CACHE_VERSION 1
+#define CACHE_ALIGN 8
+
+struct cache_header {
+    char magic[8];
+    int version;
+    int hentrysize;
+    int ptrsize;
+    int tablesize;
+    long long dicsize, dicmtime; // the cache is stale when these change
+    long long affsize, affmtime;
+    long long entrylen;
+    long long flaglen;
+};
+
+struct cache_alias {
+    const char * desc;
+    size_t index;
+};
+
+static size_t cache_align(size_t len)
+{
+    return (len + CACHE_ALIGN - 1) & ~((size_t) CACHE_ALIGN - 1);
+}
+
+static int cache_stamp(const char * path, long long * size, long long * mtime)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) return 1;
+    *size = (long long) st.st_size;
+    *mtime = (long long) st.st_mtime;
+    return 0;
+}
+
+static int cache_alias_cmp(const void * a, const void * b)
+{
+    const char * x = ((const struct cache_alias *) a)->desc;
+    const char * y = ((const struct cache_alias *) b)->desc;
+    return (x < y) ? -1 : (x > y);
+}
+
+// bytes of an entry in the cache: the word (blen may be shorter after
+// removing ignored characters, the description follows blen) and the
+// description or its alias pointer
+static size_t cache_used(struct hentry * hp)
+{
+    size_t wl = strlen(hp->word);
+    if (wl < hp->blen) wl = hp->blen;
+    size_t used = offsetof(struct hentry, word) + wl + 1;
+    if (hp->var & H_OPT_ALIASM) used += sizeof(char *);
+    else if (hp->var & H_OPT) used += strlen(HENTRY_DATA(hp)) + 1;
+    return used;
+}
+
+static size_t cache_record(struct hentry * hp)
+{
+    size_t len = cache_used(hp);
+    if (len < sizeof(struct hentry)) len = sizeof(struct hentry);
+    return cache_align(len);
+}
+
+void HashMgr::free_flags(unsigned short * flags)
+{
+    if (cacheflags && flags >= cacheflags && flags <= cacheflags + cacheflaglen) return;
+    free(flags);
+}
+
+int HashMgr::load_cache(const char * cpath, const char * tpath, const char * apath)
+{
+    struct cache_header head;
+    long long dicsize, dicmtime, affsize, affmtime;
+    if (cache_stamp(tpath, &dicsize, &dicmtime) || cache_stamp(apath, &affsize, &affmtime))
+        return 1;
+    MapFile * map = new MapFile(cpath);
+    const char * data = map->getdata();
+    size_t size = map->getsize();
+    if (!data || size < sizeof(head)) {
+        delete map;
+        return 1;
+    }
+    memcpy(&head, data, sizeof(head));
+    size_t bucketpos = cache_align(sizeof(head));
+    size_t entrypos = cache_align(bucketpos + (size_t) head.tablesize * sizeof(int));
+    size_t flagpos = entrypos + (size_t) head.entrylen;
+    if (memcmp(head.magic, CACHE_MAGIC, sizeof(head.magic)) != 0 ||
+        head.version != CACHE_VERSION ||
+        head.hentrysize != (int) sizeof(struct hentry) ||
+        head.ptrsize != (int) sizeof(char *) ||
+        head.dicsize != dicsize || head.dicmtime != dicmtime ||
+        head.affsize != affsize || head.affmtime != affmtime ||
+        head.tablesize <= 0 || head.entrylen < 0 || head.flaglen < 0 ||
+        flagpos + (size_t) head.flaglen * sizeof(unsigned short) != size) {
+        delete map;
+        return 1;
+    }
+
+    const int * buckets = (const int *) (data + bucketpos);
+    size_t entrylen = (size_t) head.entrylen;
+    size_t flaglen = (size_t) head.flaglen;
+    // trailing zero byte, so no word of a damaged cache runs off the end
+    char * entries = (char *) malloc(entrylen + 1);
+    tableptr = (struct hentry **) malloc(head.tablesize * sizeof(struct hentry *));
+    if (!entries || !tableptr) {
+        if (entries) free(entries);
+        if (tableptr) free(tableptr);
+        tableptr = NULL;
+        delete map;
+        return 1;
+    }
+    memcpy(entries, data + entrypos, entrylen);
+    entries[entrylen] = '\0';
+    tablesize = head.tablesize;
+    cache = map;
+    cacheentries = entries;
+    cacheentrylen = entrylen;
+    cacheflags = (const unsigned short *) (data + flagpos);
+    cacheflaglen = flaglen;
+
+    // entries are written chain by chain, so every link points forward
+    size_t last = (entrylen < sizeof(struct hentry)) ? 0 : entrylen - sizeof(struct hentry) + 1;
+    int bad = 0;
+    for (int i = 0; i < tablesize && !bad; i++) {
+        struct hentry ** link = &tableptr[i];
+        size_t off = (size_t) buckets[i];
+        size_t prev = 0;
+        while (off) {
+            if (off <= prev || off > last) {
+                bad = 1;
+                break;
+            }
+            struct hentry * hp = (struct hentry *) (entries + off - 1);
+            *link = hp;
+            size_t hom = (size_t) hp->next_homonym;
+            if (hom && (hom <= off || hom > last)) {
+                bad = 1;
+                break;
+            }
+            hp->next_homonym = hom ? (struct hentry *) (entries + hom - 1) : NULL;
+            size_t fl = (size_t) hp->astr;
+            if (fl && (hp->alen < 0 || fl - 1 + hp->alen > flaglen)) {
+                bad = 1;
+                break;
+            }
+            hp->astr = fl ? (unsigned short *) cacheflags + fl - 1 : NULL;
+            if (hp->var & H_OPT_ALIASM) {
+                char * p = HENTRY_WORD(hp) + hp->blen + 1;
+                size_t index = (size_t) get_stored_pointer(p);
+                store_pointer(p, index ? get_aliasm((int) index) : NULL);
+            }
+            prev = off;
+            off = (size_t) hp->next;
+            link = &hp->next;
+        }
+        *link = NULL;
+    }
+    if (bad) {
+        HUNSPELL_WARNING(stderr, "error: %s: damaged dictionary cache\n", cpath);
+        // nothing points into the entries yet, drop them and the table
+        free(tableptr);
+        tableptr = NULL;
+        tablesize = 0;
+        free(cacheentries);
+        cacheentries = NULL;
+        cacheentrylen = 0;
+        cacheflags = NULL;
+        cacheflaglen = 0;
+        delete cache;
+        cache = NULL;
+        return 1;
+    }
+    return 0;
+}
+
+int HashMgr::write_cache(const char * cpath, const char * tpath, const char * apath)
+{
+    struct cache_header head;
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, CACHE_MAGIC, sizeof(head.magic));
+    head.version = CACHE_VERSION;
+    head.hentrysize = sizeof(struct hentry);
+    head.ptrsize = sizeof(char *);
+    head.tablesize = tablesize;
+    if (cache_stamp(tpath, &head.dicsize, &head.dicmtime) ||
+        cache_stamp(apath, &head.affsize, &head.affmtime))
+        return 1;
+
+    // first pass: offsets of the chains, sizes of both regions
+    int * buckets = (int *) malloc(tablesize * sizeof(int));
+    if (!buckets) return 1;
+    size_t entrylen = 0, flaglen = 0, maxrecord = 0;
+    for (int i = 0; i < tablesize; i++) {
+        buckets[i] = tableptr[i] ? (int) (entrylen + 1) : 0;
+        for (struct hentry * hp = tableptr[i]; hp; hp = hp->next) {
+            size_t len = cache_record(hp);
+            if (len > maxrecord) maxrecord = len;
+            entrylen += len;
+            if (hp->astr) flaglen += hp->alen;
+            if (entrylen >= INT_MAX) {
+                free(buckets);
+                return 1;
+            }
+        }
+    }
+    head.entrylen = entrylen;
+    head.flaglen = flaglen;
+
+    struct cache_alias * aliases = NULL;
+    if (aliasm) {
+        aliases = (struct cache_alias *) malloc(numaliasm * sizeof(struct cache_alias));
+        if (!aliases) {
+            free(buckets);
+            return 1;
+        }
+        for (int j = 0; j < numaliasm; j++) {
+            aliases[j].desc = aliasm[j];
+            aliases[j].index = j + 1;
+        }
+        qsort(aliases, numaliasm, sizeof(struct cache_alias), cache_alias_cmp);
+    }
+    unsigned short * flags = (unsigned short *) malloc((flaglen + 1) * sizeof(unsigned short));
+    char * record = (char *) malloc(maxrecord + 1);
+    char * tmp = (char *) malloc(strlen(cpath) + 5);
+    FILE * f = NULL;
+    if (flags && record && tmp) {
+        strcpy(tmp, cpath);
+        strcat(tmp, ".tmp");
+        f = fopen(tmp, "wb");
+    }
+    int ec = (f == NULL);
+    static const char zero[CACHE_ALIGN] = { 0 };
+    if (!ec) {
+        size_t bucketpos = cache_align(sizeof(head));
+        size_t bucketend = bucketpos + tablesize * sizeof(int);
+        ec = fwrite(&head, sizeof(head), 1, f) != 1 ||
+            fwrite(zero, 1, bucketpos - sizeof(head), f) != bucketpos - sizeof(head) ||
+            fwrite(buckets, sizeof(int), tablesize, f) != (size_t) tablesize ||
+            fwrite(zero, 1, cache_align(bucketend) - bucketend, f) != cache_align(bucketend) - bucketend;
+    }
+
+    // second pass: the entries in the same order, pointers made offsets
+    size_t off = 0, fl = 0;
+    for (int i = 0; i < tablesize && !ec; i++) {
+        for (struct hentry * hp = tableptr[i]; hp && !ec; hp = hp->next) {
+            size_t len = cache_record(hp);
+            memset(record, 0, len);
+            memcpy(record, hp, cache_used(hp));
+            struct hentry * rp = (struct hentry *) record;
+            rp->next = hp->next ? (struct hentry *) (off + len + 1) : NULL;
+            rp->next_homonym = NULL;
+            if (hp->next_homonym) {
+                // homonyms are later entries of the same chain
+                size_t hom = off + len;
+                struct hentry * np = hp->next;
+                while (np && np != hp->next_homonym) {
+                    hom += cache_record(np);
+                    np = np->next;
+                }
+                if (!np) {
+                    ec = 1;
+                    break;
+                }
+                rp->next_homonym = (struct hentry *) (hom + 1);
+            }
+            if (hp->astr) {
+                rp->astr = (unsigned short *) (fl + 1);
+                memcpy(flags + fl, hp->astr, hp->alen * sizeof(unsigned short));
+                fl += hp->alen;
+            }
+            if (hp->var & H_OPT_ALIASM) {
+                struct cache_alias key;
+                key.desc = get_stored_pointer(HENTRY_WORD(hp) + hp->blen + 1);
+                key.index = 0;
+                struct cache_alias * found = NULL;
+                if (key.desc) found = (struct cache_alias *) bsearch(&key, aliases,
+                    numaliasm, sizeof(struct cache_alias), cache_alias_cmp);
+                store_pointer(HENTRY_WORD(rp) + rp->blen + 1,
+                    (char *) (found ? found->index : 0));
+            }
+            ec = fwrite(record, 1, len, f) != len;
+            off += len;
+        }
+    }
+    if (!ec) ec = fwrite(flags, sizeof(unsigned short), flaglen, f) != flaglen;
+    if (f && fclose(f) != 0) ec = 1;
+    if (f && !ec) {
+        // replace the old cache in one step, processes that mapped it
+        // keep reading the old pages
+#ifdef _WIN32
+        remove(cpath);
+#endif
+        ec = rename(tmp, cpath) != 0;
+    }
+    if (f && ec) remove(tmp);
+    if (tmp) free(tmp);
+    if (record) free(record);
+    if (flags) free(flags);
+    if (aliases) free(aliases);
+    free(buckets);
+    return ec;
+}
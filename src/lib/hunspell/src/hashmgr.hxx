@@ -7,6 +7,7 @@
 
 #include "htypes.hxx"
 #include "filemgr.hxx"
+#include "mapfile.hxx"
 
 enum flag { FLAG_CHAR, FLAG_LONG, FLAG_NUM, FLAG_UNI };
 
@@ -31,10 +32,16 @@ class LIBHUNSPELL_DLL_EXPORTED HashMgr
   unsigned short *  aliasflen;
   int               numaliasm; // morphological desciption `compression' with aliases
   char **           aliasm;
+  MapFile *         cache; // compiled hash table of a previous load
+  char *            cacheentries; // relocated copy of its word entries
+  size_t            cacheentrylen;
+  const unsigned short * cacheflags; // flag vectors, used in place
+  size_t            cacheflaglen;
 
 
 public:
-  HashMgr(const char * tpath, const char * apath, const char * key = NULL);
+  HashMgr(const char * tpath, const char * apath, const char * key = NULL,
+    const char * cpath = NULL);
   ~HashMgr();
 
   struct hentry * lookup(const char *) const;
@@ -63,6 +70,9 @@ private:
     unsigned short * flags, int al, char * dp, int captype);
   int parse_aliasm(char * line, FileMgr * af);
   int remove_forbidden_flag(const char * word);
+  int load_cache(const char * cpath, const char * tpath, const char * apath);
+  int write_cache(const char * cpath, const char * tpath, const char * apath);
+  void free_flags(unsigned short * flags);
 
 };
 
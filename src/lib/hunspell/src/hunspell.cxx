@@ -12,7 +12,8 @@
 #endif
 #include "csutil.hxx"
 
-Hunspell::Hunspell(const char * affpath, const char * dpath, const char * key)
+Hunspell::Hunspell(const char * affpath, const char * dpath, const char * key,
+    const char * cachepath)
 {
     encoding = NULL;
     csconv = NULL;
@@ -22,7 +23,7 @@ Hunspell::Hunspell(const char * affpath, const char * dpath, const char * key)
     maxdic = 0;
 
     /* first set up the hash manager */
-    pHMgr[0] = new HashMgr(dpath, affpath, key);
+    pHMgr[0] = new HashMgr(dpath, affpath, key, cachepath);
     if (pHMgr[0]) maxdic = 1;
 
     /* next set up the affix manager */
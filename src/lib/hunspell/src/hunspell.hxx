@@ -35,9 +35,12 @@ public:
 
   /* Hunspell(aff, dic) - constructor of Hunspell class
    * input: path of affix file and dictionary file
+   * cachepath: optional file for the compiled word table, mapped instead of
+   * parsing the dic file while the aff and dic files are unchanged
    */
 
-  Hunspell(const char * affpath, const char * dpath, const char * key = NULL);
+  Hunspell(const char * affpath, const char * dpath, const char * key = NULL,
+    const char * cachepath = NULL);
   ~Hunspell();
 
   /* load extra dictionaries (only dic files) */
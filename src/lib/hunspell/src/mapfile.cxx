@@ -0,0 +1,66 @@
+#include "license.hunspell"
+#include "license.myspell"
+
+#include "mapfile.hxx"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MapFile::MapFile(const char * filename) {
+    data = NULL;
+    size = 0;
+#ifdef _WIN32
+    mapping = NULL;
+    file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = NULL;
+        return;
+    }
+    LARGE_INTEGER len;
+    if (!GetFileSizeEx((HANDLE) file, &len) || len.QuadPart == 0 ||
+        (ULONGLONG) len.QuadPart > (size_t) -1) return;
+    mapping = CreateFileMappingA((HANDLE) file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) return;
+    data = (const char *) MapViewOfFile((HANDLE) mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data) size = (size_t) len.QuadPart;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void * p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            data = (const char *) p;
+            size = st.st_size;
+        }
+    }
+    // the mapping keeps its own reference to the file
+    close(fd);
+#endif
+}
+
+MapFile::~MapFile()
+{
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle((HANDLE) mapping);
+    if (file) CloseHandle((HANDLE) file);
+#else
+    if (data) munmap((void *) data, size);
+#endif
+}
+
+const char * MapFile::getdata() {
+    return data;
+}
+
+size_t MapFile::getsize() {
+    return size;
+}
@@ -0,0 +1,25 @@
+/* read-only memory mapping of a whole file, shared between processes */
+#ifndef _MAPFILE_HXX_
+#define _MAPFILE_HXX_
+
+#include "hunvisapi.h"
+
+#include <stddef.h>
+
+class LIBHUNSPELL_DLL_EXPORTED MapFile
+{
+protected:
+    const char * data;
+    size_t size;
+#ifdef _WIN32
+    void * file;
+    void * mapping;
+#endif
+
+public:
+    MapFile(const char * filename);
+    ~MapFile();
+    const char * getdata();
+    size_t getsize();
+};
+#endif
@@ -26,6 +26,7 @@
 #include "houdini.h"
 
 #include "highlighter.h"
+#include "outline.h"
 
 #define USE_XHTML(opt) (opt->flags & HTML_USE_XHTML)
 
@@ -122,6 +123,8 @@ rndr_autolink(struct buf *ob, const struct buf *link, enum mkd_autolink type, vo
 static void
 rndr_blockcode(struct buf *ob, const struct buf *text, const struct buf *lang, void *opaque)
 {
+	struct html_renderopt *options = opaque;
+
 	if (ob->size) bufputc(ob, '\n');
 
 	if (lang && lang->size) {
@@ -146,7 +149,10 @@ rndr_blockcode(struct buf *ob, const struct buf *text, const struct buf *lang, v
 		}
         lanEnd = ob->size;
 		BUFPUTSL(ob, "\">");
-        highlighter(ob, ob->data+lanStart, lanEnd-lanStart, text->data, text->size);
+        if (options->highlight_batch)
+            highlighter_batch_add(options->highlight_batch, ob, ob->data+lanStart, lanEnd-lanStart, text->data, text->size);
+        else
+            highlighter(ob, ob->data+lanStart, lanEnd-lanStart, text->data, text->size);
     } else {
 		BUFPUTSL(ob, "<pre><code>");
         if(text)
@@ -225,6 +231,7 @@ static void
 rndr_header(struct buf *ob, const struct buf *text, const struct buf *id, int level, void *opaque)
 {
 	struct html_renderopt *options = opaque;
+	int toc_index = -1;
 
 	if (ob->size)
 		bufputc(ob, '\n');
@@ -234,11 +241,15 @@ rndr_header(struct buf *ob, const struct buf *text, const struct buf *id, int le
         bufput(ob, id->data, id->size);
         bufput(ob, "\">", 2);
     } else if (options->flags & HTML_TOC) {
-        bufprintf(ob, "<h%d id=\"toc_%d\">", level, options->toc_data.header_count++);
+        toc_index = options->toc_data.header_count++;
+        bufprintf(ob, "<h%d id=\"toc_%d\">", level, toc_index);
     }  else {
 		bufprintf(ob, "<h%d>", level);
     }
 
+    if (options->outline)
+        outline_add_header(options->outline, text, id, level, toc_index);
+
 	if (text) bufput(ob, text->data, text->size);
 	bufprintf(ob, "</h%d>\n", level);
 }
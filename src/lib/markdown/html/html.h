@@ -36,6 +36,13 @@ struct html_renderopt {
 
 	/* extra callbacks */
 	void (*link_attributes)(struct buf *ob, const struct buf *url, void *self);
+
+	/* when set, fenced code is queued here and a placeholder is written,
+	 * see HighlightBatch */
+	void *highlight_batch;
+
+	/* when set, every header is also added here, see MarkdownOutline */
+	void *outline;
 };
 
 typedef enum {
@@ -15,7 +15,7 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
-#define BUFFER_MAX_ALLOC_SIZE (1024 * 1024 * 16) //16mb
+#define BUFFER_MAX_ALLOC_SIZE ((size_t)-1 / 2) /* only guards against overflow */
 
 #include "buffer.h"
 
@@ -27,10 +27,21 @@
 /* MSVC compat */
 #if defined(_MSC_VER)
 #	define _buf_vsnprintf _vsnprintf
+#	define _buf_thread_local __declspec(thread)
 #else
 #	define _buf_vsnprintf vsnprintf
+#	define _buf_thread_local __thread
 #endif
 
+/* allocations done by the buffers of the calling thread */
+static _buf_thread_local size_t alloc_count = 0;
+
+size_t
+bufalloccount(void)
+{
+	return alloc_count;
+}
+
 int
 bufprefix(const struct buf *buf, const char *prefix)
 {
@@ -63,9 +74,13 @@ bufgrow(struct buf *buf, size_t neosz)
 	if (buf->asize >= neosz)
 		return BUF_OK;
 
-	neoasz = buf->asize + buf->unit;
-	while (neoasz < neosz)
-		neoasz += buf->unit;
+	/* grow by half of the allocated size, but at least by one unit, so
+	 * that appending n bytes costs O(log n) reallocations */
+	neoasz = buf->asize + (buf->asize >> 1);
+	if (neoasz < buf->asize + buf->unit)
+		neoasz = buf->asize + buf->unit;
+	if (neoasz < neosz)
+		neoasz = neosz + (buf->unit - neosz % buf->unit) % buf->unit;
 
 	neodata = realloc(buf->data, neoasz);
 	if (!neodata)
@@ -73,6 +88,7 @@ bufgrow(struct buf *buf, size_t neosz)
 
 	buf->data = neodata;
 	buf->asize = neoasz;
+	alloc_count++;
 	return BUF_OK;
 }
 
@@ -85,6 +101,7 @@ bufnew(size_t unit)
 	ret = malloc(sizeof (struct buf));
 
 	if (ret) {
+		alloc_count++;
 		ret->data = 0;
 		ret->size = ret->asize = 0;
 		ret->unit = unit;
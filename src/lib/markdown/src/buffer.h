@@ -89,6 +89,9 @@ void bufslurp(struct buf *, size_t);
 /* bufprintf: formatted printing to a buffer */
 void bufprintf(struct buf *, const char *, ...) __attribute__ ((format (printf, 2, 3)));
 
+/* bufalloccount: number of mallocs/reallocs done by buffers on the calling thread */
+size_t bufalloccount(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,10 +29,35 @@
 #define strncasecmp	_strnicmp
 #endif
 
-#define REF_TABLE_SIZE 8
+/* SSE2 is part of every x86-64 cpu, other targets use the scalar loops.
+ * AVX2 is built next to it and only used when the cpu has it */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SD_USE_SSE2 1
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(SD_USE_SSE2) && (defined(__clang__) || \
+	(defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))) || \
+	(defined(_MSC_VER) && _MSC_VER >= 1800))
+#define SD_USE_AVX2 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define SD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SD_TARGET_AVX2
+#endif
+#endif
+
+#define REF_TABLE_SIZE 8	/* initial size, the tables grow with the document */
 
 #define BUFFER_BLOCK 0
 #define BUFFER_SPAN 1
+#define BUFFER_FOOTNOTE 2	/* footnote contents, kept until the document ends */
+
+#define ARENA_CHUNK_SIZE 4096
 
 #define MKD_LI_END 8	/* internal list flag */
 
@@ -51,8 +76,25 @@ struct link_ref {
 
 	struct buf *link;
 	struct buf *title;
+};
+
+/* ref_table: open addressing table from the hash of an id to its item */
+struct ref_slot {
+	unsigned int id;
+	void *item;
+};
+
+struct ref_table {
+	struct ref_slot *slots;
+	size_t asize;	/* power of two, 0 until the first insert */
+	size_t size;
+};
 
-	struct link_ref *next;
+/* arena: memory which lives until the next document, the chunks are kept
+ * across renders so a reused sd_markdown stops allocating */
+struct arena {
+	struct stack chunks;	/* of struct buf */
+	size_t current;
 };
 /* footnote */
 struct footnote {
@@ -68,6 +110,8 @@ struct footnote_info{
     struct footnote* firstOne;
     struct footnote* lastOne;
     unsigned int count;
+    struct ref_table table; /* first definition of each id */
+    struct stack used; /* footnote with id n is at n-1 */
 };
 
 /* char_trigger: function pointer to render active chars */
@@ -121,17 +165,34 @@ static char_trigger markdown_char_ptrs[] = {
 };
 
 /* render • structure containing one particular render */
+/* line_skip • definition lines that sd_markdown_prepare left out of the text */
+struct line_skip {
+	size_t offset;	/* where they were, as an offset in the prepared text */
+	size_t lines;	/* number of lines left out up to there */
+};
+
 struct sd_markdown {
 	struct sd_callbacks	cb;
 	void *opaque;
 
-	struct link_ref *refs[REF_TABLE_SIZE];
+	struct ref_table refs;
     struct footnote_info fnInfo;
+	struct arena arena;
+	struct buf *text;
+	struct stack headers;	/* where the headers given to cb.header start */
+	struct line_skip *skips;
+	size_t skip_count;
+	size_t skip_asize;
 	uint8_t active_char[256];
-	struct stack work_bufs[2];
+	uint8_t active_low[16];	/* active char c <-> active_low[c & 15] & active_high[c >> 4] */
+	uint8_t active_high[16];
+	enum sd_scanner scanner;
+	struct stack work_bufs[3];
 	unsigned int ext_flags;
 	size_t max_nesting;
 	int in_link_body;
+	unsigned int def_hash;
+	int unbounded_block;
 };
 
 /***************************
@@ -141,7 +202,7 @@ struct sd_markdown {
 static inline struct buf *
 rndr_newbuf(struct sd_markdown *rndr, int type)
 {
-	static const size_t buf_size[2] = {256, 64};
+	static const size_t buf_size[3] = {256, 64, 64};
 	struct buf *work = NULL;
 	struct stack *pool = &rndr->work_bufs[type];
 
@@ -163,6 +224,233 @@ rndr_popbuf(struct sd_markdown *rndr, int type)
 	rndr->work_bufs[type].size--;
 }
 
+#ifdef SD_USE_SSE2
+static inline size_t
+first_bit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+/* line_end_sse2 • offset of the first '\n' or '\r', or where the 16 byte
+ * blocks end and the scalar loop has to go on. There is no sse2 version of
+ * the active char scan: without a byte shuffle it compares every block with
+ * every active char, which is slower than the active_char table */
+static size_t
+line_end_sse2(const uint8_t *data, size_t i, size_t size)
+{
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i cr = _mm_set1_epi8('\r');
+
+	for (; i + 16 <= size; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(
+			_mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+
+		if (mask)
+			return i + first_bit(mask);
+	}
+
+	return i;
+}
+#endif
+
+#ifdef SD_USE_AVX2
+static int
+cpu_has_avx2(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return 0;
+
+	/* the os has to save the ymm registers too */
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 ||
+		(_xgetbv(0) & 6) != 6)
+		return 0;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+/* active_char_avx2 • offset of the first char with an action, or where the
+ * 32 byte blocks end, looking the chars up in the nibble tables */
+static size_t SD_TARGET_AVX2
+active_char_avx2(const struct sd_markdown *rndr, const uint8_t *data, size_t i, size_t size)
+{
+	const __m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)rndr->active_low));
+	const __m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)rndr->active_high));
+	const __m256i nibble = _mm256_set1_epi8(0x0f);
+
+	for (; i + 32 <= size; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+		__m256i bits = _mm256_and_si256(
+			_mm256_shuffle_epi8(low, _mm256_and_si256(v, nibble)),
+			_mm256_shuffle_epi8(high, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble)));
+		unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(bits, _mm256_setzero_si256()));
+
+		if (mask)
+			return i + first_bit(mask);
+	}
+
+	return i;
+}
+
+/* line_end_avx2 • line_end_sse2 on 32 byte blocks */
+static size_t SD_TARGET_AVX2
+line_end_avx2(const uint8_t *data, size_t i, size_t size)
+{
+	const __m256i lf = _mm256_set1_epi8('\n');
+	const __m256i cr = _mm256_set1_epi8('\r');
+
+	for (; i + 32 <= size; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr)));
+
+		if (mask)
+			return i + first_bit(mask);
+	}
+
+	return i;
+}
+#endif
+
+/* find_active_char • offset of the first char with an action, or size */
+static inline size_t
+find_active_char(const struct sd_markdown *rndr, const uint8_t *data, size_t i, size_t size)
+{
+	switch (rndr->scanner) {
+#ifdef SD_USE_AVX2
+	case SD_SCANNER_AVX2:
+		i = active_char_avx2(rndr, data, i, size);
+		break;
+#endif
+	default:
+		break;
+	}
+
+	while (i < size && rndr->active_char[data[i]] == 0)
+		i++;
+
+	return i;
+}
+
+/* find_line_end • offset of the first '\n' or '\r', or size */
+static inline size_t
+find_line_end(const struct sd_markdown *rndr, const uint8_t *data, size_t i, size_t size)
+{
+	switch (rndr->scanner) {
+#ifdef SD_USE_AVX2
+	case SD_SCANNER_AVX2:
+		i = line_end_avx2(data, i, size);
+		break;
+#endif
+#ifdef SD_USE_SSE2
+	case SD_SCANNER_SSE2:
+		i = line_end_sse2(data, i, size);
+		break;
+#endif
+	default:
+		break;
+	}
+
+	while (i < size && data[i] != '\n' && data[i] != '\r')
+		i++;
+
+	return i;
+}
+
+static void *
+arena_alloc(struct arena *arena, size_t size)
+{
+	struct buf *chunk;
+	size_t chunk_size = ARENA_CHUNK_SIZE;
+
+	size = (size + 7) & ~(size_t)7;
+	while (arena->current < arena->chunks.size) {
+		chunk = arena->chunks.item[arena->current];
+		if (chunk->asize - chunk->size >= size) {
+			void *ptr = chunk->data + chunk->size;
+			chunk->size += size;
+			return ptr;
+		}
+		arena->current++;
+	}
+
+	/* every new chunk doubles the arena */
+	if (arena->chunks.size) {
+		chunk = arena->chunks.item[arena->chunks.size - 1];
+		chunk_size = chunk->asize * 2;
+	}
+	if (chunk_size < size)
+		chunk_size = size;
+
+	chunk = bufnew(ARENA_CHUNK_SIZE);
+	if (!chunk)
+		return NULL;
+	if (bufgrow(chunk, chunk_size) < 0 || stack_push(&arena->chunks, chunk) < 0) {
+		bufrelease(chunk);
+		return NULL;
+	}
+
+	arena->current = arena->chunks.size - 1;
+	chunk->size = size;
+	return chunk->data;
+}
+
+/* arena_reset • makes all chunks free again, without releasing them */
+static void
+arena_reset(struct arena *arena)
+{
+	size_t i;
+
+	for (i = 0; i < arena->chunks.size; ++i)
+		((struct buf *)arena->chunks.item[i])->size = 0;
+	arena->current = 0;
+}
+
+static void
+arena_free(struct arena *arena)
+{
+	size_t i;
+
+	for (i = 0; i < arena->chunks.size; ++i)
+		bufrelease(arena->chunks.item[i]);
+	stack_free(&arena->chunks);
+	arena->current = 0;
+}
+
+/* arena_buf • read-only copy of data in the arena */
+static struct buf *
+arena_buf(struct arena *arena, const uint8_t *data, size_t size)
+{
+	struct buf *b = arena_alloc(arena, sizeof(struct buf) + size);
+
+	if (!b)
+		return NULL;
+
+	b->data = (uint8_t *)(b + 1);
+	memcpy(b->data, data, size);
+	b->size = size;
+	b->asize = 0;
+	b->unit = 0;
+	return b;
+}
+
 static void
 unscape_text(struct buf *ob, struct buf *src)
 {
@@ -195,71 +483,147 @@ hash_link_ref(const uint8_t *link_ref, size_t length)
 	return hash;
 }
 
-static struct link_ref *
-add_link_ref(
-	struct link_ref **references,
-	const uint8_t *name, size_t name_size)
+static size_t
+ref_slot_index(const struct ref_table *table, unsigned int id)
 {
-	struct link_ref *ref = calloc(1, sizeof(struct link_ref));
+	id ^= id >> 16;
+	return (id * 2654435761u) & (table->asize - 1);
+}
 
-	if (!ref)
-		return NULL;
+static int
+ref_table_grow(struct ref_table *table, size_t new_asize)
+{
+	struct ref_slot *old_slots = table->slots;
+	size_t old_asize = table->asize, i;
 
-	ref->id = hash_link_ref(name, name_size);
-	ref->next = references[ref->id % REF_TABLE_SIZE];
+	table->slots = calloc(new_asize, sizeof(struct ref_slot));
+	if (!table->slots) {
+		table->slots = old_slots;
+		return -1;
+	}
+	table->asize = new_asize;
+
+	for (i = 0; i < old_asize; ++i) {
+		if (old_slots[i].item) {
+			size_t n = ref_slot_index(table, old_slots[i].id);
+			while (table->slots[n].item)
+				n = (n + 1) & (new_asize - 1);
+			table->slots[n] = old_slots[i];
+		}
+	}
 
-	references[ref->id % REF_TABLE_SIZE] = ref;
-	return ref;
+	free(old_slots);
+	return 0;
 }
 
-static struct link_ref *
-find_link_ref(struct link_ref **references, uint8_t *name, size_t length)
+static void *
+ref_table_find(const struct ref_table *table, unsigned int id)
 {
-	unsigned int hash = hash_link_ref(name, length);
-	struct link_ref *ref = NULL;
-
-	ref = references[hash % REF_TABLE_SIZE];
+	size_t n;
 
-	while (ref != NULL) {
-		if (ref->id == hash)
-			return ref;
+	if (!table->size)
+		return NULL;
 
-		ref = ref->next;
+	n = ref_slot_index(table, id);
+	while (table->slots[n].item) {
+		if (table->slots[n].id == id)
+			return table->slots[n].item;
+		n = (n + 1) & (table->asize - 1);
 	}
 
 	return NULL;
 }
 
+/* ref_table_insert • adds an item whose id is not in the table yet */
+static int
+ref_table_insert(struct ref_table *table, unsigned int id, void *item)
+{
+	size_t n;
+
+	/* keep the load under one half so that probe runs stay short */
+	if ((table->size + 1) * 2 > table->asize &&
+		ref_table_grow(table, table->asize ? table->asize * 2 : REF_TABLE_SIZE) < 0)
+		return -1;
+
+	n = ref_slot_index(table, id);
+	while (table->slots[n].item)
+		n = (n + 1) & (table->asize - 1);
+
+	table->slots[n].id = id;
+	table->slots[n].item = item;
+	table->size++;
+	return 0;
+}
+
+/* ref_table_clear • empties the table, keeping its slots for the next document */
 static void
-free_link_refs(struct link_ref **references)
+ref_table_clear(struct ref_table *table)
 {
-	size_t i;
+	if (table->size)
+		memset(table->slots, 0x0, table->asize * sizeof(struct ref_slot));
+	table->size = 0;
+}
 
-	for (i = 0; i < REF_TABLE_SIZE; ++i) {
-		struct link_ref *r = references[i];
-		struct link_ref *next;
+static void
+ref_table_free(struct ref_table *table)
+{
+	free(table->slots);
+	table->slots = NULL;
+	table->asize = 0;
+	table->size = 0;
+}
 
-		while (r) {
-			next = r->next;
-			bufrelease(r->link);
-			bufrelease(r->title);
-			free(r);
-			r = next;
-		}
+/* add_link_ref • a later definition of the same id replaces the earlier one */
+static struct link_ref *
+add_link_ref(
+	struct sd_markdown *md,
+	const uint8_t *name, size_t name_size)
+{
+	unsigned int id = hash_link_ref(name, name_size);
+	struct link_ref *ref = ref_table_find(&md->refs, id);
+
+	if (ref) {
+		ref->link = NULL;
+		ref->title = NULL;
+		return ref;
 	}
+
+	ref = arena_alloc(&md->arena, sizeof(struct link_ref));
+	if (!ref)
+		return NULL;
+
+	memset(ref, 0x0, sizeof(struct link_ref));
+	ref->id = id;
+	if (ref_table_insert(&md->refs, id, ref) < 0)
+		return NULL;
+
+	return ref;
+}
+
+static struct link_ref *
+find_link_ref(struct ref_table *references, uint8_t *name, size_t length)
+{
+	return ref_table_find(references, hash_link_ref(name, length));
 }
 
 static struct footnote *
 add_footnote(
-        struct footnote_info *footnoteInfo,
+        struct sd_markdown *md,
         const uint8_t *name, size_t name_size){
-    struct footnote *fn = calloc(1, sizeof(struct footnote));
+    struct footnote_info *footnoteInfo = &md->fnInfo;
+    struct footnote *fn = arena_alloc(&md->arena, sizeof(struct footnote));
     if(!fn)
         return NULL;
+    fn->content = NULL;
     fn->hashId = hash_link_ref(name, name_size);
     fn->id = 0;
     fn->is_used = 0;
     fn->next = NULL;
+    //only the first definition of an id can be referenced
+    if(!ref_table_find(&footnoteInfo->table, fn->hashId) &&
+            ref_table_insert(&footnoteInfo->table, fn->hashId, fn)<0){
+        return NULL;
+    }
     if(!footnoteInfo->firstOne){
         footnoteInfo->firstOne = fn;
     } else {
@@ -271,36 +635,77 @@ add_footnote(
 
 static struct footnote *
 find_footnote(struct footnote_info *footnoteHead, uint8_t *name, size_t length){
-    unsigned int hash = hash_link_ref(name, length);
-    struct footnote *fn = footnoteHead->firstOne;
-    while(fn){
-        if(fn->hashId==hash)
-            return fn;
-        fn = fn->next;
-    }
-    return NULL;
+    return ref_table_find(&footnoteHead->table, hash_link_ref(name, length));
+}
+
+/* use_footnote • numbers a footnote at its first reference */
+static int
+use_footnote(struct footnote_info *footnoteHead, struct footnote *fn){
+    if(stack_push(&footnoteHead->used, fn)<0)
+        return -1;
+    fn->id = ++footnoteHead->count;
+    fn->is_used = 1;
+    return 0;
 }
 
+/* reset_definitions • forgets the references and footnotes of the last
+ * document, their memory is kept for the next one */
 static void
-free_footnotes(struct footnote_info *footnoteHead){
-    struct footnote *start = footnoteHead->firstOne;
-    struct footnote *next;
-    while(start){
-        next = start->next;
-        bufrelease(start->content);
-        free(start);
-        start = next;
-    }
-    footnoteHead->firstOne = NULL;
-    footnoteHead->lastOne = NULL;
-    footnoteHead->count = 0;
+reset_definitions(struct sd_markdown *md){
+    ref_table_clear(&md->refs);
+    md->fnInfo.firstOne = NULL;
+    md->fnInfo.lastOne = NULL;
+    md->fnInfo.count = 0;
+    ref_table_clear(&md->fnInfo.table);
+    md->fnInfo.used.size = 0;
+    md->work_bufs[BUFFER_FOOTNOTE].size = 0;
+    arena_reset(&md->arena);
+}
+
+/* hash_definition • folds a reference/footnote definition into the running hash */
+static unsigned int
+hash_definition(unsigned int hash, const uint8_t *data, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; ++i)
+		hash = (hash ^ data[i]) * 16777619u;
+
+	return (hash ^ '\n') * 16777619u;
 }
 
+/* skip_lines • records that the definition in data is left out of the
+ * prepared text at offset */
 static void
-free_single_footnote(struct footnote *fn){
-    bufrelease(fn->content);
-    free(fn);
-    fn = NULL;
+skip_lines(struct sd_markdown *md, size_t offset, const uint8_t *data, size_t size)
+{
+	size_t i, lines = 0;
+
+	/* counted like sd_markdown_prepare copies line ends: "\r\n" is one */
+	for (i = 0; i < size; ++i)
+		if (data[i] == '\n' || (data[i] == '\r' && (i + 1 >= size || data[i + 1] != '\n')))
+			lines++;
+	if (!lines)
+		return;
+
+	if (md->skip_count && md->skips[md->skip_count - 1].offset == offset) {
+		md->skips[md->skip_count - 1].lines += lines;
+		return;
+	}
+
+	if (md->skip_count == md->skip_asize) {
+		size_t new_asize = md->skip_asize ? md->skip_asize * 2 : 16;
+		struct line_skip *new_skips = realloc(md->skips, new_asize * sizeof(struct line_skip));
+		if (!new_skips)
+			return;
+		md->skips = new_skips;
+		md->skip_asize = new_asize;
+	}
+
+	md->skips[md->skip_count].offset = offset;
+	md->skips[md->skip_count].lines = lines +
+		(md->skip_count ? md->skips[md->skip_count - 1].lines : 0);
+	md->skip_count++;
 }
 
 
@@ -433,9 +838,9 @@ parse_inline(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t siz
 
 	while (i < size) {
 		/* copying inactive chars into the output */
-		while (end < size && (action = rndr->active_char[data[end]]) == 0) {
-			end++;
-		}
+		end = find_active_char(rndr, data, end, size);
+		if (end < size)
+			action = rndr->active_char[data[end]];
 
 		if (rndr->cb.normal_text) {
 			work.data = data + i;
@@ -956,9 +1361,7 @@ char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset
         id.data = data+1;
         id.size = txt_e - 1;
         fn = find_footnote(&rndr->fnInfo, id.data, id.size);
-        if(fn && !fn->is_used){
-            fn->id = ++rndr->fnInfo.count;
-            fn->is_used = 1;
+        if(fn && !fn->is_used && use_footnote(&rndr->fnInfo, fn)==0){
             ret = rndr->cb.footnote_link(ob, fn->id);
             goto cleanup;
         }
@@ -1070,7 +1473,7 @@ char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset
 			id.size = link_e - link_b;
 		}
 
-		lr = find_link_ref(rndr->refs, id.data, id.size);
+		lr = find_link_ref(&rndr->refs, id.data, id.size);
 		if (!lr)
 			goto cleanup;
 
@@ -1105,7 +1508,7 @@ char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset
 		}
 
 		/* finding the link_ref */
-		lr = find_link_ref(rndr->refs, id.data, id.size);
+		lr = find_link_ref(&rndr->refs, id.data, id.size);
 		if (!lr)
 			goto cleanup;
 
@@ -1619,8 +2022,10 @@ parse_paragraph(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 		header_work = rndr_newbuf(rndr, BUFFER_SPAN);
 		parse_inline(header_work, rndr, work.data, work.size);
 
-		if (rndr->cb.header)
+		if (rndr->cb.header) {
+			stack_push(&rndr->headers, work.data);
             rndr->cb.header(ob, header_work, id, (int)level, rndr->opaque);
+		}
 
 		rndr_popbuf(rndr, BUFFER_SPAN);
         if(id)
@@ -1922,8 +2327,10 @@ parse_atxheader(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 
 		parse_inline(work, rndr, data + i, end - i);
 
-		if (rndr->cb.header)
+		if (rndr->cb.header) {
+			stack_push(&rndr->headers, data);
             rndr->cb.header(ob, work, id, (int)level, rndr->opaque);
+		}
 
 		rndr_popbuf(rndr, BUFFER_SPAN);
 	}
@@ -2047,6 +2454,9 @@ parse_htmlblock(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 					rndr->cb.blockhtml(ob, &work, rndr->opaque);
 				return work.size;
 			}
+
+			/* the end of the comment was searched up to the end of the data */
+			rndr->unbounded_block = 1;
 		}
 
 		/* HR, which is the only self-closing block tag considered */
@@ -2081,8 +2491,11 @@ parse_htmlblock(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 		tag_end = htmlblock_end(curtag, rndr, data, size, 0);
 	}
 
-	if (!tag_end)
+	if (!tag_end) {
+		/* the closing tag was searched up to the end of the data */
+		rndr->unbounded_block = 1;
 		return 0;
+	}
 
 	/* the end of the block has been found */
 	work.size = tag_end;
@@ -2296,65 +2709,68 @@ parse_table(
 	return i;
 }
 
-/* parse_block • parsing of one block, returning next uint8_t to parse */
-static void
-parse_block(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size)
+/* parse_block_step • parsing of the block starting at data, returning its size */
+static size_t
+parse_block_step(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size)
 {
-	size_t beg, end, i;
-	uint8_t *txt_data;
-	beg = 0;
+	size_t i;
 
-	if (rndr->work_bufs[BUFFER_SPAN].size +
-		rndr->work_bufs[BUFFER_BLOCK].size > rndr->max_nesting)
-		return;
+	if (is_atxheader(rndr, data, size))
+		return parse_atxheader(ob, rndr, data, size);
 
-	while (beg < size) {
-		txt_data = data + beg;
-		end = size - beg;
+	if (data[0] == '<' && rndr->cb.blockhtml &&
+			(i = parse_htmlblock(ob, rndr, data, size, 1)) != 0)
+		return i;
 
-		if (is_atxheader(rndr, txt_data, end))
-			beg += parse_atxheader(ob, rndr, txt_data, end);
+	if ((i = is_empty(data, size)) != 0)
+		return i;
 
-		else if (data[beg] == '<' && rndr->cb.blockhtml &&
-				(i = parse_htmlblock(ob, rndr, txt_data, end, 1)) != 0)
-			beg += i;
+	if (is_hrule(data, size)) {
+		if (rndr->cb.hrule)
+			rndr->cb.hrule(ob, rndr->opaque);
 
-		else if ((i = is_empty(txt_data, end)) != 0)
-			beg += i;
+		i = 0;
+		while (i < size && data[i] != '\n')
+			i++;
 
-		else if (is_hrule(txt_data, end)) {
-			if (rndr->cb.hrule)
-				rndr->cb.hrule(ob, rndr->opaque);
+		return i + 1;
+	}
 
-			while (beg < size && data[beg] != '\n')
-				beg++;
+	if ((rndr->ext_flags & MKDEXT_FENCED_CODE) != 0 &&
+		(i = parse_fencedcode(ob, rndr, data, size)) != 0)
+		return i;
 
-			beg++;
-		}
+	if ((rndr->ext_flags & MKDEXT_TABLES) != 0 &&
+		(i = parse_table(ob, rndr, data, size)) != 0)
+		return i;
 
-		else if ((rndr->ext_flags & MKDEXT_FENCED_CODE) != 0 &&
-			(i = parse_fencedcode(ob, rndr, txt_data, end)) != 0)
-			beg += i;
+	if (prefix_quote(data, size))
+		return parse_blockquote(ob, rndr, data, size);
 
-		else if ((rndr->ext_flags & MKDEXT_TABLES) != 0 &&
-			(i = parse_table(ob, rndr, txt_data, end)) != 0)
-			beg += i;
+	if (prefix_code(data, size))
+		return parse_blockcode(ob, rndr, data, size);
 
-		else if (prefix_quote(txt_data, end))
-			beg += parse_blockquote(ob, rndr, txt_data, end);
+	if (prefix_uli(data, size))
+		return parse_list(ob, rndr, data, size, 0);
 
-		else if (prefix_code(txt_data, end))
-			beg += parse_blockcode(ob, rndr, txt_data, end);
+	if (prefix_oli(data, size))
+		return parse_list(ob, rndr, data, size, MKD_LIST_ORDERED);
 
-		else if (prefix_uli(txt_data, end))
-			beg += parse_list(ob, rndr, txt_data, end, 0);
+	return parse_paragraph(ob, rndr, data, size);
+}
 
-		else if (prefix_oli(txt_data, end))
-			beg += parse_list(ob, rndr, txt_data, end, MKD_LIST_ORDERED);
+/* parse_block • parsing of one block, returning next uint8_t to parse */
+static void
+parse_block(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size)
+{
+	size_t beg = 0;
 
-		else
-			beg += parse_paragraph(ob, rndr, txt_data, end);
-	}
+	if (rndr->work_bufs[BUFFER_SPAN].size +
+		rndr->work_bufs[BUFFER_BLOCK].size > rndr->max_nesting)
+		return;
+
+	while (beg < size)
+		beg += parse_block_step(ob, rndr, data + beg, size - beg);
 }
 
 /********************
@@ -2466,10 +2882,11 @@ is_footnote(const uint8_t *data, size_t beg, size_t end, size_t *last,
     if(md){
         size_t size = contentEnd;
         size_t begin = contentStart, cend;
-        struct buf *mdContent = bufnew(idEnd-idStart);
-        struct footnote *fn = add_footnote(&md->fnInfo, data + idStart, idEnd - idStart);
+        struct buf *mdContent;
+        struct footnote *fn = add_footnote(md, data + idStart, idEnd - idStart);
         if (!fn)
             return 0;
+        mdContent = rndr_newbuf(md, BUFFER_FOOTNOTE);
 
         while(begin<size){
             cend = begin;
@@ -2500,7 +2917,7 @@ is_footnote(const uint8_t *data, size_t beg, size_t end, size_t *last,
 
 /* is_ref • returns whether a line is a reference or not */
 static int
-is_ref(const uint8_t *data, size_t beg, size_t end, size_t *last, struct link_ref **refs)
+is_ref(const uint8_t *data, size_t beg, size_t end, size_t *last, struct sd_markdown *md)
 {
 /*	int n; */
 	size_t i = 0;
@@ -2595,20 +3012,17 @@ is_ref(const uint8_t *data, size_t beg, size_t end, size_t *last, struct link_re
 	if (last)
 		*last = line_end;
 
-	if (refs) {
+	if (md) {
 		struct link_ref *ref;
 
-		ref = add_link_ref(refs, data + id_offset, id_end - id_offset);
+		ref = add_link_ref(md, data + id_offset, id_end - id_offset);
 		if (!ref)
 			return 0;
 
-		ref->link = bufnew(link_end - link_offset);
-		bufput(ref->link, data + link_offset, link_end - link_offset);
+		ref->link = arena_buf(&md->arena, data + link_offset, link_end - link_offset);
 
-		if (title_end > title_offset) {
-			ref->title = bufnew(title_end - title_offset);
-			bufput(ref->title, data + title_offset, title_end - title_offset);
-		}
+		if (title_end > title_offset)
+			ref->title = arena_buf(&md->arena, data + title_offset, title_end - title_offset);
 	}
 
 	return 1;
@@ -2620,10 +3034,10 @@ static void expand_tabs(struct buf *ob, const uint8_t *line, size_t size)
 
 	while (i < size) {
 		size_t org = i;
+		const uint8_t *next_tab = memchr(line + i, '\t', size - i);
 
-		while (i < size && line[i] != '\t') {
-			i++; tab++;
-		}
+		i = next_tab ? (size_t)(next_tab - line) : size;
+		tab += i - org;
 
 		if (i > org)
 			bufput(ob, line + org, i - org);
@@ -2651,6 +3065,7 @@ sd_markdown_new(
 	void *opaque)
 {
 	struct sd_markdown *md = NULL;
+	size_t i;
 
 	assert(max_nesting > 0 && callbacks);
 
@@ -2662,6 +3077,18 @@ sd_markdown_new(
 
 	stack_init(&md->work_bufs[BUFFER_BLOCK], 4);
 	stack_init(&md->work_bufs[BUFFER_SPAN], 8);
+	stack_init(&md->work_bufs[BUFFER_FOOTNOTE], 8);
+	stack_init(&md->arena.chunks, 8);
+	md->arena.current = 0;
+	md->text = NULL;
+	stack_init(&md->headers, 8);
+	md->skips = NULL;
+	md->skip_count = 0;
+	md->skip_asize = 0;
+
+	memset(&md->refs, 0x0, sizeof(struct ref_table));
+	memset(&md->fnInfo, 0x0, sizeof(struct footnote_info));
+	stack_init(&md->fnInfo.used, 8);
 
 	memset(md->active_char, 0x0, 256);
 
@@ -2694,38 +3121,47 @@ sd_markdown_new(
 	if (extensions & MKDEXT_SUPERSCRIPT)
 		md->active_char['^'] = MD_CHAR_SUPERSCRIPT;
 
+	/* the active chars are ascii, a bit per high nibble is enough */
+	memset(md->active_low, 0, sizeof md->active_low);
+	memset(md->active_high, 0, sizeof md->active_high);
+	for (i = 0; i < 256; ++i) {
+		if (md->active_char[i]) {
+			assert(i < 0x80);
+			md->active_low[i & 15] |= (uint8_t)(1 << (i >> 4));
+		}
+	}
+	for (i = 0; i < 8; ++i)
+		md->active_high[i] = (uint8_t)(1 << i);
+
+	md->scanner = sd_scanner_best();
+
 	/* Extension data */
 	md->ext_flags = extensions;
 	md->opaque = opaque;
 	md->max_nesting = max_nesting;
 	md->in_link_body = 0;
+	md->def_hash = 0;
+	md->unbounded_block = 0;
 
 	return md;
 }
 
-void
-sd_markdown_render(struct buf *ob, const uint8_t *document, size_t doc_size, struct sd_markdown *md)
+unsigned int
+sd_markdown_prepare(struct buf *text, const uint8_t *document, size_t doc_size, struct sd_markdown *md)
 {
-#define MARKDOWN_GROW(x) ((x) + ((x) >> 1))
 	static const char UTF8_BOM[] = {0xEF, 0xBB, 0xBF};
 
-	struct buf *text;
 	size_t beg, end;
     size_t fence_code_area=0;
 
-	text = bufnew(64);
-	if (!text)
-		return;
-
 	/* Preallocate enough space for our buffer to avoid expanding while copying */
 	bufgrow(text, doc_size);
 
-	/* reset the references table */
-	memset(&md->refs, 0x0, REF_TABLE_SIZE * sizeof(void *));
-    /* reset the footnote list */
-    md->fnInfo.firstOne = NULL;
-    md->fnInfo.lastOne = NULL;
-    md->fnInfo.count = 0;
+	/* reset the references table and the footnote list */
+	reset_definitions(md);
+	md->def_hash = 2166136261u;
+	md->headers.size = 0;
+	md->skip_count = 0;
 
 	/* first pass: looking for references, copying everything else */
 	beg = 0;
@@ -2736,17 +3172,19 @@ sd_markdown_render(struct buf *ob, const uint8_t *document, size_t doc_size, str
 		beg += 3;
 
 	while (beg < doc_size) /* iterating over lines */
-        if ((md->ext_flags & MKDEXT_FOOTNOTE) &&(!fence_code_area)&& is_footnote(document, beg, doc_size, &end, md))
+        if ((md->ext_flags & MKDEXT_FOOTNOTE) &&(!fence_code_area)&& is_footnote(document, beg, doc_size, &end, md)) {
+            md->def_hash = hash_definition(md->def_hash, document + beg, end - beg);
+            skip_lines(md, text->size, document + beg, end - beg);
             beg = end;
-        else if ((!fence_code_area)&&is_ref(document, beg, doc_size, &end, md->refs))
+        } else if ((!fence_code_area)&&is_ref(document, beg, doc_size, &end, md)) {
+			md->def_hash = hash_definition(md->def_hash, document + beg, end - beg);
+			skip_lines(md, text->size, document + beg, end - beg);
 			beg = end;
-		else { /* skipping to the next line */
+		} else { /* skipping to the next line */
             if((md->ext_flags & MKDEXT_FOOTNOTE) && (is_codefence(document+beg, doc_size-beg, NULL)!=0)){
                 fence_code_area ^= 1;
             }
-			end = beg;
-			while (end < doc_size && document[end] != '\n' && document[end] != '\r')
-				end++;
+			end = find_line_end(md, document, beg, doc_size);
 
 			/* adding the line body if present */
 			if (end > beg)
@@ -2762,49 +3200,90 @@ sd_markdown_render(struct buf *ob, const uint8_t *document, size_t doc_size, str
 			beg = end;
 		}
 
-	/* pre-grow the output buffer to minimize allocations */
-	bufgrow(ob, MARKDOWN_GROW(text->size));
+	/* adding a final newline if not already present */
+	if (text->size && text->data[text->size - 1] != '\n' &&  text->data[text->size - 1] != '\r')
+		bufputc(text, '\n');
 
-	/* second pass: actual rendering */
-	if (md->cb.doc_header)
-		md->cb.doc_header(ob, md->opaque);
+	return md->def_hash;
+}
 
-	if (text->size) {
-		/* adding a final newline if not already present */
-		if (text->data[text->size - 1] != '\n' &&  text->data[text->size - 1] != '\r')
-			bufputc(text, '\n');
+size_t
+sd_markdown_render_block(struct buf *ob, const uint8_t *data, size_t size, struct sd_markdown *md, int *unbounded)
+{
+	size_t consumed;
 
-		parse_block(ob, md, text->data, text->size);
+	md->unbounded_block = 0;
+	consumed = parse_block_step(ob, md, (uint8_t *)data, size);
+	if (unbounded)
+		*unbounded = md->unbounded_block;
+
+	return consumed < size ? consumed : size;
+}
+
+int
+sd_markdown_has_footnotes(const struct sd_markdown *md)
+{
+	return md->fnInfo.firstOne != NULL;
+}
+
+const struct buf *
+sd_markdown_text(const struct sd_markdown *md)
+{
+	return md->text;
+}
+
+size_t
+sd_markdown_header_count(const struct sd_markdown *md)
+{
+	return md->headers.size;
+}
+
+size_t
+sd_markdown_header_offset(const struct sd_markdown *md, size_t i, const uint8_t *data, size_t size)
+{
+	const uint8_t *header = md->headers.item[i];
+
+	if (header < data || header >= data + size)
+		return (size_t)-1;
+	return header - data;
+}
+
+size_t
+sd_markdown_source_line(const struct sd_markdown *md, size_t offset, size_t line)
+{
+	size_t low = 0, high = md->skip_count;
+
+	/* the last skip at or before offset */
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (md->skips[mid].offset <= offset)
+			low = mid + 1;
+		else
+			high = mid;
 	}
+
+	return low ? line + md->skips[low - 1].lines : line;
+}
+
+void
+sd_markdown_finish(struct buf *ob, struct sd_markdown *md)
+{
     //footnote bottom content
-    if (md->cb.footnote_bottom_content_list_item && md->cb.list && (md->ext_flags&MKDEXT_FOOTNOTE) && md->fnInfo.firstOne){
+    if (ob && md->cb.footnote_bottom_content_list_item && md->cb.list && (md->ext_flags&MKDEXT_FOOTNOTE) && md->fnInfo.firstOne){
         struct buf *footnoteListItems = rndr_newbuf(md, BUFFER_BLOCK);
-        unsigned int i=0;
-        for(i=1; i<=md->fnInfo.count; i++){
-            struct footnote *prev = NULL;
-            struct footnote *f = md->fnInfo.firstOne;
-            while(f){
-                if(f->id == i){
-                    if(f->content->size){
-                        struct buf *mdHtml = rndr_newbuf(md, BUFFER_BLOCK);
-                        if(mdHtml){
-                            bufprintf(f->content, "<a href=\"#fnref:%d\" rev=\"footnote\">&#8617;</a>\n", f->id);
-                            parse_block(mdHtml, md, f->content->data, f->content->size);
-                            md->cb.footnote_bottom_content_list_item(footnoteListItems, f->id, mdHtml);
-                            rndr_popbuf(md, BUFFER_BLOCK);
-                        }
-                    }
-                    if(f==md->fnInfo.firstOne){
-                        md->fnInfo.firstOne = f->next;
-                    } else {
-                        assert(prev);
-                        prev->next = f->next;
-                    }
-                    free_single_footnote(f);
-                    break;
+        size_t i;
+        /* the footnote bottom can reference more footnotes, which are
+         * appended to the used list while it is walked */
+        for(i=0; i<md->fnInfo.used.size; i++){
+            struct footnote *f = md->fnInfo.used.item[i];
+            if(f->content->size){
+                struct buf *mdHtml = rndr_newbuf(md, BUFFER_BLOCK);
+                if(mdHtml){
+                    bufprintf(f->content, "<a href=\"#fnref:%d\" rev=\"footnote\">&#8617;</a>\n", f->id);
+                    parse_block(mdHtml, md, f->content->data, f->content->size);
+                    md->cb.footnote_bottom_content_list_item(footnoteListItems, f->id, mdHtml);
+                    rndr_popbuf(md, BUFFER_BLOCK);
                 }
-                prev = f;
-                f = f->next;
             }
         }
         bufputs(ob, "<div class=\"footnotes\"><hr />");
@@ -2813,18 +3292,45 @@ sd_markdown_render(struct buf *ob, const uint8_t *document, size_t doc_size, str
         bufputs(ob, "</div>");
     }
 
-	if (md->cb.doc_footer)
+	if (ob && md->cb.doc_footer)
 		md->cb.doc_footer(ob, md->opaque);
 
 	/* clean-up */
-	bufrelease(text);
-	free_link_refs(md->refs);
-    free_footnotes(&md->fnInfo);
+	reset_definitions(md);
 
 	assert(md->work_bufs[BUFFER_SPAN].size == 0);
 	assert(md->work_bufs[BUFFER_BLOCK].size == 0);
 }
 
+void
+sd_markdown_render(struct buf *ob, const uint8_t *document, size_t doc_size, struct sd_markdown *md)
+{
+#define MARKDOWN_GROW(x) ((x) + ((x) >> 1))
+	struct buf *text;
+
+	/* the prepared text is kept for the next document */
+	if (!md->text)
+		md->text = bufnew(64);
+	text = md->text;
+	if (!text)
+		return;
+	text->size = 0;
+
+	sd_markdown_prepare(text, document, doc_size, md);
+
+	/* pre-grow the output buffer to minimize allocations */
+	bufgrow(ob, MARKDOWN_GROW(text->size));
+
+	/* second pass: actual rendering */
+	if (md->cb.doc_header)
+		md->cb.doc_header(ob, md->opaque);
+
+	if (text->size)
+		parse_block(ob, md, text->data, text->size);
+
+	sd_markdown_finish(ob, md);
+}
+
 void
 sd_markdown_free(struct sd_markdown *md)
 {
@@ -2836,12 +3342,95 @@ sd_markdown_free(struct sd_markdown *md)
 	for (i = 0; i < (size_t)md->work_bufs[BUFFER_BLOCK].asize; ++i)
 		bufrelease(md->work_bufs[BUFFER_BLOCK].item[i]);
 
+	for (i = 0; i < (size_t)md->work_bufs[BUFFER_FOOTNOTE].asize; ++i)
+		bufrelease(md->work_bufs[BUFFER_FOOTNOTE].item[i]);
+
 	stack_free(&md->work_bufs[BUFFER_SPAN]);
 	stack_free(&md->work_bufs[BUFFER_BLOCK]);
+	stack_free(&md->work_bufs[BUFFER_FOOTNOTE]);
+	arena_free(&md->arena);
+	bufrelease(md->text);
+	stack_free(&md->headers);
+	free(md->skips);
+
+	ref_table_free(&md->refs);
+	ref_table_free(&md->fnInfo.table);
+	stack_free(&md->fnInfo.used);
 
 	free(md);
 }
 
+int
+sd_scanner_supported(enum sd_scanner scanner)
+{
+	switch (scanner) {
+	case SD_SCANNER_SCALAR:
+		return 1;
+#ifdef SD_USE_SSE2
+	case SD_SCANNER_SSE2:
+		return 1;
+#endif
+#ifdef SD_USE_AVX2
+	case SD_SCANNER_AVX2:
+		return cpu_has_avx2();
+#endif
+	default:
+		return 0;
+	}
+}
+
+enum sd_scanner
+sd_scanner_best(void)
+{
+	if (sd_scanner_supported(SD_SCANNER_AVX2))
+		return SD_SCANNER_AVX2;
+	if (sd_scanner_supported(SD_SCANNER_SSE2))
+		return SD_SCANNER_SSE2;
+	return SD_SCANNER_SCALAR;
+}
+
+int
+sd_markdown_set_scanner(struct sd_markdown *md, enum sd_scanner scanner)
+{
+	if (!sd_scanner_supported(scanner))
+		return 0;
+
+	md->scanner = scanner;
+	return 1;
+}
+
+size_t
+sd_markdown_scan(const struct sd_markdown *md, enum sd_scan scan, const uint8_t *data, size_t size)
+{
+	size_t i = 0, count = 0;
+
+	while (i < size) {
+		switch (scan) {
+		case SD_SCAN_ACTIVE_CHAR:
+			i = find_active_char(md, data, i, size);
+			break;
+		case SD_SCAN_LINE_END:
+			i = find_line_end(md, data, i, size);
+			break;
+		default: {
+			/* expand_tabs leaves the tabs to memchr whatever the scanner,
+			 * libc picks a vector version of its own and beats the loops
+			 * above even on short lines */
+			const uint8_t *tab = memchr(data + i, '\t', size - i);
+			i = tab ? (size_t)(tab - data) : size;
+			break;
+		}
+		}
+
+		if (i < size) {
+			count++;
+			i++;
+		}
+	}
+
+	return count;
+}
+
 void
 sd_version(int *ver_major, int *ver_minor, int *ver_revision)
 {
@@ -67,6 +67,21 @@ enum mkd_extensions {
     MKDEXT_FOOTNOTE = (1 << 13)//ok
 };
 
+/* sd_scanner - the byte scans of the parser, sd_markdown_new picks the
+ * fastest one the cpu runs */
+enum sd_scanner {
+	SD_SCANNER_SCALAR,
+	SD_SCANNER_SSE2,
+	SD_SCANNER_AVX2
+};
+
+/* sd_scan - the scans sd_markdown_scan can run */
+enum sd_scan {
+	SD_SCAN_ACTIVE_CHAR,	/* chars with an inline action */
+	SD_SCAN_LINE_END,	/* '\n' or '\r' */
+	SD_SCAN_TAB		/* tabs to expand */
+};
+
 /* sd_callbacks - functions for rendering parsed data */
 struct sd_callbacks {
 	/* block level callbacks - NULL skips the block */
@@ -133,9 +148,70 @@ sd_markdown_new(
 extern void
 sd_markdown_render(struct buf *ob, const uint8_t *document, size_t doc_size, struct sd_markdown *md);
 
+/* sd_markdown_prepare • first pass of sd_markdown_render: collects the
+ * references and footnotes and copies everything else into text.
+ * returns a hash of all the reference and footnote definitions */
+extern unsigned int
+sd_markdown_prepare(struct buf *text, const uint8_t *document, size_t doc_size, struct sd_markdown *md);
+
+/* sd_markdown_render_block • renders the top-level block starting at data
+ * (which must point into the text filled by sd_markdown_prepare).
+ * returns the size of the block; unbounded is set when the parser had to
+ * look up to the end of data to find where the block stops */
+extern size_t
+sd_markdown_render_block(struct buf *ob, const uint8_t *data, size_t size, struct sd_markdown *md, int *unbounded);
+
+extern int
+sd_markdown_has_footnotes(const struct sd_markdown *md);
+
+/* sd_markdown_text • the text prepared by the last sd_markdown_render */
+extern const struct buf *
+sd_markdown_text(const struct sd_markdown *md);
+
+/* sd_markdown_header_count • number of headers given to the header
+ * callback since the last sd_markdown_prepare, in callback order */
+extern size_t
+sd_markdown_header_count(const struct sd_markdown *md);
+
+/* sd_markdown_header_offset • offset of the i-th header in data, (size_t)-1
+ * when it is not there. Headers nested in quotes, lists or footnotes are
+ * parsed from copies and are never in the prepared text */
+extern size_t
+sd_markdown_header_offset(const struct sd_markdown *md, size_t i, const uint8_t *data, size_t size);
+
+/* sd_markdown_source_line • turns the line of offset in the prepared text
+ * into the line of the document, counting the definition lines that
+ * sd_markdown_prepare removed */
+extern size_t
+sd_markdown_source_line(const struct sd_markdown *md, size_t offset, size_t line);
+
+/* sd_markdown_finish • renders the footnotes and the footer, then frees the
+ * tables built by sd_markdown_prepare. ob may be NULL to only free them */
+extern void
+sd_markdown_finish(struct buf *ob, struct sd_markdown *md);
+
 extern void
 sd_markdown_free(struct sd_markdown *md);
 
+/* sd_scanner_supported • whether this build and this cpu can run scanner */
+extern int
+sd_scanner_supported(enum sd_scanner scanner);
+
+/* sd_scanner_best • the fastest supported scanner */
+extern enum sd_scanner
+sd_scanner_best(void);
+
+/* sd_markdown_set_scanner • forces the scanner md uses, for benchmarks.
+ * Returns 0 and keeps the current one when scanner is not supported */
+extern int
+sd_markdown_set_scanner(struct sd_markdown *md, enum sd_scanner scanner);
+
+/* sd_markdown_scan • runs one scan of the parser over data with the scanner
+ * of md and returns the number of matching bytes. The tabs are found with
+ * memchr by every scanner */
+extern size_t
+sd_markdown_scan(const struct sd_markdown *md, enum sd_scan scan, const uint8_t *data, size_t size);
+
 extern void
 sd_version(int *major, int *minor, int *revision);
 
@@ -25,33 +25,38 @@
 #define TABSTOP 4
 #define VERSION "3.7"
 
+#ifdef _MSC_VER
+#define strtok_r strtok_s
+#endif
+
 /* preformat_text - allocate and copy text buffer while
- * performing tab expansion. */
+ * performing tab expansion.  The text between tabs is copied a run at
+ * a time. */
 static GString *preformat_text(const char *text) {
     GString *buf;
-    char next_char;
-    int charstotab;
-    char *src = text;
-
-    int len = 0;
+    const char *src = text;
+    const char *run;
+    int column = 0;     /* Column of src, counted in bytes */
 
     buf = g_string_new("");
 
-    charstotab = TABSTOP;
-    while ((next_char = *src++) != '\0') {
-        switch (next_char) {
-        case '\t':
-            while (charstotab > 0)
-                g_string_append_c(buf, ' '), len++, charstotab--;
-            break;
-        case '\n':
-            g_string_append_c(buf, '\n'), len++, charstotab = TABSTOP;
-            break;
-        default:
-            g_string_append_c(buf, next_char), len++, charstotab--;
+    while (*src != '\0') {
+        run = src;
+        while (*src != '\0' && *src != '\t') {
+            if (*src == '\n')
+                column = 0;
+            else
+                column++;
+            src++;
+        }
+        g_string_append_len(buf, (char *)run, src - run);
+        if (*src == '\t') {
+            do {
+                g_string_append_c(buf, ' ');
+                column++;
+            } while (column % TABSTOP != 0);
+            src++;
         }
-        if (charstotab == 0)
-            charstotab = TABSTOP;
     }
     g_string_append(buf, "\n\n");
     return(buf);
@@ -119,6 +124,7 @@ static element * process_raw_blocks(element *input, int extensions, element *ref
     element *current = NULL;
     element *last_child = NULL;
     char *contents;
+    char *rest;
     current = input;
 
     while (current != NULL) {
@@ -126,16 +132,15 @@ static element * process_raw_blocks(element *input, int extensions, element *ref
             /* \001 is used to indicate boundaries between nested lists when there
              * is no blank line.  We split the string by \001 and parse
              * each chunk separately. */
-            contents = strtok(current->contents.str, "\001");
+            contents = strtok_r(current->contents.str, "\001", &rest);
             current->key = LIST;
             current->children = parse_markdown(contents, extensions, references, notes, labels);
             last_child = current->children;
-            while ((contents = strtok(NULL, "\001"))) {
+            while ((contents = strtok_r(NULL, "\001", &rest))) {
                 while (last_child->next != NULL)
                     last_child = last_child->next;
                 last_child->next = parse_markdown(contents, extensions, references, notes, labels);
             }
-            free(current->contents.str);
             current->contents.str = NULL;
         }
         if (current->children != NULL)
@@ -145,22 +150,55 @@ static element * process_raw_blocks(element *input, int extensions, element *ref
     return input;
 }
 
-/* markdown_to_gstring - convert markdown text to the output format specified.
+/* use_context - make context the one this thread converts with,
+ * returning the one it replaces. */
+static mmd_context * use_context(mmd_context *context) {
+    mmd_context *previous = mmd;
+    mmd = context;
+    return previous;
+}
+
+/* mmd_context_new - allocate a context to convert with.  A context may be
+ * used by one thread at a time, so threads converting at the same time need
+ * one each.  It keeps the parser's buffers from one conversion to the next.
+ * Must be freed after use with mmd_context_free(). */
+mmd_context * mmd_context_new() {
+    mmd_context *context = (mmd_context *)calloc(1, sizeof(mmd_context));
+    context->parser = parser_new();
+    context->charbuf = "";
+    context->base_header_level = 1;
+    context->cell_type = 'd';
+    context->language = ENGLISH;
+    context->padded = 2;
+    return context;
+}
+
+/* mmd_context_free - free a context, its parser and its arena */
+void mmd_context_free(mmd_context *context) {
+    if (context == NULL)
+        return;
+    arena_release(context);
+    parser_free(context->parser);
+    free(context);
+}
+
+/* mmd_context_to_g_string - convert markdown text to the output format
+ * specified with the given context.
  * Returns a GString, which must be freed after use using g_string_free(). */
-GString * markdown_to_g_string(const char *text, int extensions, int output_format) {
+GString * mmd_context_to_g_string(mmd_context *context, const char *text, int extensions, int output_format) {
     element *result;
     element *references;
     element *notes;
     element *labels;
     GString *formatted_text;
     GString *out;
+    mmd_context *previous;
     out = g_string_new("");
 
+    previous = use_context(context);
     formatted_text = preformat_text(text);
 
-    references = parse_references(formatted_text->str, extensions);
-    notes = parse_notes(formatted_text->str, extensions, references);
-    labels = parse_labels(formatted_text->str, extensions, references, notes);
+    parse_prescan(formatted_text->str, extensions, &references, &notes, &labels);
 
     if (output_format == OPML_FORMAT) {
         result = parse_markdown_for_opml(formatted_text->str, extensions);
@@ -177,11 +215,31 @@ GString * markdown_to_g_string(const char *text, int extensions, int output_form
     } else {
         print_element_list(out, result, output_format, extensions);
     }
-    free_element_list(result);
+    arena_release(context);
+
+    use_context(previous);
+    return out;
+}
 
-    free_element_list(references);
-    free_element_list(labels);
+/* mmd_context_to_string - convert markdown text to the output format
+ * specified with the given context.
+ * Returns a null-terminated string, which must be freed after use. */
+char * mmd_context_to_string(mmd_context *context, const char *text, int extensions, int output_format) {
+    GString *out;
+    char *char_out;
+    out = mmd_context_to_g_string(context, text, extensions, output_format);
+    char_out = out->str;
+    g_string_free(out, FALSE);
+    return char_out;
+}
 
+/* markdown_to_gstring - convert markdown text to the output format specified.
+ * Returns a GString, which must be freed after use using g_string_free(). */
+GString * markdown_to_g_string(const char *text, int extensions, int output_format) {
+    GString *out;
+    mmd_context *context = mmd_context_new();
+    out = mmd_context_to_g_string(context, text, extensions, output_format);
+    mmd_context_free(context);
     return out;
 }
 
@@ -204,24 +262,18 @@ char * markdown_to_string(const char *text, int extensions, int output_format) {
 char * extract_metadata_value(char *text, int extensions, char *key) {
     char *value;
     element *result;
-    element *references;
-    element *notes;
-    element *labels;
     GString *formatted_text;
+    mmd_context *context = mmd_context_new();
+    mmd_context *previous = use_context(context);
 
     formatted_text = preformat_text(text);
 
-    references = parse_references(formatted_text->str, extensions);
-    notes = parse_notes(formatted_text->str, extensions, references);
-    labels = parse_labels(formatted_text->str, extensions, references, notes);
-
     result = parse_metadata_only(formatted_text->str, extensions);
 
     value = metavalue_for_key(key, result);
-    free_element_list(result);
-    free_element_list(references);
-    free_element_list(labels);
 
+    use_context(previous);
+    mmd_context_free(context);
     return value;
 }
 
@@ -229,32 +281,21 @@ char * extract_metadata_value(char *text, int extensions, char *key) {
 gboolean has_metadata(char *text, int extensions) {
     gboolean hasMeta;
     element *result;
-    element *references;
-    element *notes;
-    element *labels;
     GString *formatted_text;
+    mmd_context *context = mmd_context_new();
+    mmd_context *previous = use_context(context);
     
     formatted_text = preformat_text(text);
 
-    references = parse_references(formatted_text->str, extensions);
-    notes = parse_notes(formatted_text->str, extensions, references);
-    labels = parse_labels(formatted_text->str, extensions, references, notes);
-    
     result = parse_metadata_only(formatted_text->str, extensions);
 
     hasMeta = FALSE;
     
-    if (result != NULL) {
-        if (result->children != NULL) {
-            hasMeta = TRUE;
-            free_element_list(result);
-        } else {
-            free_element(result);
-        }
-    }
+    if (result != NULL && result->children != NULL)
+        hasMeta = TRUE;
 
-    free_element_list(references);
-    free_element_list(labels);
+    use_context(previous);
+    mmd_context_free(context);
     return hasMeta;
 }
 
@@ -37,6 +37,14 @@ enum markdown_formats {
 	ORIGINAL_FORMAT
 };
 
+/* The state of a conversion; see mmd_context_new(). */
+typedef struct MMDContext mmd_context;
+
+DECLSPEC mmd_context * mmd_context_new();
+DECLSPEC void mmd_context_free(mmd_context *context);
+DECLSPEC GString * mmd_context_to_g_string(mmd_context *context, const char *text, int extensions, int output_format);
+DECLSPEC char * mmd_context_to_string(mmd_context *context, const char *text, int extensions, int output_format);
+
 DECLSPEC GString * markdown_to_g_string(const char *text, int extensions, int output_format);
 DECLSPEC char * markdown_to_string(const char *text, int extensions, int output_format);
 DECLSPEC char * extract_metadata_value(char *text, int extensions, char *key);
@@ -28,20 +28,6 @@
 
 #include "utility_functions.h"
 
-static int extensions;
-static int base_header_level = 1;
-static char *latex_footer;
-static int table_column = 0;
-static char *table_alignment;
-static char cell_type = 'd';
-static int language = ENGLISH;
-static bool html_footer = FALSE;
-static int odf_type = 0;
-static bool no_latex_footnote = FALSE;
-static bool am_printing_html_footnote = FALSE;
-static int footnote_counter_to_print = 0;
-static int odf_list_needs_end_p = 0;
-
 static void print_html_string(GString *out, char *str, bool obfuscate);
 static void print_html_element_list(GString *out, element *list, bool obfuscate);
 static void print_html_element(GString *out, element *elt, bool obfuscate);
@@ -96,18 +82,11 @@ element * locator_for_citation(element *elt);
 
  ***********************************************************************/
 
-static int padded = 2;      /* Number of newlines after last output.
-                               Starts at 2 so no newlines are needed at start.
-                               */
-
-static GSList *endnotes = NULL; /* List of endnotes to print after main content. */
-static int notenumber = 0;  /* Number of footnote. */
-
 /* pad - add newlines if needed */
 static void pad(GString *out, int num) {
-    while (num-- > padded)
+    while (num-- > mmd->padded)
         g_string_append_printf(out, "\n");;
-    padded = num;
+    mmd->padded = num;
 }
 
 /* determine whether a certain element is contained within a given list */
@@ -178,9 +157,9 @@ static void print_html_element_list(GString *out, element *list, bool obfuscate)
     }
 }
 
-/* add_endnote - add an endnote to global endnotes list. */
+/* add_endnote - add an endnote to the endnotes list. */
 static void add_endnote(element *elt) {
-    endnotes = g_slist_prepend(endnotes, elt);
+    mmd->endnotes = g_slist_prepend(mmd->endnotes, elt);
 }
 
 /* print_html_element - print an element as HTML */
@@ -203,26 +182,26 @@ static void print_html_element(GString *out, element *elt, bool obfuscate) {
         print_html_string(out, elt->contents.str, obfuscate);
         break;
     case ELLIPSIS:
-        localize_typography(out, ELLIP, language, HTMLOUT);
+        localize_typography(out, ELLIP, mmd->language, HTMLOUT);
         break;
     case EMDASH:
-        localize_typography(out, MDASH, language, HTMLOUT);
+        localize_typography(out, MDASH, mmd->language, HTMLOUT);
         break;
     case ENDASH:
-        localize_typography(out, NDASH, language, HTMLOUT);
+        localize_typography(out, NDASH, mmd->language, HTMLOUT);
         break;
     case APOSTROPHE:
-        localize_typography(out, APOS, language, HTMLOUT);
+        localize_typography(out, APOS, mmd->language, HTMLOUT);
         break;
     case SINGLEQUOTED:
-        localize_typography(out, LSQUOTE, language, HTMLOUT);
+        localize_typography(out, LSQUOTE, mmd->language, HTMLOUT);
         print_html_element_list(out, elt->children, obfuscate);
-        localize_typography(out, RSQUOTE, language, HTMLOUT);
+        localize_typography(out, RSQUOTE, mmd->language, HTMLOUT);
         break;
     case DOUBLEQUOTED:
-        localize_typography(out, LDQUOTE, language, HTMLOUT);
+        localize_typography(out, LDQUOTE, mmd->language, HTMLOUT);
         print_html_element_list(out, elt->children, obfuscate);
-        localize_typography(out, RDQUOTE, language, HTMLOUT);
+        localize_typography(out, RDQUOTE, mmd->language, HTMLOUT);
         break;
     case CODE:
         g_string_append_printf(out, "<code>");
@@ -320,7 +299,7 @@ static void print_html_element(GString *out, element *elt, bool obfuscate) {
         assert(elt->key != RAW);
         break;
     case H1: case H2: case H3: case H4: case H5: case H6:
-        lev = elt->key - H1 + base_header_level;  /* assumes H1 ... H6 are in order */
+        lev = elt->key - H1 + mmd->base_header_level;  /* assumes H1 ... H6 are in order */
         if (lev > 6)
             lev = 6;
         pad(out, 2);
@@ -344,77 +323,77 @@ static void print_html_element(GString *out, element *elt, bool obfuscate) {
             free(label);
         }
         g_string_append_printf(out, "</h%1d>", lev);
-        padded = 0;
+        mmd->padded = 0;
         break;
     case PLAIN:
         pad(out, 1);
         print_html_element_list(out, elt->children, obfuscate);
-        padded = 0;
+        mmd->padded = 0;
         break;
     case PARA:
         pad(out, 2);
         g_string_append_printf(out, "<p>");
         print_html_element_list(out, elt->children, obfuscate);
-        if (am_printing_html_footnote && ( elt->next == NULL)) {
-            g_string_append_printf(out, " <a href=\"#fnref:%d\" title=\"return to article\" class=\"reversefootnote\">&#160;&#8617;</a>", footnote_counter_to_print);
+        if (mmd->am_printing_html_footnote && ( elt->next == NULL)) {
+            g_string_append_printf(out, " <a href=\"#fnref:%d\" title=\"return to article\" class=\"reversefootnote\">&#160;&#8617;</a>", mmd->footnote_counter_to_print);
             /* Only print once. For now, it's the first paragraph, until
                 I can figure out to make it the last paragraph */
-            am_printing_html_footnote = FALSE;
+            mmd->am_printing_html_footnote = FALSE;
         }
         g_string_append_printf(out, "</p>");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case HRULE:
         pad(out, 2);
         g_string_append_printf(out, "<hr />");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case HTMLBLOCK:
         pad(out, 2);
         g_string_append_printf(out, "%s", elt->contents.str);
-        padded = 0;
+        mmd->padded = 0;
         break;
     case VERBATIM:
         pad(out, 2);
         g_string_append_printf(out, "%s", "<pre><code>");
         print_html_string(out, elt->contents.str, obfuscate);
         g_string_append_printf(out, "%s", "</code></pre>");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case BULLETLIST:
         pad(out, 2);
         g_string_append_printf(out, "%s", "<ul>");
-        padded = 0;
+        mmd->padded = 0;
         print_html_element_list(out, elt->children, obfuscate);
         pad(out, 1);
         g_string_append_printf(out, "%s", "</ul>");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case ORDEREDLIST:
         pad(out, 2);
         g_string_append_printf(out, "%s", "<ol>");
-        padded = 0;
+        mmd->padded = 0;
         print_html_element_list(out, elt->children, obfuscate);
         pad(out, 1);
         g_string_append_printf(out, "</ol>");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case LISTITEM:
         pad(out, 1);
         g_string_append_printf(out, "<li>");
-        padded = 2;
+        mmd->padded = 2;
         print_html_element_list(out, elt->children, obfuscate);
         g_string_append_printf(out, "</li>");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case BLOCKQUOTE:
         pad(out, 2);
         g_string_append_printf(out, "<blockquote>\n");
-        padded = 2;
+        mmd->padded = 2;
         print_html_element_list(out, elt->children, obfuscate);
         pad(out, 1);
         g_string_append_printf(out, "</blockquote>");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case REFERENCE:
         /* Nonprinting */
@@ -429,16 +408,16 @@ static void print_html_element(GString *out, element *elt, bool obfuscate) {
             if (elt->children->contents.str == 0) {
                 /* The referenced note has not been used before */
                 add_endnote(elt->children);
-                ++notenumber;
-                sprintf(buf,"%d",notenumber);
+                ++mmd->notenumber;
+                sprintf(buf,"%d",mmd->notenumber);
                 /* Assign footnote number for future use */
-                elt->children->contents.str = strdup(buf);
+                elt->children->contents.str = arena_strdup(buf);
                 if (elt->children->key == GLOSSARYTERM) {
                     g_string_append_printf(out, "<a href=\"#fn:%d\" id=\"fnref:%d\" title=\"see footnote\" class=\"footnote glossary\">[%d]</a>",
-                                notenumber, notenumber, notenumber);
+                                mmd->notenumber, mmd->notenumber, mmd->notenumber);
                 } else {
                     g_string_append_printf(out, "<a href=\"#fn:%d\" id=\"fnref:%d\" title=\"see footnote\" class=\"footnote\">[%d]</a>",
-                                notenumber, notenumber, notenumber);
+                                mmd->notenumber, mmd->notenumber, mmd->notenumber);
                 }
             } else {
                 /* The referenced note has already been used */
@@ -493,10 +472,10 @@ static void print_html_element(GString *out, element *elt, bool obfuscate) {
                    so create "endnote" */
                 elt->children->key = CITATION;
                 add_endnote(elt->children);
-                ++notenumber;
-                sprintf(buf,"%d",notenumber);
+                ++mmd->notenumber;
+                sprintf(buf,"%d",mmd->notenumber);
                 /* Store the number for future reference */
-                elt->children->contents.str = strdup(buf);
+                elt->children->contents.str = arena_strdup(buf);
             }
             if (locator != NULL) {
                 if ( elt->key == NOCITATION ) {
@@ -528,31 +507,31 @@ static void print_html_element(GString *out, element *elt, bool obfuscate) {
         break;
     case DEFLIST:
         pad(out,1);
-        padded = 1;
+        mmd->padded = 1;
         g_string_append_printf(out, "<dl>\n");
         print_html_element_list(out, elt->children, obfuscate);
         g_string_append_printf(out, "</dl>\n");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case TERM:
         pad(out,1);
         g_string_append_printf(out, "<dt>");
         print_html_element_list(out, elt->children, obfuscate);
         g_string_append_printf(out, "</dt>\n");
-        padded = 1;
+        mmd->padded = 1;
         break;
     case DEFINITION:
         pad(out,1);
-        padded = 1;
+        mmd->padded = 1;
         g_string_append_printf(out, "<dd>");
         print_html_element_list(out, elt->children, obfuscate);
         g_string_append_printf(out, "</dd>\n");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case METADATA:
         /* Metadata is present, so this should be a "complete" document */
-        html_footer = is_html_complete_doc(elt);
-        if (html_footer) {
+        mmd->html_footer = is_html_complete_doc(elt);
+        if (mmd->html_footer) {
             print_html_header(out, elt, obfuscate);
         } else {
             print_html_element_list(out, elt->children, obfuscate);
@@ -574,18 +553,18 @@ static void print_html_element(GString *out, element *elt, bool obfuscate) {
             print_raw_element(out, elt->children);
             g_string_append_printf(out, "\n");
         } else if (strcmp(elt->contents.str, "baseheaderlevel") == 0) {
-            base_header_level = atoi(elt->children->contents.str);
+            mmd->base_header_level = atoi(elt->children->contents.str);
         } else if (strcmp(elt->contents.str, "xhtmlheaderlevel") == 0) {
-            base_header_level = atoi(elt->children->contents.str);
+            mmd->base_header_level = atoi(elt->children->contents.str);
         } else if (strcmp(elt->contents.str, "htmlheaderlevel") == 0) {
-            base_header_level = atoi(elt->children->contents.str);
+            mmd->base_header_level = atoi(elt->children->contents.str);
         } else if (strcmp(elt->contents.str, "quoteslanguage") == 0) {
             label = label_from_element_list(elt->children, 0);
-            if (strcmp(label, "dutch") == 0) { language = DUTCH; } else 
-            if (strcmp(label, "german") == 0) { language = GERMAN; } else 
-            if (strcmp(label, "germanguillemets") == 0) { language = GERMANGUILL; } else 
-            if (strcmp(label, "french") == 0) { language = FRENCH; } else 
-            if (strcmp(label, "swedish") == 0) { language = SWEDISH; }
+            if (strcmp(label, "dutch") == 0) { mmd->language = DUTCH; } else 
+            if (strcmp(label, "german") == 0) { mmd->language = GERMAN; } else 
+            if (strcmp(label, "germanguillemets") == 0) { mmd->language = GERMANGUILL; } else 
+            if (strcmp(label, "french") == 0) { mmd->language = FRENCH; } else 
+            if (strcmp(label, "swedish") == 0) { mmd->language = SWEDISH; }
             free(label);
        } else {
             g_string_append_printf(out, "\t<meta name=\"");
@@ -609,7 +588,7 @@ static void print_html_element(GString *out, element *elt, bool obfuscate) {
         g_string_append_printf(out, "</table>\n");
         break;
     case TABLESEPARATOR:
-        table_alignment = elt->contents.str;
+        mmd->table_alignment = elt->contents.str;
         break;
     case TABLECAPTION:
         if (elt->children->key == TABLELABEL) {
@@ -627,27 +606,27 @@ static void print_html_element(GString *out, element *elt, bool obfuscate) {
     case TABLEHEAD:
         /* print column alignment for XSLT processing if needed */
         g_string_append_printf(out, "<colgroup>\n");
-        for (table_column=0;table_column<strlen(table_alignment);table_column++) {
-           if ( strncmp(&table_alignment[table_column],"r",1) == 0) {
+        for (mmd->table_column=0;mmd->table_column<strlen(mmd->table_alignment);mmd->table_column++) {
+           if ( strncmp(&mmd->table_alignment[mmd->table_column],"r",1) == 0) {
                 g_string_append_printf(out, "<col style=\"text-align:right;\"/>\n");
-            } else if ( strncmp(&table_alignment[table_column],"R",1) == 0) {
+            } else if ( strncmp(&mmd->table_alignment[mmd->table_column],"R",1) == 0) {
                 g_string_append_printf(out, "<col style=\"text-align:right;\" class=\"extended\"/>\n");
-            } else if ( strncmp(&table_alignment[table_column],"c",1) == 0) {
+            } else if ( strncmp(&mmd->table_alignment[mmd->table_column],"c",1) == 0) {
                 g_string_append_printf(out, "<col style=\"text-align:center;\"/>\n");
-            } else if ( strncmp(&table_alignment[table_column],"C",1) == 0) {
+            } else if ( strncmp(&mmd->table_alignment[mmd->table_column],"C",1) == 0) {
                 g_string_append_printf(out, "<col style=\"text-align:center;\" class=\"extended\"/>\n");
-            } else if ( strncmp(&table_alignment[table_column],"L",1) == 0) {
+            } else if ( strncmp(&mmd->table_alignment[mmd->table_column],"L",1) == 0) {
                 g_string_append_printf(out, "<col style=\"text-align:left;\" class=\"extended\"/>\n");
             } else {
                 g_string_append_printf(out, "<col style=\"text-align:left;\"/>\n");
             }
         }
         g_string_append_printf(out, "</colgroup>\n");
-        cell_type = 'h';
+        mmd->cell_type = 'h';
         g_string_append_printf(out, "\n<thead>\n");
         print_html_element_list(out, elt->children, obfuscate);
         g_string_append_printf(out, "</thead>\n");
-        cell_type = 'd';
+        mmd->cell_type = 'd';
         break;
     case TABLEBODY:
         g_string_append_printf(out, "\n<tbody>\n");
@@ -656,30 +635,30 @@ static void print_html_element(GString *out, element *elt, bool obfuscate) {
         break;
     case TABLEROW:
         g_string_append_printf(out, "<tr>\n");
-        table_column = 0;
+        mmd->table_column = 0;
         print_html_element_list(out, elt->children, obfuscate);
         g_string_append_printf(out, "</tr>\n");
         break;
     case TABLECELL:
-        if ( strncmp(&table_alignment[table_column],"r",1) == 0) {
-            g_string_append_printf(out, "\t<t%c style=\"text-align:right;\"", cell_type);
-        } else if ( strncmp(&table_alignment[table_column],"R",1) == 0) {
-            g_string_append_printf(out, "\t<t%c style=\"text-align:right;\"", cell_type);
-        } else if ( strncmp(&table_alignment[table_column],"c",1) == 0) {
-            g_string_append_printf(out, "\t<t%c style=\"text-align:center;\"", cell_type);
-        } else if ( strncmp(&table_alignment[table_column],"C",1) == 0) {
-            g_string_append_printf(out, "\t<t%c style=\"text-align:center;\"", cell_type);
+        if ( strncmp(&mmd->table_alignment[mmd->table_column],"r",1) == 0) {
+            g_string_append_printf(out, "\t<t%c style=\"text-align:right;\"", mmd->cell_type);
+        } else if ( strncmp(&mmd->table_alignment[mmd->table_column],"R",1) == 0) {
+            g_string_append_printf(out, "\t<t%c style=\"text-align:right;\"", mmd->cell_type);
+        } else if ( strncmp(&mmd->table_alignment[mmd->table_column],"c",1) == 0) {
+            g_string_append_printf(out, "\t<t%c style=\"text-align:center;\"", mmd->cell_type);
+        } else if ( strncmp(&mmd->table_alignment[mmd->table_column],"C",1) == 0) {
+            g_string_append_printf(out, "\t<t%c style=\"text-align:center;\"", mmd->cell_type);
         } else {
-            g_string_append_printf(out, "\t<t%c style=\"text-align:left;\"", cell_type);
+            g_string_append_printf(out, "\t<t%c style=\"text-align:left;\"", mmd->cell_type);
         }
         if ((elt->children != NULL) && (elt->children->key == CELLSPAN)) {
             g_string_append_printf(out, " colspan=\"%d\"",(int)strlen(elt->children->contents.str)+1);
         }
         g_string_append_printf(out, ">");
-        padded = 2;
+        mmd->padded = 2;
         print_html_element_list(out, elt->children, obfuscate);
-        g_string_append_printf(out, "</t%c>\n", cell_type);
-        table_column++;
+        g_string_append_printf(out, "</t%c>\n", mmd->cell_type);
+        mmd->table_column++;
         break;
     case CELLSPAN:
         break;
@@ -711,9 +690,9 @@ static void print_html_endnotes(GString *out) {
     GSList *note;
     element *note_elt;
     element *temp;
-    if (endnotes == NULL) 
+    if (mmd->endnotes == NULL) 
         return;
-    note = g_slist_reverse(endnotes);
+    note = g_slist_reverse(mmd->endnotes);
     g_string_append_printf(out, "<div class=\"footnotes\">\n<hr />\n<ol>");
     while (note != NULL) {
         note_elt = note->data;
@@ -728,18 +707,18 @@ static void print_html_endnotes(GString *out) {
                 temp = temp->next;
             }
             g_string_append_printf(out, "</span>");
-            padded = 2;
+            mmd->padded = 2;
             print_html_element_list(out, note_elt->children, false);
             pad(out, 1);
             g_string_append_printf(out, "</li>");
         } else {
             g_string_append_printf(out, "<li id=\"fn:%d\">\n", counter);
-            padded = 2;
-            am_printing_html_footnote = TRUE;
-            footnote_counter_to_print = counter;
+            mmd->padded = 2;
+            mmd->am_printing_html_footnote = TRUE;
+            mmd->footnote_counter_to_print = counter;
             print_html_element_list(out, note_elt, false);
-            am_printing_html_footnote = FALSE;
-            footnote_counter_to_print = 0;
+            mmd->am_printing_html_footnote = FALSE;
+            mmd->footnote_counter_to_print = 0;
             pad(out, 1);
             g_string_append_printf(out, "</li>");
         }
@@ -748,7 +727,7 @@ static void print_html_endnotes(GString *out) {
     pad(out, 1);
     g_string_append_printf(out, "</ol>\n</div>\n");
 
-    g_slist_free(endnotes);
+    g_slist_free(mmd->endnotes);
 }
 
 /**********************************************************************
@@ -817,24 +796,24 @@ static void print_latex_string(GString *out, char *str) {
 static void print_latex_endnotes(GString *out) {
     GSList *note;
     element *note_elt;
-    if (endnotes == NULL) 
+    if (mmd->endnotes == NULL) 
         return;
-    note = g_slist_reverse(endnotes);
+    note = g_slist_reverse(mmd->endnotes);
     pad(out,2);
     g_string_append_printf(out, "\\begin{thebibliography}{0}");
     while (note != NULL) {
         note_elt = note->data;
         pad(out, 1);
         g_string_append_printf(out, "\\bibitem{%s}\n", note_elt->contents.str);
-        padded=2;
+        mmd->padded=2;
         print_latex_element_list(out, note_elt);
         pad(out, 1);
         note = note->next;
     }
     pad(out, 1);
     g_string_append_printf(out, "\\end{thebibliography}\n");
-    padded = 1;
-    g_slist_free(endnotes);
+    mmd->padded = 1;
+    g_slist_free(mmd->endnotes);
 }
 
 /* print_latex_element_list - print a list of elements as LaTeX */
@@ -854,7 +833,6 @@ static void print_latex_element(GString *out, element *elt) {
     char *upper;
     int i;
     double floatnum;
-    element *temp;
     switch (elt->key) {
     case SPACE:
         g_string_append_printf(out, "%s", elt->contents.str);
@@ -866,26 +844,26 @@ static void print_latex_element(GString *out, element *elt) {
         print_latex_string(out, elt->contents.str);
         break;
     case ELLIPSIS:
-        localize_typography(out, ELLIP, language, LATEXOUT);
+        localize_typography(out, ELLIP, mmd->language, LATEXOUT);
         break;
     case EMDASH: 
-        localize_typography(out, MDASH, language, LATEXOUT);
+        localize_typography(out, MDASH, mmd->language, LATEXOUT);
         break;
     case ENDASH: 
-        localize_typography(out, NDASH, language, LATEXOUT);
+        localize_typography(out, NDASH, mmd->language, LATEXOUT);
         break;
     case APOSTROPHE:
-        localize_typography(out, APOS, language, LATEXOUT);
+        localize_typography(out, APOS, mmd->language, LATEXOUT);
         break;
     case SINGLEQUOTED:
-        localize_typography(out, LSQUOTE, language, LATEXOUT);
+        localize_typography(out, LSQUOTE, mmd->language, LATEXOUT);
         print_latex_element_list(out, elt->children);
-        localize_typography(out, RSQUOTE, language, LATEXOUT);
+        localize_typography(out, RSQUOTE, mmd->language, LATEXOUT);
         break;
     case DOUBLEQUOTED:
-        localize_typography(out, LDQUOTE, language, LATEXOUT);
+        localize_typography(out, LDQUOTE, mmd->language, LATEXOUT);
         print_latex_element_list(out, elt->children);
-        localize_typography(out, RDQUOTE, language, LATEXOUT);
+        localize_typography(out, RDQUOTE, mmd->language, LATEXOUT);
         break;
     case CODE:
         g_string_append_printf(out, "\\texttt{");
@@ -931,7 +909,7 @@ static void print_latex_element(GString *out, element *elt) {
             g_string_append_printf(out, "\\href{%s}{", elt->contents.link->url);
             print_latex_element_list(out, elt->contents.link->label);
             g_string_append_printf(out, "}");
-            if ( no_latex_footnote == FALSE ) {
+            if ( mmd->no_latex_footnote == FALSE ) {
                 g_string_append_printf(out, "\\footnote{\\href{%s}{", elt->contents.link->url);
                 print_latex_string(out, elt->contents.link->url);
                 g_string_append_printf(out, "}}");
@@ -1016,7 +994,7 @@ static void print_latex_element(GString *out, element *elt) {
         break;
     case H1: case H2: case H3: case H4: case H5: case H6:
         pad(out, 2);
-        lev = elt->key - H1 + base_header_level;  /* assumes H1 ... H6 are in order */
+        lev = elt->key - H1 + mmd->base_header_level;  /* assumes H1 ... H6 are in order */
         switch (lev) {
             case 1:
                 g_string_append_printf(out, "\\part{");
@@ -1045,7 +1023,7 @@ static void print_latex_element(GString *out, element *elt) {
         }
         /* generate a label for each header (MMD);
             don't allow footnotes since invalid here */
-        no_latex_footnote = TRUE;
+        mmd->no_latex_footnote = TRUE;
         if (elt->children->key == AUTOLABEL) {
             label = label_from_string(elt->children->contents.str,0);
             print_latex_element_list(out, elt->children->next);
@@ -1053,27 +1031,27 @@ static void print_latex_element(GString *out, element *elt) {
             label = label_from_element_list(elt->children,0);
             print_latex_element_list(out, elt->children);
         }
-        no_latex_footnote = FALSE;
+        mmd->no_latex_footnote = FALSE;
         g_string_append_printf(out, "}\n\\label{");
         g_string_append_printf(out, "%s", label);
         g_string_append_printf(out, "}\n");
         free(label);
-        padded = 1;
+        mmd->padded = 1;
         break;
     case PLAIN:
         pad(out, 1);
         print_latex_element_list(out, elt->children);
-        padded = 0;
+        mmd->padded = 0;
         break;
     case PARA:
         pad(out, 2);
         print_latex_element_list(out, elt->children);
-        padded = 0;
+        mmd->padded = 0;
         break;
     case HRULE:
         pad(out, 2);
         g_string_append_printf(out, "\\begin{center}\\rule{3in}{0.4pt}\\end{center}\n");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case HTMLBLOCK:
         /* don't print HTML block */
@@ -1083,7 +1061,7 @@ static void print_latex_element(GString *out, element *elt) {
             /* trim "-->" from end */
             elt->contents.str[strlen(elt->contents.str)-3] = '\0';
             g_string_append_printf(out, "%s", &elt->contents.str[4]);
-            padded = 0;
+            mmd->padded = 0;
         }
         break;
     case VERBATIM:
@@ -1091,40 +1069,40 @@ static void print_latex_element(GString *out, element *elt) {
         g_string_append_printf(out, "\n\\begin{verbatim}\n");
         print_raw_element(out, elt);
         g_string_append_printf(out, "\\end{verbatim}\n");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case BULLETLIST:
         pad(out, 1);
         g_string_append_printf(out, "\n\\begin{itemize}");
-        padded = 0;
+        mmd->padded = 0;
         print_latex_element_list(out, elt->children);
         g_string_append_printf(out, "\n\\end{itemize}");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case ORDEREDLIST:
         pad(out, 2);
         g_string_append_printf(out, "\\begin{enumerate}");
-        padded = 0;
+        mmd->padded = 0;
         print_latex_element_list(out, elt->children);
         pad(out, 1);
         g_string_append_printf(out, "\\end{enumerate}");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case LISTITEM:
         pad(out, 1);
         g_string_append_printf(out, "\\item ");
-        padded = 2;
+        mmd->padded = 2;
         print_latex_element_list(out, elt->children);
         g_string_append_printf(out, "\n");
         break;
     case BLOCKQUOTE:
         pad(out, 2);
         g_string_append_printf(out, "\\begin{quote}");
-        padded = 0;
+        mmd->padded = 0;
         print_latex_element_list(out, elt->children);
         pad(out, 1);
         g_string_append_printf(out, "\\end{quote}");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case NOTELABEL:
         /* Nonprinting */
@@ -1135,7 +1113,7 @@ static void print_latex_element(GString *out, element *elt) {
         if (elt->contents.str == 0) {
             if (elt->children->key == GLOSSARYTERM) {
                 g_string_append_printf(out, "\\newglossaryentry{%s}{", elt->children->children->contents.str);
-                padded = 2;
+                mmd->padded = 2;
                 if (elt->children->next->key == GLOSSARYSORTKEY) {
                     g_string_append_printf(out, "sort={");
                     print_latex_string(out, elt->children->next->contents.str);
@@ -1143,13 +1121,13 @@ static void print_latex_element(GString *out, element *elt) {
                 }
                 print_latex_element_list(out, elt->children);
                 g_string_append_printf(out, "}}\\glsadd{%s}", elt->children->children->contents.str);
-                padded = 0;
+                mmd->padded = 0;
             } else {
                 g_string_append_printf(out, "\\footnote{");
-                padded = 2;
+                mmd->padded = 2;
                 print_latex_element_list(out, elt->children);
                 g_string_append_printf(out, "}");
-                padded = 0;
+                mmd->padded = 0;
             }
             elt->children = NULL;
         }
@@ -1197,9 +1175,7 @@ static void print_latex_element(GString *out, element *elt) {
             /* This citation was specified in the document itself */
             if (elt->key == NOCITATION ) {
                 g_string_append_printf(out, "~\\nocite{%s}", elt->contents.str);
-                temp = elt->children;
-                elt->children = temp->next;
-                free_element(temp);
+                elt->children = elt->children->next;
             } else {
                 if ((elt->children != NULL) && (elt->children->key == LOCATOR)){
                     if (strcmp(&elt->contents.str[strlen(elt->contents.str) - 1],";") == 0) {
@@ -1210,10 +1186,7 @@ static void print_latex_element(GString *out, element *elt) {
                     }
                     print_latex_element(out,elt->children);
                     g_string_append_printf(out, "]{%s}",elt->contents.str);
-//                    element *temp;
-                    temp = elt->children;
-                    elt->children = temp->next;
-                    free_element(temp);
+                    elt->children = elt->children->next;
                 } else {
                     if (strcmp(&elt->contents.str[strlen(elt->contents.str) - 1],";") == 0) {
                         elt->contents.str[strlen(elt->contents.str) - 1] = '\0';
@@ -1224,7 +1197,7 @@ static void print_latex_element(GString *out, element *elt) {
                 }
             }
             if ((elt->children != NULL) && (elt->children->contents.str == NULL)) {
-                elt->children->contents.str = strdup(elt->contents.str);
+                elt->children->contents.str = arena_strdup(elt->contents.str);
                 add_endnote(elt->children);
             }
             elt->children = NULL;
@@ -1235,29 +1208,29 @@ static void print_latex_element(GString *out, element *elt) {
         break;
     case DEFLIST:
         g_string_append_printf(out, "\\begin{description}");
-        padded = 0;
+        mmd->padded = 0;
         print_latex_element_list(out, elt->children);
         pad(out,1);
         g_string_append_printf(out, "\\end{description}");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case TERM:
         pad(out,2);
         g_string_append_printf(out, "\\item[");
         print_latex_element_list(out, elt->children);
         g_string_append_printf(out, "]");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case DEFINITION:
         pad(out,2);
-        padded = 2;
+        mmd->padded = 2;
         print_latex_element_list(out, elt->children);
-        padded = 0;
+        mmd->padded = 0;
         break;
     case METADATA:
         /* Metadata is present, so this should be a "complete" document */
         print_latex_header(out, elt);
-        html_footer = is_html_complete_doc(elt);
+        mmd->html_footer = is_html_complete_doc(elt);
         break;
     case METAKEY:
         if (strcmp(elt->contents.str, "title") == 0) {
@@ -1277,13 +1250,13 @@ static void print_latex_element(GString *out, element *elt) {
             print_latex_element_list(out, elt->children);
             g_string_append_printf(out, "}\n");
         } else if (strcmp(elt->contents.str, "baseheaderlevel") == 0) {
-            base_header_level = atoi(elt->children->contents.str);
+            mmd->base_header_level = atoi(elt->children->contents.str);
         } else if (strcmp(elt->contents.str, "latexheaderlevel") == 0) {
-            base_header_level = atoi(elt->children->contents.str);
+            mmd->base_header_level = atoi(elt->children->contents.str);
         } else if (strcmp(elt->contents.str, "latexinput") == 0) {
             g_string_append_printf(out, "\\input{%s}\n", elt->children->contents.str);
         } else if (strcmp(elt->contents.str, "latexfooter") == 0) {
-            latex_footer = elt->children->contents.str;
+            mmd->latex_footer = elt->children->contents.str;
         } else if (strcmp(elt->contents.str, "bibtex") == 0) {
             g_string_append_printf(out, "\\def\\bibliocommand{\\bibliography{%s}}\n",elt->children->contents.str);
         } else if (strcmp(elt->contents.str, "xhtmlheader") == 0) {
@@ -1291,11 +1264,11 @@ static void print_latex_element(GString *out, element *elt) {
         } else if (strcmp(elt->contents.str, "css") == 0) {
         } else if (strcmp(elt->contents.str, "quoteslanguage") == 0) {
             label = label_from_element_list(elt->children, 0);
-            if (strcmp(label, "dutch") == 0) { language = DUTCH; } else 
-            if (strcmp(label, "german") == 0) { language = GERMAN; } else 
-            if (strcmp(label, "germanguillemets") == 0) { language = GERMANGUILL; } else 
-            if (strcmp(label, "french") == 0) { language = FRENCH; } else 
-            if (strcmp(label, "swedish") == 0) { language = SWEDISH; }
+            if (strcmp(label, "dutch") == 0) { mmd->language = DUTCH; } else 
+            if (strcmp(label, "german") == 0) { mmd->language = GERMAN; } else 
+            if (strcmp(label, "germanguillemets") == 0) { mmd->language = GERMANGUILL; } else 
+            if (strcmp(label, "french") == 0) { mmd->language = FRENCH; } else 
+            if (strcmp(label, "swedish") == 0) { mmd->language = SWEDISH; }
             free(label);
         } else {
             g_string_append_printf(out, "\\def\\");
@@ -1320,7 +1293,7 @@ static void print_latex_element(GString *out, element *elt) {
         g_string_append_printf(out, "\\begin{table}[htbp]\n\\begin{minipage}{\\linewidth}\n\\setlength{\\tymax}{0.5\\linewidth}\n\\centering\n\\small\n");
         print_latex_element_list(out, elt->children);
         g_string_append_printf(out, "\n\\end{tabulary}\n\\end{minipage}\n\\end{table}\n");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case TABLESEPARATOR:
         upper = strdup(elt->contents.str);
@@ -1361,7 +1334,7 @@ static void print_latex_element(GString *out, element *elt) {
         g_string_append_printf(out, "\\\\\n");
         break;
     case TABLECELL:
-        padded = 2;
+        mmd->padded = 2;
         if ((elt->children != NULL) && (elt->children->key == CELLSPAN)) {
             g_string_append_printf(out, "\\multicolumn{%d}{c}{", (int)strlen(elt->children->contents.str)+1);
         }
@@ -1405,7 +1378,6 @@ static void print_latex_element(GString *out, element *elt) {
 
  ***********************************************************************/
 
-static bool in_list_item = false; /* True if we're parsing contents of a list item. */
 
 /* print_groff_string - print string, escaping for groff */
 static void print_groff_string(GString *out, char *str) {
@@ -1437,16 +1409,16 @@ static void print_groff_mm_element(GString *out, element *elt, int count) {
     switch (elt->key) {
     case SPACE:
         g_string_append_printf(out, "%s", elt->contents.str);
-        padded = 0;
+        mmd->padded = 0;
         break;
     case LINEBREAK:
         pad(out, 1);
         g_string_append_printf(out, ".br\n");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case STR:
         print_groff_string(out, elt->contents.str);
-        padded = 0;
+        mmd->padded = 0;
         break;
     case ELLIPSIS:
         g_string_append_printf(out, "...");
@@ -1474,7 +1446,7 @@ static void print_groff_mm_element(GString *out, element *elt, int count) {
         g_string_append_printf(out, "\\fC");
         print_groff_string(out, elt->contents.str);
         g_string_append_printf(out, "\\fR");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case HTML:
         /* don't print HTML */
@@ -1482,30 +1454,30 @@ static void print_groff_mm_element(GString *out, element *elt, int count) {
     case LINK:
         print_groff_mm_element_list(out, elt->contents.link->label);
         g_string_append_printf(out, " (%s)", elt->contents.link->url);
-        padded = 0;
+        mmd->padded = 0;
         break;
     case IMAGE:
         g_string_append_printf(out, "[IMAGE: ");
         print_groff_mm_element_list(out, elt->contents.link->label);
         g_string_append_printf(out, "]");
-        padded = 0;
+        mmd->padded = 0;
         /* not supported */
         break;
     case EMPH:
         g_string_append_printf(out, "\\fI");
         print_groff_mm_element_list(out, elt->children);
         g_string_append_printf(out, "\\fR");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case STRONG:
         g_string_append_printf(out, "\\fB");
         print_groff_mm_element_list(out, elt->children);
         g_string_append_printf(out, "\\fR");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case LIST:
         print_groff_mm_element_list(out, elt->children);
-        padded = 0;
+        mmd->padded = 0;
         break;
     case RAW:
         /* Shouldn't occur - these are handled by process_raw_blocks() */
@@ -1517,24 +1489,24 @@ static void print_groff_mm_element(GString *out, element *elt, int count) {
         g_string_append_printf(out, ".H %d \"", lev);
         print_groff_mm_element_list(out, elt->children);
         g_string_append_printf(out, "\"");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case PLAIN:
         pad(out, 1);
         print_groff_mm_element_list(out, elt->children);
-        padded = 0;
+        mmd->padded = 0;
         break;
     case PARA:
         pad(out, 1);
-        if (!in_list_item || count != 1)
+        if (!mmd->in_list_item || count != 1)
             g_string_append_printf(out, ".P\n");
         print_groff_mm_element_list(out, elt->children);
-        padded = 0;
+        mmd->padded = 0;
         break;
     case HRULE:
         pad(out, 1);
         g_string_append_printf(out, "\\l'\\n(.lu*8u/10u'");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case HTMLBLOCK:
         /* don't print HTML block */
@@ -1544,42 +1516,42 @@ static void print_groff_mm_element(GString *out, element *elt, int count) {
         g_string_append_printf(out, ".VERBON 2\n");
         print_groff_string(out, elt->contents.str);
         g_string_append_printf(out, ".VERBOFF");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case BULLETLIST:
         pad(out, 1);
         g_string_append_printf(out, ".BL");
-        padded = 0;
+        mmd->padded = 0;
         print_groff_mm_element_list(out, elt->children);
         pad(out, 1);
         g_string_append_printf(out, ".LE 1");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case ORDEREDLIST:
         pad(out, 1);
         g_string_append_printf(out, ".AL");
-        padded = 0;
+        mmd->padded = 0;
         print_groff_mm_element_list(out, elt->children);
         pad(out, 1);
         g_string_append_printf(out, ".LE 1");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case LISTITEM:
         pad(out, 1);
         g_string_append_printf(out, ".LI\n");
-        in_list_item = true;
-        padded = 2;
+        mmd->in_list_item = true;
+        mmd->padded = 2;
         print_groff_mm_element_list(out, elt->children);
-        in_list_item = false;
+        mmd->in_list_item = false;
         break;
     case BLOCKQUOTE:
         pad(out, 1);
         g_string_append_printf(out, ".DS I\n");
-        padded = 2;
+        mmd->padded = 2;
         print_groff_mm_element_list(out, elt->children);
         pad(out, 1);
         g_string_append_printf(out, ".DE");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case NOTELABEL:
         /* Nonprinting */
@@ -1590,11 +1562,11 @@ static void print_groff_mm_element(GString *out, element *elt, int count) {
         if (elt->contents.str == 0) {
             g_string_append_printf(out, "\\*F\n");
             g_string_append_printf(out, ".FS\n");
-            padded = 2;
+            mmd->padded = 2;
             print_groff_mm_element_list(out, elt->children);
             pad(out, 1);
             g_string_append_printf(out, ".FE\n");
-            padded = 1; 
+            mmd->padded = 1; 
         }
         break;
     case REFERENCE:
@@ -1747,26 +1719,26 @@ static void print_odf_element(GString *out, element *elt) {
         print_html_string(out, elt->contents.str, 0);
         break;
     case ELLIPSIS:
-        localize_typography(out, ELLIP, language, HTMLOUT);
+        localize_typography(out, ELLIP, mmd->language, HTMLOUT);
         break;
     case EMDASH:
-        localize_typography(out, MDASH, language, HTMLOUT);
+        localize_typography(out, MDASH, mmd->language, HTMLOUT);
         break;
     case ENDASH:
-        localize_typography(out, NDASH, language, HTMLOUT);
+        localize_typography(out, NDASH, mmd->language, HTMLOUT);
         break;
     case APOSTROPHE:
-        localize_typography(out, APOS, language, HTMLOUT);
+        localize_typography(out, APOS, mmd->language, HTMLOUT);
         break;
     case SINGLEQUOTED:
-        localize_typography(out, LSQUOTE, language, HTMLOUT);
+        localize_typography(out, LSQUOTE, mmd->language, HTMLOUT);
         print_odf_element_list(out, elt->children);
-        localize_typography(out, RSQUOTE, language, HTMLOUT);
+        localize_typography(out, RSQUOTE, mmd->language, HTMLOUT);
         break;
     case DOUBLEQUOTED:
-        localize_typography(out, LDQUOTE, language, HTMLOUT);
+        localize_typography(out, LDQUOTE, mmd->language, HTMLOUT);
         print_odf_element_list(out, elt->children);
-        localize_typography(out, RDQUOTE, language, HTMLOUT);
+        localize_typography(out, RDQUOTE, mmd->language, HTMLOUT);
         break;
     case CODE:
         g_string_append_printf(out, "<text:span text:style-name=\"Source_20_Text\">");
@@ -1859,7 +1831,7 @@ static void print_odf_element(GString *out, element *elt) {
         assert(elt->key != RAW);
         break;
     case H1: case H2: case H3: case H4: case H5: case H6:
-        lev = elt->key - H1 + base_header_level;  /* assumes H1 ... H6 are in order */
+        lev = elt->key - H1 + mmd->base_header_level;  /* assumes H1 ... H6 are in order */
         g_string_append_printf(out, "<text:h text:outline-level=\"%d\">", lev);
         if (elt->children->key == AUTOLABEL) {
             /* generate a label for each header (MMD)*/
@@ -1874,15 +1846,15 @@ static void print_odf_element(GString *out, element *elt) {
             free(label);
         }
         g_string_append_printf(out, "</text:h>\n");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case PLAIN:
         print_odf_element_list(out, elt->children);
-        padded = 0;
+        mmd->padded = 0;
         break;
     case PARA:
         g_string_append_printf(out, "<text:p");
-        switch (odf_type) {
+        switch (mmd->odf_type) {
             case DEFINITION:
             case BLOCKQUOTE:
                 g_string_append_printf(out," text:style-name=\"Quotations\"");
@@ -1921,56 +1893,56 @@ static void print_odf_element(GString *out, element *elt) {
         }
         break;
     case VERBATIM:
-        old_type = odf_type;
-        odf_type = VERBATIM;
+        old_type = mmd->odf_type;
+        mmd->odf_type = VERBATIM;
         g_string_append_printf(out, "<text:p text:style-name=\"Preformatted Text\">");
         print_odf_code_string(out, elt->contents.str);
         g_string_append_printf(out, "</text:p>\n");
-        odf_type = old_type;
+        mmd->odf_type = old_type;
         break;
     case BULLETLIST:
-        if ((odf_type == BULLETLIST) ||
-            (odf_type == ORDEREDLIST)) {
+        if ((mmd->odf_type == BULLETLIST) ||
+            (mmd->odf_type == ORDEREDLIST)) {
             /* I think this was made unnecessary by another change.
             Same for ORDEREDLIST below */
             /*  g_string_append_printf(out, "</text:p>"); */
         }
-        old_type = odf_type;
-        odf_type = BULLETLIST;
-        if (odf_list_needs_end_p) {
+        old_type = mmd->odf_type;
+        mmd->odf_type = BULLETLIST;
+        if (mmd->odf_list_needs_end_p) {
             g_string_append_printf(out, "%s", "</text:p>");
-            odf_list_needs_end_p = 0;
+            mmd->odf_list_needs_end_p = 0;
         }
         g_string_append_printf(out, "%s", "<text:list>");
         print_odf_element_list(out, elt->children);
         g_string_append_printf(out, "%s", "</text:list>");
-        odf_type = old_type;
+        mmd->odf_type = old_type;
         break;
     case ORDEREDLIST:
-        if ((odf_type == BULLETLIST) ||
-            (odf_type == ORDEREDLIST)) {
+        if ((mmd->odf_type == BULLETLIST) ||
+            (mmd->odf_type == ORDEREDLIST)) {
             /* g_string_append_printf(out, "</text:p>"); */
         }
-        old_type = odf_type;
-        odf_type = ORDEREDLIST;
-        if (odf_list_needs_end_p) {
+        old_type = mmd->odf_type;
+        mmd->odf_type = ORDEREDLIST;
+        if (mmd->odf_list_needs_end_p) {
             g_string_append_printf(out, "%s", "</text:p>");
-            odf_list_needs_end_p = 0;
+            mmd->odf_list_needs_end_p = 0;
         }
         g_string_append_printf(out, "%s", "<text:list>\n");
         print_odf_element_list(out, elt->children);
         g_string_append_printf(out, "%s", "</text:list>\n");
-        odf_type = old_type;
+        mmd->odf_type = old_type;
         break;
     case LISTITEM:
         g_string_append_printf(out, "<text:list-item>\n");
         if (elt->children->children->key != PARA) {
             g_string_append_printf(out, "<text:p text:style-name=\"P2\">");
-            odf_list_needs_end_p = 1;
+            mmd->odf_list_needs_end_p = 1;
         }
         print_odf_element_list(out, elt->children);
 
-       odf_list_needs_end_p = 0;
+       mmd->odf_list_needs_end_p = 0;
        if ((list_contains_key(elt->children,BULLETLIST) ||
             (list_contains_key(elt->children,ORDEREDLIST)))) {
             } else {
@@ -1981,18 +1953,18 @@ static void print_odf_element(GString *out, element *elt) {
         g_string_append_printf(out, "</text:list-item>\n");
         break;
     case BLOCKQUOTE:
-        old_type = odf_type;
-        odf_type = BLOCKQUOTE;
+        old_type = mmd->odf_type;
+        mmd->odf_type = BLOCKQUOTE;
         print_odf_element_list(out, elt->children);
-        odf_type = old_type;
+        mmd->odf_type = old_type;
         break;
     case REFERENCE:
         break;
     case NOTELABEL:
         break;
     case NOTE:
-        old_type = odf_type;
-        odf_type = NOTE;
+        old_type = mmd->odf_type;
+        mmd->odf_type = NOTE;
         /* if contents.str == 0 then print; else ignore - like above */
         if (elt->contents.str == 0) {
             if (elt->children->key == GLOSSARYTERM) {
@@ -2006,7 +1978,7 @@ static void print_odf_element(GString *out, element *elt) {
             }
        }
         elt->children = NULL;
-        odf_type = old_type;
+        mmd->odf_type = old_type;
         break;
     case GLOSSARY:
         break;
@@ -2031,19 +2003,19 @@ static void print_odf_element(GString *out, element *elt) {
                so will output as footnote */
             if (elt->children->contents.str == NULL) {
                 /* First use of this citation */
-                ++notenumber;
+                ++mmd->notenumber;
 //                char buf[5];
-                sprintf(buf, "%d",notenumber);
+                sprintf(buf, "%d",mmd->notenumber);
                 /* Store the number for future reference */
-                elt->children->contents.str = strdup(buf);
+                elt->children->contents.str = arena_strdup(buf);
                 
                 /* Insert the footnote here */
-                old_type = odf_type;
-                odf_type = NOTE;
+                old_type = mmd->odf_type;
+                mmd->odf_type = NOTE;
                 g_string_append_printf(out, "<text:note text:id=\"cite%s\" text:note-class=\"footnote\"><text:note-body>\n", buf);
                 print_odf_element_list(out, elt->children);
                 g_string_append_printf(out, "</text:note-body>\n</text:note>\n");
-                odf_type = old_type;
+                mmd->odf_type = old_type;
 
                 elt->children->key = CITATION;
             } else {
@@ -2066,12 +2038,12 @@ static void print_odf_element(GString *out, element *elt) {
         g_string_append_printf(out, "</text:span></text:p>");
         break;
     case DEFINITION:
-        old_type = odf_type;
-        odf_type = DEFINITION;
+        old_type = mmd->odf_type;
+        mmd->odf_type = DEFINITION;
         g_string_append_printf(out, "<text:p text:style-name=\"Quotations\">");
         print_odf_element_list(out, elt->children);
         g_string_append_printf(out, "</text:p>");
-        odf_type = old_type;
+        mmd->odf_type = old_type;
         break;
     case METADATA:
         g_string_append_printf(out, "<office:meta>\n");
@@ -2090,9 +2062,9 @@ static void print_odf_element(GString *out, element *elt) {
             g_string_append_printf(out,"</dc:title>\n");
         } else if (strcmp(elt->contents.str, "css") == 0) {
         } else if (strcmp(elt->contents.str, "baseheaderlevel") == 0) {
-            base_header_level = atoi(elt->children->contents.str);
+            mmd->base_header_level = atoi(elt->children->contents.str);
         } else if (strcmp(elt->contents.str, "odfheaderlevel") == 0) {
-            base_header_level = atoi(elt->children->contents.str);
+            mmd->base_header_level = atoi(elt->children->contents.str);
         } else if (strcmp(elt->contents.str, "xhtmlheader") == 0) {
         } else if (strcmp(elt->contents.str, "htmlheader") == 0) {
         } else if (strcmp(elt->contents.str, "odfheader") == 0) {
@@ -2105,11 +2077,11 @@ static void print_odf_element(GString *out, element *elt) {
             g_string_append_printf(out, "</meta:keyword>\n");
         } else if (strcmp(elt->contents.str, "quoteslanguage") == 0) {
              label = label_from_element_list(elt->children, 0);
-             if (strcmp(label, "dutch") == 0) { language = DUTCH; } else 
-             if (strcmp(label, "german") == 0) { language = GERMAN; } else 
-             if (strcmp(label, "germanguillemets") == 0) { language = GERMANGUILL; } else 
-             if (strcmp(label, "french") == 0) { language = FRENCH; } else 
-             if (strcmp(label, "swedish") == 0) { language = SWEDISH; }
+             if (strcmp(label, "dutch") == 0) { mmd->language = DUTCH; } else 
+             if (strcmp(label, "german") == 0) { mmd->language = GERMAN; } else 
+             if (strcmp(label, "germanguillemets") == 0) { mmd->language = GERMANGUILL; } else 
+             if (strcmp(label, "french") == 0) { mmd->language = FRENCH; } else 
+             if (strcmp(label, "swedish") == 0) { mmd->language = SWEDISH; }
              free(label);
         } else {
             g_string_append_printf(out, "<meta:user-defined meta:name=\"");
@@ -2145,26 +2117,26 @@ static void print_odf_element(GString *out, element *elt) {
         }
         break;
    case TABLESEPARATOR:
-       table_alignment = elt->contents.str;
+       mmd->table_alignment = elt->contents.str;
        break;
     case TABLECAPTION:
         break;
     case TABLELABEL:
         break;
     case TABLEHEAD:
-        for (table_column=0;table_column<strlen(table_alignment);table_column++) {
+        for (mmd->table_column=0;mmd->table_column<strlen(mmd->table_alignment);mmd->table_column++) {
             g_string_append_printf(out, "<table:table-column/>\n");
         }
-        cell_type = 'h';
+        mmd->cell_type = 'h';
         print_odf_element_list(out, elt->children);
-        cell_type = 'd';
+        mmd->cell_type = 'd';
         break;
     case TABLEBODY:
         print_odf_element_list(out,elt->children);
         break;
     case TABLEROW:
         g_string_append_printf(out, "<table:table-row>\n");
-        table_column = 0;
+        mmd->table_column = 0;
         print_odf_element_list(out,elt->children);
         g_string_append_printf(out,"</table:table-row>\n");
         break;
@@ -2174,16 +2146,16 @@ static void print_odf_element(GString *out, element *elt) {
             g_string_append_printf(out, " table:number-columns-spanned=\"%d\"",(int)strlen(elt->children->contents.str)+1);
         }
         g_string_append_printf(out,">\n<text:p");
-        if (cell_type == 'h') {
+        if (mmd->cell_type == 'h') {
             g_string_append_printf(out, " text:style-name=\"Table_20_Heading\"");
         } else {
-            if ( strncmp(&table_alignment[table_column],"r",1) == 0) {
+            if ( strncmp(&mmd->table_alignment[mmd->table_column],"r",1) == 0) {
                 g_string_append_printf(out, " text:style-name=\"MMD-Table-Right\"");
-            } else if ( strncmp(&table_alignment[table_column],"R",1) == 0) {
+            } else if ( strncmp(&mmd->table_alignment[mmd->table_column],"R",1) == 0) {
                 g_string_append_printf(out, " text:style-name=\"MMD-Table-Right\"");
-            } else if ( strncmp(&table_alignment[table_column],"c",1) == 0) {
+            } else if ( strncmp(&mmd->table_alignment[mmd->table_column],"c",1) == 0) {
                 g_string_append_printf(out, " text:style-name=\"MMD-Table-Center\"");
-            } else if ( strncmp(&table_alignment[table_column],"C",1) == 0) {
+            } else if ( strncmp(&mmd->table_alignment[mmd->table_column],"C",1) == 0) {
                 g_string_append_printf(out, " text:style-name=\"MMD-Table-Center\"");
             } else {
                 g_string_append_printf(out, " text:style-name=\"MMD-Table\"");
@@ -2192,7 +2164,7 @@ static void print_odf_element(GString *out, element *elt) {
         g_string_append_printf(out, ">");
         print_odf_element_list(out,elt->children);
         g_string_append_printf(out, "</text:p>\n</table:table-cell>\n");
-        table_column++;
+        mmd->table_column++;
         break;
     case CELLSPAN:
         break;  
@@ -2219,32 +2191,32 @@ static void print_odf_element(GString *out, element *elt) {
 void print_element_list(GString *out, element *elt, int format, int exts) {
     /* And MultiMarkdown globals */
     element *title;
-    base_header_level = 1;
-    language = ENGLISH;
-    html_footer = FALSE;
-    no_latex_footnote = FALSE;
-    footnote_counter_to_print = 0;
-    odf_list_needs_end_p = 0;
+    mmd->base_header_level = 1;
+    mmd->language = ENGLISH;
+    mmd->html_footer = FALSE;
+    mmd->no_latex_footnote = FALSE;
+    mmd->footnote_counter_to_print = 0;
+    mmd->odf_list_needs_end_p = 0;
 
     /* Initialize globals */
-    endnotes = NULL;
-    notenumber = 0;
+    mmd->endnotes = NULL;
+    mmd->notenumber = 0;
 
 
 
 
-    extensions = exts;
-    padded = 2;  /* set padding to 2, so no extra blank lines at beginning */
+    mmd->extensions = exts;
+    mmd->padded = 2;  /* set padding to 2, so no extra blank lines at beginning */
 
     format = find_latex_mode(format, elt);
     switch (format) {
     case HTML_FORMAT:
         print_html_element_list(out, elt, false);
-        if (endnotes != NULL) {
+        if (mmd->endnotes != NULL) {
             pad(out, 2);
             print_html_endnotes(out);
         }
-        if (html_footer == TRUE) print_html_footer(out, false);
+        if (mmd->html_footer == TRUE) print_html_footer(out, false);
         break;
     case LATEX_FORMAT:
         print_latex_element_list(out, elt);
@@ -2267,7 +2239,7 @@ void print_element_list(GString *out, element *elt, int format, int exts) {
         }
         g_string_append_printf(out, "<body>\n");
         print_opml_element_list(out, elt);
-        if (html_footer == TRUE) print_opml_metadata(out, elt);
+        if (mmd->html_footer == TRUE) print_opml_metadata(out, elt);
         g_string_append_printf(out, "</body>\n</opml>");
         break;
     case ODF_FORMAT:
@@ -2321,11 +2293,11 @@ void print_latex_header(GString *out, element *elt) {
 
 
 void print_latex_footer(GString *out) {
-    if (latex_footer != NULL) {
+    if (mmd->latex_footer != NULL) {
         pad(out,2);
-        g_string_append_printf(out, "\\input{%s}\n", latex_footer);
+        g_string_append_printf(out, "\\input{%s}\n", mmd->latex_footer);
     }
-    if (html_footer) {
+    if (mmd->html_footer) {
         g_string_append_printf(out, "\n\\end{document}");
     }
 }
@@ -2348,24 +2320,24 @@ static void print_memoir_element(GString *out, element *elt) {
         g_string_append_printf(out, "\n\\begin{adjustwidth}{2.5em}{2.5em}\n\\begin{verbatim}\n\n");
         print_raw_element(out, elt);
         g_string_append_printf(out, "\n\\end{verbatim}\n\\end{adjustwidth}");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case HEADINGSECTION:
         print_memoir_element_list(out, elt->children);
         break;
     case DEFLIST:
         g_string_append_printf(out, "\\begin{description}");
-        padded = 0;
+        mmd->padded = 0;
         print_memoir_element_list(out, elt->children);
         pad(out,1);
         g_string_append_printf(out, "\\end{description}");
-        padded = 0;
+        mmd->padded = 0;
         break;
     case DEFINITION:
         pad(out,2);
-        padded = 2;
+        mmd->padded = 2;
         print_memoir_element_list(out, elt->children);
-        padded = 0;
+        mmd->padded = 0;
         break;
     default:
         /* most things are not changed for memoir output */
@@ -2385,24 +2357,24 @@ void print_beamer_element_list(GString *out, element *list) {
 static void print_beamer_endnotes(GString *out) {
     GSList *note;
     element *note_elt;
-    if (endnotes == NULL) 
+    if (mmd->endnotes == NULL) 
         return;
-    note = g_slist_reverse(endnotes);
+    note = g_slist_reverse(mmd->endnotes);
     pad(out,2);
     g_string_append_printf(out, "\\part{Bibliography}\n\\begin{frame}[allowframebreaks]\n\\frametitle{Bibliography}\n\\def\\newblock{}\n\\begin{thebibliography}{0}\n");
     while (note != NULL) {
         note_elt = note->data;
         pad(out, 1);
         g_string_append_printf(out, "\\bibitem{%s}\n", note_elt->contents.str);
-        padded=2;
+        mmd->padded=2;
         print_latex_element_list(out, note_elt);
         pad(out, 1);
         note = note->next;
     }
     pad(out, 1);
     g_string_append_printf(out, "\\end{thebibliography}\n\\end{frame}\n\n");
-    padded = 2;
-    g_slist_free(endnotes);
+    mmd->padded = 2;
+    g_slist_free(mmd->endnotes);
 }
 
 /* print_beamer_element - print an element as LaTeX for beamer class */
@@ -2419,35 +2391,35 @@ static void print_beamer_element(GString *out, element *elt) {
         case LISTITEM:
             pad(out, 1);
             g_string_append_printf(out, "\\item<+-> ");
-            padded = 2;
+            mmd->padded = 2;
             print_latex_element_list(out, elt->children);
             g_string_append_printf(out, "\n");
             break;
         case HEADINGSECTION:
-            if (elt->children->key -H1 + base_header_level == 3) {
+            if (elt->children->key -H1 + mmd->base_header_level == 3) {
                 pad(out,2);
                g_string_append_printf(out, "\\begin{frame}");
                 if (list_contains_key(elt->children,VERBATIM)) {
                     g_string_append_printf(out, "[fragile]");
                 }
-                padded = 0;
+                mmd->padded = 0;
                 print_beamer_element_list(out, elt->children);
                 g_string_append_printf(out, "\n\n\\end{frame}\n\n");
-                padded = 2;
-            } else if (elt->children->key -H1 + base_header_level == 4) {
+                mmd->padded = 2;
+            } else if (elt->children->key -H1 + mmd->base_header_level == 4) {
                 pad(out, 1);
                 g_string_append_printf(out, "\\mode<article>{\n");
-                padded = 0;
+                mmd->padded = 0;
                 print_beamer_element_list(out, elt->children->next);
                 g_string_append_printf(out, "\n\n}\n\n");
-                padded = 2;
+                mmd->padded = 2;
             } else {
                 print_beamer_element_list(out, elt->children);
             }
             break;
         case H1: case H2: case H3: case H4: case H5: case H6:
             pad(out, 2);
-            lev = elt->key - H1 + base_header_level;  /* assumes H1 ... H6 are in order */
+            lev = elt->key - H1 + mmd->base_header_level;  /* assumes H1 ... H6 are in order */
             switch (lev) {
                 case 1:
                     g_string_append_printf(out, "\\part{");
@@ -2464,7 +2436,7 @@ static void print_beamer_element(GString *out, element *elt) {
             }
             /* generate a label for each header (MMD);
                 don't allow footnotes since invalid here */
-            no_latex_footnote = TRUE;
+            mmd->no_latex_footnote = TRUE;
             if (elt->children->key == AUTOLABEL) {
                 label = label_from_string(elt->children->contents.str,0);
                 print_latex_element_list(out, elt->children->next);
@@ -2472,12 +2444,12 @@ static void print_beamer_element(GString *out, element *elt) {
                 label = label_from_element_list(elt->children,0);
                 print_latex_element_list(out, elt->children);
             }
-            no_latex_footnote = FALSE;
+            mmd->no_latex_footnote = FALSE;
             g_string_append_printf(out, "}\n\\label{");
             g_string_append_printf(out, "%s", label);
             g_string_append_printf(out, "}\n");
             free(label);
-            padded = 1;
+            mmd->padded = 1;
             break;
         default:
         print_latex_element(out, elt);
@@ -2724,7 +2696,7 @@ static void print_opml_element(GString *out, element *elt) {
     switch (elt->key) {
         case METADATA:
             /* Metadata is present, so will need to be appended */
-            html_footer = true;
+            mmd->html_footer = true;
             break;
         case METAKEY:
             g_string_append_printf(out, "<outline text=\"");
@@ -2827,12 +2799,3 @@ void print_odf_body_element_list(GString *out, element *list) {
         list = list->next;
     }
 }
-
-/* bogus function just references a couple globals defined in utility_functions.c but not used in this source file */
-static void bogus_function()
-{
-	static char* bogus;
-    static element* bogus2;
-	bogus = charbuf;
-	bogus2 = parse_result;
-}
@@ -4,6 +4,8 @@
 
 #include "markdown_lib.h"
 #include "glib.h"
+#include <stdbool.h>
+#include <time.h>
 
 /* Information (label, URL and title) for a link. */
 struct Link {
@@ -124,14 +126,61 @@ struct Element {
 
 typedef struct Element element;
 
-element * parse_references(char *string, int extensions);
-element * parse_notes(char *string, int extensions, element *reference_list);
-element * parse_labels(char *string, int extensions, element *reference_list, element *note_list);
+/* All the state of a conversion.  The parser and the printer find the one
+   being used through mmd, which is set by the mmd_context_* functions for
+   the calling thread only, so each thread can convert with its own. */
+struct MMDContext {
+    /* Parsing */
+    struct _yycontext *parser;  /* The leg parser, which keeps its buffers. */
+    struct ArenaBlock *arena;   /* Elements and strings of the conversion. */
+    char    *charbuf;           /* Buffer of characters to be parsed. */
+    element *references;        /* List of link references found. */
+    element *notes;             /* List of footnotes found. */
+    element *labels;            /* List of labels found in document. */
+    struct LabelIndex *reference_index; /* Hash tables over the lists above, */
+    struct LabelIndex *note_index;      /* built on the first lookup. */
+    struct LabelIndex *label_index;
+    element *label_sources;     /* Headings and captions to take labels from. */
+    element *parse_result;      /* Results of parse. */
+    int     syntax_extensions;  /* Syntax extensions selected. */
+    clock_t start_time;         /* Used for ensuring we're not stuck in a loop */
+    bool    parse_aborted;      /* flag indicating we ran out of time */
+
+    /* Printing */
+    int     extensions;
+    int     base_header_level;
+    char    *latex_footer;
+    int     table_column;
+    char    *table_alignment;
+    char    cell_type;
+    int     language;
+    bool    html_footer;
+    int     odf_type;
+    bool    no_latex_footnote;
+    bool    am_printing_html_footnote;
+    int     footnote_counter_to_print;
+    int     odf_list_needs_end_p;
+    int     padded;             /* Number of newlines after last output. */
+    GSList  *endnotes;          /* List of endnotes to print after main content. */
+    int     notenumber;         /* Number of footnote. */
+    bool    in_list_item;       /* True if we're parsing contents of a list item. */
+};
+
+#if defined(_MSC_VER)
+#define MMD_THREAD_LOCAL __declspec(thread)
+#else
+#define MMD_THREAD_LOCAL __thread
+#endif
+
+extern MMD_THREAD_LOCAL mmd_context *mmd;  /* The context of this thread's conversion. */
+
+struct _yycontext * parser_new();
+void parser_free(struct _yycontext *parser);
+
+void parse_prescan(char *string, int extensions, element **reference_list, element **note_list, element **label_list);
 
 element * parse_markdown(char *string, int extensions, element *reference_list, element *note_list, element *label_list);
 element * parse_markdown_with_metadata(char *string, int extensions, element *reference_list, element *note_list, element *label_list);
-void free_element_list(element * elt);
-void free_element(element *elt);
 void print_element_list(GString *out, element *elt, int format, int exts);
 
 element * parse_metadata_only(char *string, int extensions);
@@ -9,6 +9,7 @@
 
 #ifdef _WIN32
 #define strcasecmp _stricmp
+#include <windows.h>
 #endif
 
 
@@ -51,19 +52,15 @@ void append_list(element *new, element *list) {
     step->next = new;
 }
 
-/* concat_string_list - concatenates string contents of list of STR elements.
- * Frees STR elements as they are added to the concatenation. */
+/* concat_string_list - concatenates string contents of list of STR elements. */
 GString *concat_string_list(element *list) {
     GString *result;
-    element *next;
     result = g_string_new("");
     while (list != NULL) {
         assert(list->key == STR);
         assert(list->contents.str != NULL);
         g_string_append(result, list->contents.str);
-        next = list->next;
-        free_element(list);
-        list = next;
+        list = list->next;
     }
     return result;
 }
@@ -75,15 +72,80 @@ GString *concat_string_list(element *list) {
  ***********************************************************************/
 
 
-char *charbuf = "";     /* Buffer of characters to be parsed. */
-element *references = NULL;    /* List of link references found. */
-element *notes = NULL;         /* List of footnotes found. */
-element *parse_result;  /* Results of parse. */
-int syntax_extensions;  /* Syntax extensions selected. */
+MMD_THREAD_LOCAL mmd_context *mmd = NULL;  /* The context of this thread's conversion. */
+
+/**********************************************************************
+
+  Arena allocation
+
+  The elements of a conversion and their strings are carved out of
+  large blocks owned by the context, and are all released at once
+  when the conversion is done, instead of one by one.
+
+ ***********************************************************************/
+
+#define ARENA_ALIGN(size)   (((size) + 7) & ~(size_t)7)
+#define ARENA_BLOCK_SIZE    (64 * 1024)
+
+struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;                /* Bytes in the block, header included. */
+    size_t used;
+};
+
+#define ARENA_HEADER_SIZE   ARENA_ALIGN(sizeof(struct ArenaBlock))
+
+/* arena_alloc - allocate size bytes from the arena of the current context */
+void * arena_alloc(size_t size) {
+    struct ArenaBlock *block = mmd->arena;
+    void *result;
+    size = ARENA_ALIGN(size);
+    if (block == NULL || block->size - block->used < size) {
+        if (size > ARENA_BLOCK_SIZE / 4) {
+            /* Too big to share a block; keep filling the current one. */
+            block = malloc(ARENA_HEADER_SIZE + size);
+            block->size = block->used = ARENA_HEADER_SIZE + size;
+            if (mmd->arena == NULL) {
+                block->next = NULL;
+                mmd->arena = block;
+            } else {
+                block->next = mmd->arena->next;
+                mmd->arena->next = block;
+            }
+            return (char *)block + ARENA_HEADER_SIZE;
+        }
+        block = malloc(ARENA_BLOCK_SIZE);
+        block->size = ARENA_BLOCK_SIZE;
+        block->used = ARENA_HEADER_SIZE;
+        block->next = mmd->arena;
+        mmd->arena = block;
+    }
+    result = (char *)block + block->used;
+    block->used += size;
+    return result;
+}
+
+/* arena_strdup - copy a string into the arena of the current context */
+char * arena_strdup(const char *string) {
+    size_t length = strlen(string) + 1;
+    return memcpy(arena_alloc(length), string, length);
+}
 
-element *labels = NULL;      /* List of labels found in document. */
-clock_t start_time = 0;                 /* Used for ensuring we're not stuck in a loop */
-bool parse_aborted = 0;      /* flag indicating we ran out of time */
+/* arena_release - free everything allocated from the arena of context */
+void arena_release(mmd_context *context) {
+    struct ArenaBlock *block = context->arena;
+    struct ArenaBlock *next;
+    while (block != NULL) {
+        next = block->next;
+        free(block);
+        block = next;
+    }
+    context->arena = NULL;
+    /* The indexes lived in the arena too */
+    context->reference_index = NULL;
+    context->note_index = NULL;
+    context->label_index = NULL;
+}
 
 /**********************************************************************
 
@@ -95,7 +157,7 @@ bool parse_aborted = 0;      /* flag indicating we ran out of time */
 
 /* mk_element - generic constructor for element */
 element * mk_element(int key) {
-    element *result = malloc(sizeof(element));
+    element *result = arena_alloc(sizeof(element));
     result->key = key;
     result->children = NULL;
     result->next = NULL;
@@ -108,7 +170,7 @@ element * mk_str(char *string) {
     element *result;
     assert(string != NULL);
     result = mk_element(STR);
-    result->contents.str = strdup(string);
+    result->contents.str = arena_strdup(string);
     return result;
 }
 
@@ -116,12 +178,25 @@ element * mk_str(char *string) {
  * reversed list of strings, adding optional extra newline */
 element * mk_str_from_list(element *list, bool extra_newline) {
     element *result;
-    GString *c = concat_string_list(reverse(list));
-    if (extra_newline)
-        g_string_append(c, "\n");
+    element *step;
+    size_t length = extra_newline ? 1 : 0;
+    char *str;
+    list = reverse(list);
+    for (step = list; step != NULL; step = step->next) {
+        assert(step->key == STR);
+        assert(step->contents.str != NULL);
+        length += strlen(step->contents.str);
+    }
     result = mk_element(STR);
-    result->contents.str = c->str;
-    g_string_free(c, false);
+    result->contents.str = str = arena_alloc(length + 1);
+    for (step = list; step != NULL; step = step->next) {
+        length = strlen(step->contents.str);
+        memcpy(str, step->contents.str, length);
+        str += length;
+    }
+    if (extra_newline)
+        *str++ = '\n';
+    *str = '\0';
     return result;
 }
 
@@ -139,18 +214,18 @@ element * mk_list(int key, element *lst) {
 element * mk_link(element *label, char *url, char *title, element *attr, char *id) {
     element *result;
     result = mk_element(LINK);
-    result->contents.link = malloc(sizeof(link));
+    result->contents.link = arena_alloc(sizeof(link));
     result->contents.link->label = label;
-    result->contents.link->url = strdup(url);
-    result->contents.link->title = strdup(title);
+    result->contents.link->url = arena_strdup(url);
+    result->contents.link->title = arena_strdup(title);
     result->contents.link->attr = attr;
-    result->contents.link->identifier = strdup(id);
+    result->contents.link->identifier = arena_strdup(id);
     return result;
 }
 
 /* extension = returns true if extension is selected */
 bool extension(int ext) {
-    return (syntax_extensions & ext);
+    return (mmd->syntax_extensions & ext);
 }
 
 /* match_inlines - returns true if inline lists match (case-insensitive...) */
@@ -196,37 +271,186 @@ bool match_inlines(element *l1, element *l2) {
     return (l1 == NULL && l2 == NULL);  /* return true if both lists exhausted */
 }
 
+/**********************************************************************
+
+  Label indexes
+
+  References, notes and labels are looked up in hash tables built from
+  their lists, so that a link costs the same however many references
+  the document has.  A table is built on the first lookup in its list,
+  and rebuilt only if the list is replaced.
+
+ ***********************************************************************/
+
+struct LabelIndexEntry {
+    struct LabelIndexEntry *next;
+    unsigned int hash;
+    char    *key;
+    element *elt;
+};
+
+struct LabelIndex {
+    element *list;              /* The list the table was built from. */
+    unsigned int mask;          /* Number of buckets, less one. */
+    struct LabelIndexEntry **buckets;
+};
+
+/* hash_key - FNV-1a hash of a key */
+static unsigned int hash_key(const char *key) {
+    unsigned int hash = 2166136261u;
+    while (*key != '\0') {
+        hash ^= (unsigned char)*key++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* index_new - empty table sized for the elements of list */
+static struct LabelIndex *index_new(element *list) {
+    struct LabelIndex *index = arena_alloc(sizeof(struct LabelIndex));
+    unsigned int size = 16;
+    unsigned int count = 0;
+    for (; list != NULL; list = list->next)
+        count++;
+    while (size < count * 2)
+        size *= 2;
+    index->list = NULL;
+    index->mask = size - 1;
+    index->buckets = arena_alloc(size * sizeof(struct LabelIndexEntry *));
+    memset(index->buckets, 0, size * sizeof(struct LabelIndexEntry *));
+    return index;
+}
+
+/* index_find - element stored under key, or NULL */
+static element *index_find(struct LabelIndex *index, const char *key) {
+    unsigned int hash = hash_key(key);
+    struct LabelIndexEntry *entry = index->buckets[hash & index->mask];
+    for (; entry != NULL; entry = entry->next) {
+        if (entry->hash == hash && strcmp(entry->key, key) == 0)
+            return entry->elt;
+    }
+    return NULL;
+}
+
+/* index_add - store elt under key, unless an earlier element has it.  The
+ * lists were searched from the front, so the first of a label wins. */
+static void index_add(struct LabelIndex *index, char *key, element *elt) {
+    struct LabelIndexEntry *entry;
+    struct LabelIndexEntry **bucket;
+    if (index_find(index, key) != NULL)
+        return;
+    entry = arena_alloc(sizeof(struct LabelIndexEntry));
+    entry->hash = hash_key(key);
+    entry->key = key;
+    entry->elt = elt;
+    bucket = &index->buckets[entry->hash & index->mask];
+    entry->next = *bucket;
+    *bucket = entry;
+}
+
+/* append_inline_key - append to out a key for an inline list, such that two
+ * lists have the same key exactly when match_inlines matches them: the
+ * same elements, with text compared case-insensitively and any kind of
+ * space alike.  Returns false for lists that match nothing, such as those
+ * with links in them. */
+static bool append_inline_key(GString *out, element *list) {
+    char *s;
+    for (; list != NULL; list = list->next) {
+        g_string_append_printf(out, "%d", list->key);
+        switch (list->key) {
+        case SPACE:
+        case LINEBREAK:
+        case ELLIPSIS:
+        case EMDASH:
+        case ENDASH:
+        case APOSTROPHE:
+            break;
+        case CODE:
+        case STR:
+        case HTML:
+            g_string_append_printf(out, "'%d:", (int)strlen(list->contents.str));
+            for (s = list->contents.str; *s != '\0'; s++)
+                g_string_append_c(out, tolower((unsigned char)*s));
+            break;
+        case EMPH:
+        case STRONG:
+        case LIST:
+        case SINGLEQUOTED:
+        case DOUBLEQUOTED:
+            g_string_append_c(out, '(');
+            if (!append_inline_key(out, list->children))
+                return false;
+            g_string_append_c(out, ')');
+            break;
+        default:
+            return false;
+        }
+        g_string_append_c(out, ',');
+    }
+    return true;
+}
+
+/* reference_index - the index of the current references, keyed by the
+ * inline key of their labels */
+static struct LabelIndex *reference_index() {
+    struct LabelIndex *index = mmd->reference_index;
+    element *cur;
+    GString *key;
+    if (index != NULL && index->list == mmd->references)
+        return index;
+    index = index_new(mmd->references);
+    key = g_string_new("");
+    for (cur = mmd->references; cur != NULL; cur = cur->next) {
+        g_string_truncate(key, 0);
+        if (append_inline_key(key, cur->contents.link->label))
+            index_add(index, arena_strdup(key->str), cur);
+    }
+    g_string_free(key, true);
+    index->list = mmd->references;
+    mmd->reference_index = index;
+    return index;
+}
+
 /* find_reference - return true if link found in references matching label.
  * 'link' is modified with the matching url and title. */
 bool find_reference(link *result, element *label) {
-    element *cur = references;  /* pointer to walk up list of references */
-    link *curitem;
-    while (cur != NULL) {
-        curitem = cur->contents.link;
-        if (match_inlines(label, curitem->label)) {
-            *result = *curitem;
-            return true;
-        }
-        else
-            cur = cur->next;
-    }
-    return false;
+    struct LabelIndex *index;
+    element *match = NULL;
+    GString *key;
+    if (mmd->references == NULL)
+        return false;
+    index = reference_index();
+    key = g_string_new("");
+    if (append_inline_key(key, label))
+        match = index_find(index, key->str);
+    g_string_free(key, true);
+    if (match == NULL)
+        return false;
+    *result = *match->contents.link;
+    return true;
 }
 
 /* find_note - return true if note found in notes matching label.
 if found, 'result' is set to point to matched note. */
 
 bool find_note(element **result, char *label) {
-   element *cur = notes;  /* pointer to walk up list of notes */
-   while (cur != NULL) {
-       if (strcmp(label, cur->contents.str) == 0) {
-           *result = cur;
-           return true;
-       }
-       else
-           cur = cur->next;
-   }
-   return false;
+    struct LabelIndex *index = mmd->note_index;
+    element *cur;
+    element *match;
+    if (mmd->notes == NULL)
+        return false;
+    if (index == NULL || index->list != mmd->notes) {
+        index = index_new(mmd->notes);
+        for (cur = mmd->notes; cur != NULL; cur = cur->next)
+            index_add(index, cur->contents.str, cur);
+        index->list = mmd->notes;
+        mmd->note_index = index;
+    }
+    match = index_find(index, label);
+    if (match == NULL)
+        return false;
+    *result = match;
+    return true;
 }
 
 
@@ -305,26 +529,27 @@ char *label_from_string(char *str, bool obfuscate) {
  * 'link' is modified with the matching url and title. */
 bool find_label(link *result, element *label) {
     char *lab;
-    GString *query;
-    element *cur = labels;  /* pointer to walk up list of references */
-    GString *text = g_string_new("");
+    bool found;
+    struct LabelIndex *index = mmd->label_index;
+    element *cur;
+    GString *text;
+    if (mmd->labels == NULL)
+        return false;
+    if (index == NULL || index->list != mmd->labels) {
+        index = index_new(mmd->labels);
+        for (cur = mmd->labels; cur != NULL; cur = cur->next)
+            index_add(index, cur->contents.str, cur);
+        index->list = mmd->labels;
+        mmd->label_index = index;
+    }
+
+    text = g_string_new("");
     print_raw_element_list(text, label);
     lab = label_from_string(text->str,0);
-
-    query = g_string_new(lab);
+    found = index_find(index, lab) != NULL;
     free(lab);
     g_string_free(text, true);
-
-    while (cur != NULL) {
-        if (strcmp(query->str,cur->contents.str) == 0) {
-            g_string_free(query, true);
-            return true;
-        }
-        else
-           cur = cur->next;
-    }
-    g_string_free(query, true);
-    return false;
+    return found;
 }
 
 
@@ -518,21 +743,44 @@ void trim_trailing_whitespace(char *str) {
     }
 }
 
+/* thread_clock - processor time used by the calling thread.  clock() counts
+   all the threads of the process, which would time a conversion out sooner
+   while others run at the same time. */
+clock_t thread_clock() {
+#if defined(_WIN32)
+    FILETIME creation, exited, kernel, user;
+    ULARGE_INTEGER used;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exited, &kernel, &user))
+        return clock();
+    used.LowPart = user.dwLowDateTime;
+    used.HighPart = user.dwHighDateTime;
+    return (clock_t) (used.QuadPart / (10000000 / CLOCKS_PER_SEC));
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec used;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &used) != 0)
+        return clock();
+    return (clock_t) (used.tv_sec * CLOCKS_PER_SEC
+                      + used.tv_nsec / (1000000000 / CLOCKS_PER_SEC));
+#else
+    return clock();
+#endif
+}
+
 /* Don't let us get caught in "infinite" loop */
 bool check_timeout() {
     clock_t end;
     float max;
     double elapsed;
     /* Once we abort, keep aborting */
-    if (parse_aborted)
+    if (mmd->parse_aborted)
         return 0;
     
     /* We're not timing this run */
-    if (start_time == 0)
+    if (mmd->start_time == 0)
         return 1;
 
-    end = clock();
-    elapsed = ((double) (end - start_time)) / CLOCKS_PER_SEC;
+    end = thread_clock();
+    elapsed = ((double) (end - mmd->start_time)) / CLOCKS_PER_SEC;
     
 	/* fprintf(stderr,"%2.2f elapsed; (%4.2f CLOCKS_PER_SEC)\n",elapsed,CLOCKS_PER_SEC); */
 	/* fprintf(stderr,"%2.2f elapsed\n",elapsed); */
@@ -541,7 +789,7 @@ bool check_timeout() {
     /* If > 3 clock seconds, then abort */
     max = 3;
     if (elapsed > max) {
-        parse_aborted = 1;
+        mmd->parse_aborted = 1;
         return 0;
     }
     return 1;
@@ -17,25 +17,17 @@ element * cons(element *new, element *list);
 
 /* reverse - reverse a list, returning pointer to new list */
 element *reverse(element *list);
-/* concat_string_list - concatenates string contents of list of STR elements.
- * Frees STR elements as they are added to the concatenation. */
+/* concat_string_list - concatenates string contents of list of STR elements. */
 GString *concat_string_list(element *list);
-/**********************************************************************
-
-  Global variables used in parsing
-
- ***********************************************************************/
-
-extern char *charbuf;          /* Buffer of characters to be parsed. */
-extern element *references;    /* List of link references found. */
-extern element *notes;         /* List of footnotes found. */
-extern element *parse_result;  /* Results of parse. */
-extern int syntax_extensions;  /* Syntax extensions selected. */
+/* arena_alloc - allocate size bytes from the arena of the current context.
+ * Elements and their strings live there until arena_release. */
+void * arena_alloc(size_t size);
 
+/* arena_strdup - copy a string into the arena of the current context */
+char * arena_strdup(const char *string);
 
-extern element *labels;	       /* List of labels found in document. */
-extern clock_t start_time;     /* Used for ensuring we're not stuck in a loop */
-extern bool parse_aborted;     /* flag indicating we ran out of time */
+/* arena_release - free everything allocated from the arena of context */
+void arena_release(mmd_context *context);
 
 /**********************************************************************
 
@@ -83,6 +75,9 @@ void localize_typography(GString *out, int character, int language, int output);
 void print_raw_element_list(GString *out, element *list);   
 void append_list(element *new, element *list);
 bool find_label(link *result, element *label);
+/* thread_clock - processor time used by the calling thread */
+clock_t thread_clock();
+
 bool check_timeout();
 void trim_trailing_whitespace(char *str);
 char *label_from_element_list(element *list, bool obfuscate);
@@ -128,6 +128,19 @@ void g_string_append(GString* baseString, char* appendedString)
 	}
 }
 
+void g_string_append_len(GString* baseString, char* appendedString, size_t appendedStringLength)
+{
+	if ((appendedString != NULL) && (appendedStringLength > 0))
+	{
+		size_t newStringLength = baseString->currentStringLength + appendedStringLength;
+		ensureStringBufferCanHold(baseString, newStringLength);
+
+		memcpy(baseString->str + baseString->currentStringLength, appendedString, appendedStringLength);
+		baseString->str[newStringLength] = '\0';
+		baseString->currentStringLength = newStringLength;
+	}
+}
+
 void g_string_append_c(GString* baseString, char appendedCharacter)
 {	
 	size_t newSizeNeeded = baseString->currentStringLength + 1;
@@ -140,19 +153,40 @@ void g_string_append_c(GString* baseString, char appendedCharacter)
 
 void g_string_append_printf(GString* baseString, char* format, ...)
 {
-    char* formattedString = NULL;
 	va_list args;
+	int room;
+	int wanted;
+
+	/* Format straight into the spare room of the buffer, and only grow it
+	   and format again when the result does not fit */
+	room = baseString->currentStringBufferSize - baseString->currentStringLength;
 	va_start(args, format);
-	
+	wanted = vsnprintf(baseString->str + baseString->currentStringLength, room, format, args);
+	va_end(args);
+	if (wanted < 0)
+	{
+		baseString->str[baseString->currentStringLength] = '\0';
+		return;
+	}
+	if (wanted >= room)
+	{
+		ensureStringBufferCanHold(baseString, baseString->currentStringLength + wanted);
+		va_start(args, format);
+		vsnprintf(baseString->str + baseString->currentStringLength, wanted + 1, format, args);
+		va_end(args);
+	}
+	baseString->currentStringLength += wanted;
+}
 
-	vasprintf(&formattedString, format, args);
-	if (formattedString != NULL)
+GString* g_string_truncate(GString* baseString, size_t newStringLength)
+{
+	if (newStringLength < (size_t)baseString->currentStringLength)
 	{
-		g_string_append(baseString, formattedString);
-		free(formattedString);
+		baseString->currentStringLength = newStringLength;
+		baseString->str[newStringLength] = '\0';
 	}
-	va_end(args);
-} 
+	return baseString;
+}
 
 void g_string_prepend(GString* baseString, char* prependedString)
 {
@@ -15,6 +15,7 @@
 #undef link
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <ctype.h>
 
 typedef int gboolean;
@@ -47,9 +48,12 @@ char* g_string_free(GString* ripString, bool freeCharacterData);
 
 void g_string_append_c(GString* baseString, char appendedCharacter);
 void g_string_append(GString* baseString, char *appendedString);
+void g_string_append_len(GString* baseString, char *appendedString, size_t appendedStringLength);
 
 void g_string_prepend(GString* baseString, char* prependedString);
 
+GString* g_string_truncate(GString* baseString, size_t newStringLength);
+
 void g_string_append_printf(GString* baseString, char* format, ...);
 
 /* Just implement a very simple singly linked list. */
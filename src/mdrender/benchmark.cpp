@@ -0,0 +1,106 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#include <stdio.h>
+#include <algorithm>
+
+#include <QtGlobal>
+#include <QElapsedTimer>
+
+#if defined(Q_OS_WIN)
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+#include "benchmark.h"
+#include "markdownrenderer.h"
+#include "rendercache.h"
+#include "html.h"
+
+using namespace std;
+
+namespace {
+const int MIN_ITERATIONS = 3;
+const int MAX_ITERATIONS = 500;
+const qint64 TIME_BUDGET_NS = 1000*1000*1000;
+
+double percentile(const vector<qint64> &sorted, int p)
+{
+    size_t i = (sorted.size()*p+99)/100;
+    if(i>0)
+        i--;
+    return sorted[i]/1000000.0;
+}
+}
+
+Benchmark::Benchmark(MarkdownToHtml::MarkdownType type, const char *engineName, int iterations)
+{
+    this->type = type;
+    this->engineName = engineName;
+    this->iterations = iterations;
+}
+
+void Benchmark::printHeader()
+{
+    printf("%-14s %-10s %10s %9s %10s %10s %12s\n",
+           "engine", "document", "size KB", "MB/s", "p50 ms", "p99 ms", "peak RSS KB");
+}
+
+void Benchmark::run(const vector<BenchmarkCorpus::Document> &documents)
+{
+    //repeated renders of the same text would only measure the cache
+    RenderCache::instance()->setBudget(0);
+    MarkdownRenderer renderer(sdhtml_renderer);
+    for(size_t i=0; i<documents.size(); i++){
+        const BenchmarkCorpus::Document &document = documents[i];
+        //the first render allocates the buffers, it is not timed
+        renderer.render(type, document.text.c_str(), document.text.size());
+        vector<qint64> times;
+        qint64 total = 0;
+        QElapsedTimer timer;
+        while(iterations>0 ? (int)times.size()<iterations
+              : (int)times.size()<MIN_ITERATIONS
+                || (total<TIME_BUDGET_NS && (int)times.size()<MAX_ITERATIONS)){
+            timer.start();
+            renderer.render(type, document.text.c_str(), document.text.size());
+            qint64 elapsed = timer.nsecsElapsed();
+            times.push_back(elapsed);
+            total += elapsed;
+        }
+        sort(times.begin(), times.end());
+        double seconds = total/1000000000.0;
+        double mb = document.text.size()*times.size()/(1024.0*1024.0);
+        printf("%-14s %-10s %10.1f %9.1f %10.3f %10.3f %12ld\n",
+               engineName, document.name.c_str(),
+               document.text.size()/1024.0,
+               seconds>0 ? mb/seconds : 0.0,
+               percentile(times, 50), percentile(times, 99), peakRssKb());
+        fflush(stdout);
+    }
+}
+
+/**
+ * @brief Benchmark::peakRssKb The most memory the process has used, -1 if the
+ *        system does not tell.
+ */
+long Benchmark::peakRssKb()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return -1;
+    return (long)(counters.PeakWorkingSetSize/1024);
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage)!=0)
+        return -1;
+#if defined(Q_OS_MAC)
+    return usage.ru_maxrss/1024;//bytes on OS X
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
@@ -0,0 +1,32 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <vector>
+
+#include "markdowntohtml.h"
+#include "benchmarkcorpus.h"
+
+/**
+ * @brief Renders every document with one engine, iterations times (or for
+ *        about a second when iterations is 0), and prints a row per document
+ *        with the throughput, the p50 and p99 render time and the peak RSS of
+ *        the process so far. The render cache is turned off while it runs.
+ */
+class Benchmark
+{
+public:
+    Benchmark(MarkdownToHtml::MarkdownType type, const char *engineName, int iterations);
+    void run(const std::vector<BenchmarkCorpus::Document> &documents);
+    static void printHeader();
+    static long peakRssKb();
+private:
+    MarkdownToHtml::MarkdownType type;
+    const char *engineName;
+    int iterations;
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,383 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#include <stdio.h>
+
+#include "benchmarkcorpus.h"
+
+using namespace std;
+
+namespace {
+const size_t SPEC_SIZE = 10*1024*1024;
+const size_t README_SIZE = 256*1024;
+const size_t PAPER_SIZE = 1024*1024;
+
+const char *WORDS[] = {
+    "the", "parser", "renders", "a", "document", "block", "of", "inline",
+    "text", "with", "emphasis", "and", "links", "to", "every", "section",
+    "markdown", "editor", "preview", "is", "updated", "when", "user",
+    "types", "header", "list", "item", "table", "cell", "quote", "code",
+    "span", "reference", "footnote", "number", "value", "returns", "buffer",
+    "memory", "in", "for", "on", "each", "line", "but", "not", "only"
+};
+const size_t WORD_COUNT = sizeof(WORDS)/sizeof(WORDS[0]);
+
+//a small linear congruential generator, the corpus must not depend on rand()
+class Words
+{
+public:
+    Words() : state(20140101) {}
+    unsigned int next(unsigned int range)
+    {
+        state = state*1103515245u+12345u;
+        return (state>>16)%range;
+    }
+    const char* word()
+    {
+        return WORDS[next(WORD_COUNT)];
+    }
+    void sentence(string &text, int words)
+    {
+        for(int i=0; i<words; i++){
+            const char *w = word();
+            if(i==0){
+                text += (char)(w[0]-'a'+'A');
+                text += w+1;
+            } else {
+                text += ' ';
+                text += w;
+            }
+        }
+        text += ". ";
+    }
+private:
+    unsigned int state;
+};
+
+string number(size_t n)
+{
+    char s[24];
+    sprintf(s, "%lu", (unsigned long)n);
+    return s;
+}
+
+const char *CPP_CODE =
+        "#include <string>\n"
+        "#include <vector>\n"
+        "\n"
+        "namespace render {\n"
+        "// split a document into its lines\n"
+        "std::vector<std::string> splitLines(const std::string &text)\n"
+        "{\n"
+        "    std::vector<std::string> lines;\n"
+        "    size_t start = 0;\n"
+        "    for(size_t i=0; i<text.size(); i++){\n"
+        "        if(text[i]=='\\n'){\n"
+        "            lines.push_back(text.substr(start, i-start));\n"
+        "            start = i+1;\n"
+        "        }\n"
+        "    }\n"
+        "    if(start<text.size())\n"
+        "        lines.push_back(text.substr(start));\n"
+        "    return lines;\n"
+        "}\n"
+        "}\n";
+
+const char *PYTHON_CODE =
+        "import os\n"
+        "import sys\n"
+        "\n"
+        "class Renderer(object):\n"
+        "    \"\"\"Render every markdown file of a directory.\"\"\"\n"
+        "    def __init__(self, root, extensions=('.md', '.markdown')):\n"
+        "        self.root = root\n"
+        "        self.extensions = extensions\n"
+        "\n"
+        "    def files(self):\n"
+        "        for path, dirs, names in os.walk(self.root):\n"
+        "            for name in names:\n"
+        "                if name.endswith(self.extensions):\n"
+        "                    yield os.path.join(path, name)\n"
+        "\n"
+        "if __name__ == '__main__':\n"
+        "    for f in Renderer(sys.argv[1]).files():\n"
+        "        print(f)\n";
+
+const char *JAVASCRIPT_CODE =
+        "function debounce(fn, wait) {\n"
+        "    var timer = null;\n"
+        "    return function () {\n"
+        "        var args = arguments, self = this;\n"
+        "        clearTimeout(timer);\n"
+        "        timer = setTimeout(function () {\n"
+        "            fn.apply(self, args);\n"
+        "        }, wait);\n"
+        "    };\n"
+        "}\n"
+        "\n"
+        "var update = debounce(function (html) {\n"
+        "    document.getElementById('preview').innerHTML = html;\n"
+        "}, 150);\n";
+
+const char *BASH_CODE =
+        "#!/bin/sh\n"
+        "set -e\n"
+        "for f in docs/*.md; do\n"
+        "    out=\"build/$(basename \"$f\" .md).html\"\n"
+        "    if [ \"$f\" -nt \"$out\" ]; then\n"
+        "        mdrender -o \"$out\" \"$f\"\n"
+        "        echo \"rendered $f\"\n"
+        "    fi\n"
+        "done\n";
+
+const char *JSON_CODE =
+        "{\n"
+        "    \"name\": \"mdcharm\",\n"
+        "    \"engines\": [\"markdown\", \"extra\", \"multimarkdown\"],\n"
+        "    \"preview\": {\"debounce\": 150, \"incremental\": true},\n"
+        "    \"cache\": {\"size\": 32, \"enabled\": true}\n"
+        "}\n";
+
+const char *SQL_CODE =
+        "CREATE TABLE documents (\n"
+        "    id INTEGER PRIMARY KEY AUTOINCREMENT,\n"
+        "    path VARCHAR(255) NOT NULL UNIQUE,\n"
+        "    engine VARCHAR(16) DEFAULT 'extra',\n"
+        "    modified TIMESTAMP DEFAULT CURRENT_TIMESTAMP\n"
+        ");\n"
+        "\n"
+        "-- documents rendered more than once since yesterday\n"
+        "SELECT d.path, COUNT(r.id) AS renders, MAX(r.elapsed) AS slowest\n"
+        "FROM documents d\n"
+        "LEFT OUTER JOIN renders r ON r.document_id = d.id\n"
+        "WHERE r.started > DATE('now', '-1 day') AND d.engine IN ('extra', 'multimarkdown')\n"
+        "GROUP BY d.path\n"
+        "HAVING COUNT(r.id) > 1\n"
+        "ORDER BY slowest DESC\n"
+        "LIMIT 20;\n"
+        "\n"
+        "UPDATE documents SET engine = 'markdown' WHERE path LIKE '%.mkd' AND NOT EXISTS\n"
+        "    (SELECT 1 FROM renders WHERE renders.document_id = documents.id);\n"
+        "DELETE FROM renders WHERE started < DATE('now', '-30 days');\n";
+
+const char *PHP_CODE =
+        "<?php\n"
+        "namespace MdCharm\\Render;\n"
+        "\n"
+        "abstract class Renderer implements RendererInterface\n"
+        "{\n"
+        "    const DEFAULT_ENGINE = 'extra';\n"
+        "    protected static $instances = array();\n"
+        "    private $cache = null;\n"
+        "\n"
+        "    public function __construct(Cache $cache = null)\n"
+        "    {\n"
+        "        $this->cache = $cache;\n"
+        "    }\n"
+        "\n"
+        "    public function render($text, $engine = self::DEFAULT_ENGINE)\n"
+        "    {\n"
+        "        if (!is_string($text) || empty($text)) {\n"
+        "            return '';\n"
+        "        }\n"
+        "        $key = md5($engine . $text);\n"
+        "        if ($this->cache !== null && isset($this->cache[$key])) {\n"
+        "            return $this->cache[$key];\n"
+        "        }\n"
+        "        try {\n"
+        "            $html = $this->convert($text, $engine);\n"
+        "        } catch (Exception $e) {\n"
+        "            throw new RenderException($e->getMessage(), 0, $e);\n"
+        "        }\n"
+        "        foreach (static::$instances as $name => $renderer) {\n"
+        "            echo $name, ' ', strlen($html), \"\\n\";\n"
+        "        }\n"
+        "        return $this->cache[$key] = $html;\n"
+        "    }\n"
+        "\n"
+        "    abstract protected function convert($text, $engine);\n"
+        "}\n"
+        "?>\n";
+
+const char *CODE_LANGUAGES[] = {"cpp", "python", "javascript", "bash", "json", "sql", "php"};
+const char **CODES[] = {&CPP_CODE, &PYTHON_CODE, &JAVASCRIPT_CODE, &BASH_CODE, &JSON_CODE, &SQL_CODE, &PHP_CODE};
+const int CODE_COUNT = sizeof(CODE_LANGUAGES)/sizeof(CODE_LANGUAGES[0]);
+}
+
+vector<BenchmarkCorpus::Document> BenchmarkCorpus::documents()
+{
+    vector<Document> documents(4);
+    documents[0].name = "notes";
+    documents[0].text = notes();
+    documents[1].name = "spec";
+    documents[1].text = spec();
+    documents[2].name = "readme";
+    documents[2].text = readme();
+    documents[3].name = "paper";
+    documents[3].text = paper();
+    return documents;
+}
+
+/**
+ * @brief BenchmarkCorpus::code A short sample program in language, empty if
+ *        there is none.
+ */
+string BenchmarkCorpus::code(const string &language)
+{
+    for(int i=0; i<CODE_COUNT; i++){
+        if(language==CODE_LANGUAGES[i])
+            return *CODES[i];
+    }
+    return string();
+}
+
+string BenchmarkCorpus::notes()
+{
+    return "# Meeting notes\n"
+           "\n"
+           "Monday, *preview* and **export** work items.\n"
+           "\n"
+           "## Done\n"
+           "\n"
+           "- Render the toc together with the preview\n"
+           "- Keep the `utf-8` copy of the document up to date\n"
+           "- Cache renders shared by [split views](#split)\n"
+           "\n"
+           "## Todo\n"
+           "\n"
+           "1. Measure the edit to preview latency\n"
+           "2. Profile MultiMarkdown on large files\n"
+           "3. Load the spell check dictionaries in the background\n"
+           "\n"
+           "> Typing in a 10 MB document should still feel instant.\n"
+           "\n"
+           "See <http://www.mdcharm.com/> for the release notes.\n";
+}
+
+string BenchmarkCorpus::spec()
+{
+    Words words;
+    string text;
+    text.reserve(SPEC_SIZE+4096);
+    text += "# Specification\n\n";
+    for(size_t section=1; text.size()<SPEC_SIZE; section++){
+        string id = number(section);
+        text += "## " + id + ". ";
+        words.sentence(text, 4);
+        text += "\n\n";
+        for(int p=0; p<3; p++){
+            for(int s=0; s<4; s++)
+                words.sentence(text, 8+words.next(8));
+            text += "Using *" + string(words.word()) + "* and **" + words.word()
+                    + "** with `" + words.word() + "()` as in [section "
+                    + id + "][ref-" + id + "].\n\n";
+        }
+        text += "- ";
+        words.sentence(text, 6);
+        text += "\n- ";
+        words.sentence(text, 6);
+        text += "\n    - ";
+        words.sentence(text, 5);
+        text += "\n\n";
+        if(section%5==0){
+            text += "| Name | Value | Description |\n"
+                    "|------|------:|-------------|\n";
+            for(int row=0; row<4; row++){
+                text += string("| ") + words.word() + " | " + number(words.next(1000)) + " | ";
+                words.sentence(text, 5);
+                text += "|\n";
+            }
+            text += "\n";
+        }
+        if(section%3==0){
+            text += "> ";
+            words.sentence(text, 12);
+            text += "\n\n    value = parse(section_" + id + ");\n    render(value);\n\n";
+        }
+        text += "[ref-" + id + "]: http://example.com/spec/" + id + " \"Section " + id + "\"\n\n";
+    }
+    return text;
+}
+
+string BenchmarkCorpus::readme()
+{
+    const char *languages[] = {"cpp", "python", "javascript", "bash", "json"};
+    const char *codes[] = {CPP_CODE, PYTHON_CODE, JAVASCRIPT_CODE, BASH_CODE, JSON_CODE};
+    Words words;
+    string text;
+    text.reserve(README_SIZE+4096);
+    text += "# README\n\n";
+    for(size_t i=0; text.size()<README_SIZE; i++){
+        text += "### Example " + number(i+1) + "\n\n";
+        words.sentence(text, 10);
+        text += "\n\n```" + string(languages[i%5]) + "\n" + codes[i%5] + "```\n\n";
+    }
+    return text;
+}
+
+string BenchmarkCorpus::paper()
+{
+    Words words;
+    string text;
+    string notes;
+    string refs;
+    text.reserve(PAPER_SIZE+PAPER_SIZE/2);
+    text += "# A Paper\n\n";
+    size_t footnote = 1;
+    for(size_t paragraph=1; text.size()+notes.size()+refs.size()<PAPER_SIZE; paragraph++){
+        if(paragraph%10==1){
+            text += "## Part " + number(paragraph/10+1) + "\n\n";
+        }
+        for(int s=0; s<5; s++){
+            words.sentence(text, 10+words.next(10));
+            if(s%2==0){
+                string id = number(footnote++);
+                text.insert(text.size()-2, "[^" + id + "]");
+                notes += "[^" + id + "]: ";
+                words.sentence(notes, 12);
+                notes += "\n\n";
+            }
+        }
+        string id = number(paragraph);
+        text += "See [" + string(words.word()) + " et al.][cite-" + id + "].\n\n";
+        refs += "[cite-" + id + "]: http://example.com/papers/" + id + "\n";
+    }
+    text += notes;
+    text += refs;
+    return text;
+}
+
+/**
+ * @brief BenchmarkCorpus::references A paragraph per definition, citing a
+ *        random reference and the next footnote, then refs reference and
+ *        footnotes footnote definitions. The text grows with the counts, so
+ *        the render time should too, and no faster.
+ */
+string BenchmarkCorpus::references(size_t refs, size_t footnotes)
+{
+    Words words;
+    string text;
+    string notes;
+    string defs;
+    text += "# References\n\n";
+    for(size_t i=1; i<=refs || i<=footnotes; i++){
+        words.sentence(text, 8+words.next(8));
+        if(i<=footnotes){
+            string id = number(i);
+            text.insert(text.size()-2, "[^" + id + "]");
+            notes += "[^" + id + "]: ";
+            words.sentence(notes, 8);
+            notes += "\n\n";
+        }
+        if(i<=refs){
+            string id = number(i);
+            text += "See [" + string(words.word()) + "][cite-" + number(words.next(refs)+1) + "].";
+            defs += "[cite-" + id + "]: http://example.com/papers/" + id + " \"Paper " + id + "\"\n";
+        }
+        text += "\n\n";
+    }
+    text += notes;
+    text += defs;
+    return text;
+}
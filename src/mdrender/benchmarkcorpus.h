@@ -0,0 +1,36 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#ifndef BENCHMARKCORPUS_H
+#define BENCHMARKCORPUS_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief The documents mdrender --benchmark renders when no files are given.
+ *        They are generated, the same bytes on every run, instead of being
+ *        checked in: a short note, a 10 MB specification, a README which is
+ *        mostly fenced code and a paper full of footnotes and references.
+ */
+class BenchmarkCorpus
+{
+public:
+    struct Document
+    {
+        std::string name;
+        std::string text;
+    };
+
+public:
+    static std::vector<Document> documents();
+    static std::string notes();
+    static std::string spec();
+    static std::string readme();
+    static std::string paper();
+    static std::string references(size_t refs, size_t footnotes);
+    static std::string code(const std::string &language);
+};
+
+#endif // BENCHMARKCORPUS_H
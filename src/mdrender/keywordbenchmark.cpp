@@ -0,0 +1,164 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#include <stdio.h>
+#include <ctype.h>
+
+#include <QElapsedTimer>
+
+#include "keywordbenchmark.h"
+#include "codesyntaxhighlighter.h"
+#include "benchmarkcorpus.h"
+
+using namespace std;
+
+namespace {
+const char *LANGUAGES[] = {"cpp", "sql", "php"};
+const int LANGUAGE_COUNT = 3;
+const int MIN_ROUNDS = 3;
+const qint64 TIME_BUDGET_NS = 1000*1000*1000;
+//a few hundred lexemes are too quick to time one by one
+const int SAMPLE_COPIES = 64;
+//the results are summed into it, so that the lookups are not optimized away
+volatile unsigned long long sink;
+}
+
+KeywordBenchmark::KeywordBenchmark(int iterations)
+{
+    this->iterations = iterations;
+}
+
+void KeywordBenchmark::printHeader()
+{
+    printf("%-10s %-14s %9s %9s %10s %10s %8s\n",
+           "language", "keywords of", "keywords", "lexemes", "list ns", "table ns", "speedup");
+}
+
+bool KeywordBenchmark::run()
+{
+    LanguageManager *languageManager = LanguageManager::getInstance();
+    vector<Table> tables;
+    for(int i=0; i<LANGUAGE_COUNT; i++){
+        Language *lan = languageManager->getLanguage(LANGUAGES[i]);
+        if(!lan){
+            fprintf(stderr, "mdrender: the %s highlighter is not loaded\n", LANGUAGES[i]);
+            return false;
+        }
+        string code;
+        string sample = BenchmarkCorpus::code(LANGUAGES[i]);
+        for(int c=0; c<SAMPLE_COPIES; c++)
+            code += sample;
+        //the language and every mode with keywords of its own, sql keeps
+        //them all in its operator mode
+        if(!lan->getKeywords().empty()){
+            Table table;
+            table.language = LANGUAGES[i];
+            table.name = "language";
+            table.lan = lan;
+            table.contain = NULL;
+            table.caseSensitive = lan->isCaseSensitive();
+            table.keywords = lan->getKeywords();
+            cutLexemes(lan->getLexemsRe(), code, table.lexemes);
+            tables.push_back(table);
+        }
+        list<Contain *> &contains = lan->getContains();
+        for(list<Contain *>::iterator it=contains.begin(); it!=contains.end(); it++){
+            Contain *contain = *it;
+            if(contain->getKeywords().empty())
+                continue;
+            Table table;
+            table.language = LANGUAGES[i];
+            table.name = contain->getRealName();
+            table.lan = lan;
+            table.contain = contain;
+            table.caseSensitive = lan->isCaseSensitive();
+            table.keywords = contain->getKeywords();
+            cutLexemes(contain->getLexemsRe(), code, table.lexemes);
+            tables.push_back(table);
+        }
+    }
+
+    bool same = true;
+    for(size_t i=0; i<tables.size(); i++){
+        Table &table = tables[i];
+        //both lookups have to classify every lexeme the same way
+        for(size_t l=0; l<table.lexemes.size(); l++){
+            const string &lexeme = table.lexemes[l];
+            int expected = listMatch(table.keywords, table.caseSensitive, lexeme);
+            int got = table.contain ? table.contain->matchKeyword(lexeme.c_str(), lexeme.length())
+                                    : table.lan->matchKeyword(lexeme.c_str(), lexeme.length());
+            if(expected!=got){
+                fprintf(stderr, "mdrender: %s %s: \"%s\" is %d in the list but %d in the table\n",
+                        table.language.c_str(), table.name.c_str(), lexeme.c_str(), expected, got);
+                same = false;
+            }
+        }
+        time(table);
+    }
+    return same;
+}
+
+void KeywordBenchmark::cutLexemes(RegExp &lexemsRe, const string &code, vector<string> &lexemes)
+{
+    RegExpSubject subject;
+    subject.assign(code.c_str(), code.length());
+    FindResult fr = lexemsRe.exec(subject, 0);
+    while(fr.isValid() && fr.end>fr.start){
+        lexemes.push_back(code.substr(fr.start, fr.end-fr.start));
+        fr = lexemsRe.exec(subject, fr.end);
+    }
+}
+
+//the lookup before KeywordTable: a lower cased copy of the lexeme if the
+//language is not case sensitive, compared with every keyword in turn
+int KeywordBenchmark::listMatch(list<Keywords> &keywords, bool caseSensitive, const string &lexeme)
+{
+    string k(lexeme);
+    if(!caseSensitive){
+        for(unsigned int i=0; i<lexeme.length(); i++)
+            k[i] = tolower(lexeme[i]);
+    }
+    for(list<Keywords>::iterator it=keywords.begin(); it!=keywords.end(); it++){
+        if(it->getKeyword()==k)
+            return it->getType();
+    }
+    return Keywords::NotFound;
+}
+
+void KeywordBenchmark::time(Table &table)
+{
+    const vector<string> &lexemes = table.lexemes;
+    if(lexemes.empty())
+        return;
+    unsigned long long sum = 0;
+    qint64 listNs = 0, tableNs = 0;
+    int rounds = 0;
+    QElapsedTimer timer;
+    while(iterations>0 ? rounds<iterations
+          : rounds<MIN_ROUNDS || listNs+tableNs<TIME_BUDGET_NS){
+        timer.start();
+        for(size_t l=0; l<lexemes.size(); l++)
+            sum += listMatch(table.keywords, table.caseSensitive, lexemes[l]);
+        listNs += timer.nsecsElapsed();
+
+        timer.start();
+        if(table.contain){
+            for(size_t l=0; l<lexemes.size(); l++)
+                sum += table.contain->matchKeyword(lexemes[l].c_str(), lexemes[l].length());
+        } else {
+            for(size_t l=0; l<lexemes.size(); l++)
+                sum += table.lan->matchKeyword(lexemes[l].c_str(), lexemes[l].length());
+        }
+        tableNs += timer.nsecsElapsed();
+        rounds++;
+    }
+    double lookups = (double)lexemes.size()*rounds;
+    printf("%-10s %-14s %9lu %9lu %10.1f %10.1f %7.1fx\n",
+           table.language.c_str(), table.name.c_str(),
+           (unsigned long)table.keywords.size(), (unsigned long)(lexemes.size()/SAMPLE_COPIES),
+           listNs/lookups, tableNs/lookups,
+           tableNs>0 ? (double)listNs/tableNs : 0.0);
+    sink = sum;
+    fflush(stdout);
+}
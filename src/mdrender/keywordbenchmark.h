@@ -0,0 +1,48 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#ifndef KEYWORDBENCHMARK_H
+#define KEYWORDBENCHMARK_H
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "languagedefinationxmlparser.h"
+
+/**
+ * @brief Times the keyword lookups of the cpp, sql and php highlighters. The
+ *        lexemes are cut from a sample program with the lexems regex of each
+ *        keyword table, then looked up iterations times (or for about a
+ *        second when iterations is 0) by walking the keyword list, as the
+ *        highlighter did before, and in the KeywordTable. The languages have
+ *        to be loaded into the LanguageManager first.
+ */
+class KeywordBenchmark
+{
+public:
+    KeywordBenchmark(int iterations);
+    bool run();
+    static void printHeader();
+private:
+    struct Table
+    {
+        std::string language;
+        std::string name;
+        Language *lan;
+        Contain *contain;//NULL for the keywords of the language itself
+        bool caseSensitive;
+        std::list<Keywords> keywords;
+        std::vector<std::string> lexemes;
+    };
+
+private:
+    static void cutLexemes(RegExp &lexemsRe, const std::string &code, std::vector<std::string> &lexemes);
+    static int listMatch(std::list<Keywords> &keywords, bool caseSensitive, const std::string &lexeme);
+    void time(Table &table);
+private:
+    int iterations;
+};
+
+#endif // KEYWORDBENCHMARK_H
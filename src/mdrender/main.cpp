@@ -0,0 +1,349 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStringList>
+
+#include "markdowntohtml.h"
+#include "markdownrenderer.h"
+#include "codesyntaxhighlighter.h"
+#include "html.h"
+#include "timingprofiler.h"
+#include "benchmark.h"
+#include "benchmarkcorpus.h"
+#include "stresstest.h"
+#include "keywordbenchmark.h"
+#include "scannerbenchmark.h"
+#include "scalingbenchmark.h"
+
+namespace {
+const char *ENGINE_NAMES[] = {"markdown", "extra", "multimarkdown"};
+const MarkdownToHtml::MarkdownType ENGINE_TYPES[] = {
+    MarkdownToHtml::Markdown,
+    MarkdownToHtml::PHPMarkdownExtra,
+    MarkdownToHtml::MultiMarkdown
+};
+const int ENGINE_COUNT = 3;
+
+void printUsage()
+{
+    fprintf(stderr,
+            "Usage: mdrender [options] [file]\n"
+            "       mdrender --benchmark [options] [file...]\n"
+            "       mdrender --stress <threads> [options] [file...]\n"
+            "       mdrender --keywords [--iterations <n>]\n"
+            "       mdrender --scanners [--iterations <n>] [file...]\n"
+            "       mdrender --scaling [-e <name>] [--iterations <n>]\n"
+            "       mdrender --write-corpus <dir>\n"
+            "\n"
+            "Renders file, or stdin, to html on stdout.\n"
+            "\n"
+            "  -e, --engine <name>   markdown, extra (default) or multimarkdown\n"
+            "  -o, --output <file>   write the html to file\n"
+            "  --no-highlight        do not highlight fenced code blocks\n"
+            "  --benchmark           render the files, or the built in corpus,\n"
+            "                        with each engine and print the timings\n"
+            "  --iterations <n>      renders per document, by default as many\n"
+            "                        as fit in about a second (two per thread\n"
+            "                        with --stress)\n"
+            "  --stress <threads>    render the files, or the built in corpus\n"
+            "                        but the spec, on that many threads at once\n"
+            "                        and compare with a serial render, with\n"
+            "                        multimarkdown unless an engine is given\n"
+            "  --keywords            time the keyword lookups of the cpp, sql and\n"
+            "                        php highlighters, the old list walk against\n"
+            "                        the hash table\n"
+            "  --scanners            time the byte scans of the parser on the\n"
+            "                        files, or the built in corpus, with each\n"
+            "                        scalar, SSE2 and AVX2 scanner the cpu runs\n"
+            "  --scaling             render 1000 to 10000 references and half as\n"
+            "                        many footnotes, with extra unless an engine\n"
+            "                        is given, to check the time grows linearly\n"
+            "  --write-corpus <dir>  save the built in corpus as .md files\n"
+            "  --trace <file>        save the timings of the render stages as a\n"
+            "                        Chrome trace, with one engine only\n");
+}
+
+int engineIndex(const QString &name)
+{
+    for(int i=0; i<ENGINE_COUNT; i++){
+        if(name==QLatin1String(ENGINE_NAMES[i]))
+            return i;
+    }
+    return -1;
+}
+
+//the same languages as the editor, bundled by mdrender.qrc
+void initHighlighter()
+{
+    LanguageManager *languageManager = LanguageManager::getInstance();
+    QDir dir(QString::fromLatin1(":/highlighter"));
+    QStringList files = dir.entryList(QStringList() << QString::fromLatin1("*.xml"), QDir::Files);
+    for(int i=0; i<files.size(); i++){
+        QFile file(dir.filePath(files.at(i)));
+        if(!file.open(QFile::ReadOnly))
+            continue;
+        languageManager->addLanguage(QFileInfo(files.at(i)).completeBaseName().toStdString(),
+                                     file.readAll().data());
+    }
+}
+
+bool readFile(const QString &path, QByteArray &data)
+{
+    QFile file(path);
+    bool opened;
+    if(path.isEmpty())
+        opened = file.open(stdin, QFile::ReadOnly);
+    else
+        opened = file.open(QFile::ReadOnly);
+    if(!opened){
+        fprintf(stderr, "mdrender: cannot open %s: %s\n",
+                path.isEmpty() ? "stdin" : path.toLocal8Bit().constData(),
+                file.errorString().toLocal8Bit().constData());
+        return false;
+    }
+    data = file.readAll();
+    return true;
+}
+
+int render(int engine, const QString &input, const QString &output)
+{
+    QByteArray data;
+    if(!readFile(input, data))
+        return 1;
+    MarkdownRenderer renderer(sdhtml_renderer);
+    //data ends with '\0' as MultiMarkdown wants
+    if(renderer.render(ENGINE_TYPES[engine], data.constData(), data.size())==MarkdownToHtml::ERROR){
+        fprintf(stderr, "mdrender: render failed\n");
+        return 1;
+    }
+    FILE *out = stdout;
+    if(!output.isEmpty()){
+        out = fopen(output.toLocal8Bit().constData(), "wb");
+        if(!out){
+            fprintf(stderr, "mdrender: cannot write %s\n", output.toLocal8Bit().constData());
+            return 1;
+        }
+    }
+    size_t written = fwrite(renderer.getHtml(), 1, renderer.getHtmlSize(), out);
+    if(out!=stdout)
+        fclose(out);
+    return written==renderer.getHtmlSize() ? 0 : 1;
+}
+
+int writeCorpus(const QString &dirPath)
+{
+    QDir dir(dirPath);
+    if(!dir.exists() && !dir.mkpath(QString::fromLatin1("."))){
+        fprintf(stderr, "mdrender: cannot create %s\n", dirPath.toLocal8Bit().constData());
+        return 1;
+    }
+    std::vector<BenchmarkCorpus::Document> documents = BenchmarkCorpus::documents();
+    for(size_t i=0; i<documents.size(); i++){
+        QFile file(dir.filePath(QString::fromStdString(documents[i].name)+QString::fromLatin1(".md")));
+        if(!file.open(QFile::WriteOnly)
+                || file.write(documents[i].text.data(), documents[i].text.size())!=(qint64)documents[i].text.size()){
+            fprintf(stderr, "mdrender: cannot write %s\n", file.fileName().toLocal8Bit().constData());
+            return 1;
+        }
+    }
+    return 0;
+}
+
+bool readDocuments(const QStringList &inputs, std::vector<BenchmarkCorpus::Document> &documents)
+{
+    for(int i=0; i<inputs.size(); i++){
+        QByteArray data;
+        if(!readFile(inputs.at(i), data))
+            return false;
+        BenchmarkCorpus::Document document;
+        document.name = QFileInfo(inputs.at(i)).completeBaseName().toStdString();
+        document.text.assign(data.constData(), data.size());
+        documents.push_back(document);
+    }
+    return true;
+}
+
+int benchmark(int engine, const QStringList &inputs, int iterations, bool header)
+{
+    std::vector<BenchmarkCorpus::Document> documents;
+    if(inputs.isEmpty())
+        documents = BenchmarkCorpus::documents();
+    else if(!readDocuments(inputs, documents))
+        return 1;
+    if(header)
+        Benchmark::printHeader();
+    Benchmark(ENGINE_TYPES[engine], ENGINE_NAMES[engine], iterations).run(documents);
+    return 0;
+}
+
+int stress(int engine, const QStringList &inputs, int threads, int rounds)
+{
+    std::vector<BenchmarkCorpus::Document> documents;
+    if(inputs.isEmpty()){
+        //the 10 MB spec takes MultiMarkdown longer than its 3 s parse limit
+        std::vector<BenchmarkCorpus::Document> corpus = BenchmarkCorpus::documents();
+        for(size_t i=0; i<corpus.size(); i++){
+            if(corpus[i].name!="spec")
+                documents.push_back(corpus[i]);
+        }
+    } else if(!readDocuments(inputs, documents)){
+        return 1;
+    }
+    StressTest test(ENGINE_TYPES[engine], ENGINE_NAMES[engine], threads, rounds>0 ? rounds : 2);
+    return test.run(documents) ? 0 : 1;
+}
+
+int scanners(const QStringList &inputs, int iterations)
+{
+    std::vector<BenchmarkCorpus::Document> documents;
+    if(inputs.isEmpty())
+        documents = BenchmarkCorpus::documents();
+    else if(!readDocuments(inputs, documents))
+        return 1;
+    ScannerBenchmark::printHeader();
+    return ScannerBenchmark(iterations).run(documents) ? 0 : 1;
+}
+
+//each engine runs in its own process, so that the peak RSS is its own
+int benchmarkAll(const QStringList &arguments)
+{
+    Benchmark::printHeader();
+    fflush(stdout);
+    for(int i=0; i<ENGINE_COUNT; i++){
+        QProcess process;
+        process.setProcessChannelMode(QProcess::ForwardedChannels);
+        process.start(QCoreApplication::applicationFilePath(),
+                      QStringList() << arguments << QString::fromLatin1("--engine")
+                      << QString::fromLatin1(ENGINE_NAMES[i])
+                      << QString::fromLatin1("--no-header"));
+        if(!process.waitForFinished(-1) || process.exitCode()!=0){
+            fprintf(stderr, "mdrender: the %s benchmark failed\n", ENGINE_NAMES[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList arguments = app.arguments();
+    arguments.removeFirst();
+
+    int engine = -1;
+    int iterations = 0;
+    bool highlight = true;
+    bool isBenchmark = false;
+    bool isKeywords = false;
+    bool isScanners = false;
+    bool isScaling = false;
+    bool header = true;
+    int stressThreads = 0;
+    QString output;
+    QString corpusDir;
+    QString traceFile;
+    QStringList inputs;
+    QStringList passOn;//for the benchmark of each engine
+    for(int i=0; i<arguments.size(); i++){
+        const QString &arg = arguments.at(i);
+        bool hasValue = i+1<arguments.size();
+        if((arg==QLatin1String("-e") || arg==QLatin1String("--engine")) && hasValue){
+            engine = engineIndex(arguments.at(++i));
+            if(engine<0){
+                fprintf(stderr, "mdrender: unknown engine %s\n", arguments.at(i).toLocal8Bit().constData());
+                return 2;
+            }
+        } else if((arg==QLatin1String("-o") || arg==QLatin1String("--output")) && hasValue){
+            output = arguments.at(++i);
+        } else if(arg==QLatin1String("--iterations") && hasValue){
+            iterations = arguments.at(++i).toInt();
+            passOn << arg << arguments.at(i);
+        } else if(arg==QLatin1String("--stress") && hasValue){
+            stressThreads = arguments.at(++i).toInt();
+            if(stressThreads<1){
+                fprintf(stderr, "mdrender: --stress needs at least one thread\n");
+                return 2;
+            }
+        } else if(arg==QLatin1String("--write-corpus") && hasValue){
+            corpusDir = arguments.at(++i);
+        } else if(arg==QLatin1String("--trace") && hasValue){
+            traceFile = arguments.at(++i);
+        } else if(arg==QLatin1String("--no-highlight")){
+            highlight = false;
+            passOn << arg;
+        } else if(arg==QLatin1String("--benchmark")){
+            isBenchmark = true;
+            passOn << arg;
+        } else if(arg==QLatin1String("--keywords")){
+            isKeywords = true;
+        } else if(arg==QLatin1String("--scanners")){
+            isScanners = true;
+        } else if(arg==QLatin1String("--scaling")){
+            isScaling = true;
+        } else if(arg==QLatin1String("--no-header")){
+            header = false;
+        } else if(arg==QLatin1String("-h") || arg==QLatin1String("--help")){
+            printUsage();
+            return 0;
+        } else if(arg.startsWith(QLatin1Char('-')) && arg!=QLatin1String("-")){
+            printUsage();
+            return 2;
+        } else {
+            if(arg!=QLatin1String("-"))
+                inputs << arg;
+            passOn << arg;
+        }
+    }
+
+    if(!corpusDir.isEmpty())
+        return writeCorpus(corpusDir);
+    if(isKeywords){
+        initHighlighter();
+        KeywordBenchmark::printHeader();
+        return KeywordBenchmark(iterations).run() ? 0 : 1;
+    }
+    if(isScanners)
+        return scanners(inputs, iterations);
+    if(isScaling){
+        if(engine<0)
+            engine = 1;
+        ScalingBenchmark::printHeader();
+        ScalingBenchmark(ENGINE_TYPES[engine], ENGINE_NAMES[engine], iterations).run();
+        return 0;
+    }
+    if(isBenchmark && engine<0)
+        return benchmarkAll(passOn);
+    if(highlight)
+        initHighlighter();
+    if(stressThreads>0)
+        return stress(engine<0 ? 2 : engine, inputs, stressThreads, iterations);
+    if(engine<0)
+        engine = 1;
+    if(!traceFile.isEmpty())
+        TimingProfiler::instance()->setEnabled(true);
+    int ret;
+    if(isBenchmark){
+        ret = benchmark(engine, inputs, iterations, header);
+    } else if(inputs.size()>1){
+        printUsage();
+        return 2;
+    } else {
+        ret = render(engine, inputs.isEmpty() ? QString() : inputs.first(), output);
+    }
+    if(!traceFile.isEmpty() && !TimingProfiler::instance()->writeChromeTrace(QFile::encodeName(traceFile).constData())){
+        fprintf(stderr, "mdrender: cannot write %s\n", traceFile.toLocal8Bit().constData());
+        return 1;
+    }
+    return ret;
+}
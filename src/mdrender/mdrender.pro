@@ -0,0 +1,58 @@
+TEMPLATE = app
+
+TARGET = mdrender
+
+QT += core
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+
+CONFIG(debug, debug|release){ #debug
+    DESTDIR = ../debug/
+    LIBS += -L../debug -lcore
+} else { #release
+    DEFINES += NDEBUG
+    DESTDIR = ../release/
+    LIBS += -L../release -lcore
+}
+
+win32-msvc*: {
+    CONFIG(debug, debug|release){
+        LIBS += -L../debug -lmdcharm_pcre
+    } else {
+        LIBS += -L../release -lmdcharm_pcre
+    }
+    LIBS += -lpsapi
+}
+
+unix: {
+    CONFIG(debug, debug|release){
+        LIBS += -L../debug -lmdcharm_pcre
+    } else {
+        LIBS += -L../release -lmdcharm_pcre
+    }
+}
+
+INCLUDEPATH += ../lib/core ../lib/markdown/html \
+                ../lib/markdown/src ../lib/pcre \
+                ../lib/rapidxml
+
+SOURCES += \
+    main.cpp \
+    benchmark.cpp \
+    benchmarkcorpus.cpp \
+    keywordbenchmark.cpp \
+    scalingbenchmark.cpp \
+    scannerbenchmark.cpp \
+    stresstest.cpp
+
+HEADERS += \
+    benchmark.h \
+    benchmarkcorpus.h \
+    keywordbenchmark.h \
+    scalingbenchmark.h \
+    scannerbenchmark.h \
+    stresstest.h
+
+RESOURCES += \
+    mdrender.qrc
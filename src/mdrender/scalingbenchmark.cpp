@@ -0,0 +1,76 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#include <stdio.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <QElapsedTimer>
+
+#include "scalingbenchmark.h"
+#include "benchmarkcorpus.h"
+#include "markdownrenderer.h"
+#include "rendercache.h"
+#include "html.h"
+
+using namespace std;
+
+namespace {
+const size_t REFERENCE_COUNTS[] = {1000, 2000, 5000, 10000};
+const int SIZE_COUNT = 4;
+const int MIN_ITERATIONS = 3;
+const int MAX_ITERATIONS = 500;
+const qint64 TIME_BUDGET_NS = 1000*1000*1000;
+}
+
+ScalingBenchmark::ScalingBenchmark(MarkdownToHtml::MarkdownType type, const char *engineName, int iterations)
+{
+    this->type = type;
+    this->engineName = engineName;
+    this->iterations = iterations;
+}
+
+void ScalingBenchmark::printHeader()
+{
+    printf("%-14s %8s %10s %10s %10s %10s %10s\n",
+           "engine", "refs", "footnotes", "size KB", "p50 ms", "us/def", "vs linear");
+}
+
+void ScalingBenchmark::run()
+{
+    //repeated renders of the same text would only measure the cache
+    RenderCache::instance()->setBudget(0);
+    MarkdownRenderer renderer(sdhtml_renderer);
+    double firstPerDefinition = 0;
+    for(int i=0; i<SIZE_COUNT; i++){
+        size_t refs = REFERENCE_COUNTS[i];
+        size_t footnotes = refs/2;
+        string text = BenchmarkCorpus::references(refs, footnotes);
+        //the first render allocates the buffers, it is not timed
+        renderer.render(type, text.c_str(), text.size());
+        vector<qint64> times;
+        qint64 total = 0;
+        QElapsedTimer timer;
+        while(iterations>0 ? (int)times.size()<iterations
+              : (int)times.size()<MIN_ITERATIONS
+                || (total<TIME_BUDGET_NS && (int)times.size()<MAX_ITERATIONS)){
+            timer.start();
+            renderer.render(type, text.c_str(), text.size());
+            qint64 elapsed = timer.nsecsElapsed();
+            times.push_back(elapsed);
+            total += elapsed;
+        }
+        sort(times.begin(), times.end());
+        double median = times[times.size()/2]/1000000.0;
+        double perDefinition = median*1000.0/(refs+footnotes);
+        if(i==0)
+            firstPerDefinition = perDefinition;
+        printf("%-14s %8lu %10lu %10.1f %10.3f %10.3f %10.2f\n",
+               engineName, (unsigned long)refs, (unsigned long)footnotes,
+               text.size()/1024.0, median, perDefinition,
+               firstPerDefinition>0 ? perDefinition/firstPerDefinition : 0.0);
+        fflush(stdout);
+    }
+}
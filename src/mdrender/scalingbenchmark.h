@@ -0,0 +1,31 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#ifndef SCALINGBENCHMARK_H
+#define SCALINGBENCHMARK_H
+
+#include "markdowntohtml.h"
+
+/**
+ * @brief Renders BenchmarkCorpus::references with 1000, 2000, 5000 and 10000
+ *        references, and half as many footnotes, to show how the render time
+ *        grows with the definitions. Each size is rendered iterations times
+ *        (or for about a second when iterations is 0) and the row has the
+ *        median time, the time per definition and the growth since the
+ *        first size divided by the growth of the definitions: about 1 when
+ *        the engine is linear. The render cache is turned off while it runs.
+ */
+class ScalingBenchmark
+{
+public:
+    ScalingBenchmark(MarkdownToHtml::MarkdownType type, const char *engineName, int iterations);
+    void run();
+    static void printHeader();
+private:
+    MarkdownToHtml::MarkdownType type;
+    const char *engineName;
+    int iterations;
+};
+
+#endif // SCALINGBENCHMARK_H
@@ -0,0 +1,96 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#include <stdio.h>
+
+#include <QElapsedTimer>
+
+#include "scannerbenchmark.h"
+#include "markdowntohtml.h"
+#include "markdown.h"
+#include "html.h"
+
+using namespace std;
+
+namespace {
+const char *SCAN_NAMES[] = {"active chars", "line ends", "tabs"};
+const sd_scan SCANS[] = {SD_SCAN_ACTIVE_CHAR, SD_SCAN_LINE_END, SD_SCAN_TAB};
+const int SCAN_COUNT = 3;
+const char *SCANNER_NAMES[] = {"scalar", "sse2", "avx2"};
+const sd_scanner SCANNERS[] = {SD_SCANNER_SCALAR, SD_SCANNER_SSE2, SD_SCANNER_AVX2};
+const int SCANNER_COUNT = 3;
+const int MIN_ROUNDS = 3;
+//a cell per document, scan and scanner
+const qint64 TIME_BUDGET_NS = 250*1000*1000;
+}
+
+ScannerBenchmark::ScannerBenchmark(int iterations)
+{
+    this->iterations = iterations;
+}
+
+void ScannerBenchmark::printHeader()
+{
+    printf("%-12s %-13s %10s", "document", "scan", "hits");
+    for(int i=0; i<SCANNER_COUNT; i++)
+        printf(" %10s", (string(SCANNER_NAMES[i])+" MB/s").c_str());
+    printf("\n");
+}
+
+bool ScannerBenchmark::run(const vector<BenchmarkCorpus::Document> &documents)
+{
+    sd_callbacks callbacks;
+    html_renderopt options;
+    sdhtml_renderer(&callbacks, &options, 0);
+    sd_markdown *markdown = sd_markdown_new(MarkdownToHtml::extensionFlags(MarkdownToHtml::PHPMarkdownExtra),
+                                            16, &callbacks, &options);
+    bool same = true;
+    for(size_t d=0; d<documents.size(); d++){
+        const BenchmarkCorpus::Document &document = documents[d];
+        for(int s=0; s<SCAN_COUNT; s++){
+            double mbs[SCANNER_COUNT];
+            size_t hits[SCANNER_COUNT];
+            for(int i=0; i<SCANNER_COUNT; i++){
+                hits[i] = 0;
+                mbs[i] = sd_markdown_set_scanner(markdown, SCANNERS[i])
+                        ? time(markdown, s, document.text, hits[i]) : -1;
+                if(mbs[i]>=0 && hits[i]!=hits[0]){
+                    fprintf(stderr, "mdrender: %s %s: the %s scanner finds %lu bytes, the scalar one %lu\n",
+                            document.name.c_str(), SCAN_NAMES[s], SCANNER_NAMES[i],
+                            (unsigned long)hits[i], (unsigned long)hits[0]);
+                    same = false;
+                }
+            }
+            printf("%-12s %-13s %10lu", document.name.c_str(), SCAN_NAMES[s], (unsigned long)hits[0]);
+            for(int i=0; i<SCANNER_COUNT; i++){
+                if(mbs[i]<0)
+                    printf(" %10s", "-");
+                else
+                    printf(" %10.0f", mbs[i]);
+            }
+            printf("\n");
+            fflush(stdout);
+        }
+    }
+    sd_markdown_free(markdown);
+    printf("sd_markdown_new picks %s\n", SCANNER_NAMES[sd_scanner_best()]);
+    return same;
+}
+
+//MB/s of one scan with the scanner of markdown
+double ScannerBenchmark::time(sd_markdown *markdown, int scan, const string &text, size_t &hits)
+{
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(text.data());
+    qint64 ns = 0;
+    int rounds = 0;
+    QElapsedTimer timer;
+    while(iterations>0 ? rounds<iterations
+          : rounds<MIN_ROUNDS || ns<TIME_BUDGET_NS){
+        timer.start();
+        hits = sd_markdown_scan(markdown, SCANS[scan], data, text.size());
+        ns += timer.nsecsElapsed();
+        rounds++;
+    }
+    return ns>0 ? (double)text.size()*rounds/ns*1000.0 : 0.0;
+}
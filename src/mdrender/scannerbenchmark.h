@@ -0,0 +1,36 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#ifndef SCANNERBENCHMARK_H
+#define SCANNERBENCHMARK_H
+
+#include <vector>
+
+#include "benchmarkcorpus.h"
+
+struct sd_markdown;
+
+/**
+ * @brief Times the byte scans of sundown, the active chars of the inline
+ *        parser, the line ends of sd_markdown_prepare and the tabs of
+ *        expand_tabs, with each scanner the build and the cpu support forced
+ *        on the same document. The tabs are memchr for every scanner, the
+ *        row is there to compare it with the others. Every cell is timed
+ *        iterations times (or for about a quarter of a second when
+ *        iterations is 0) with the extensions of the Extra engine, and the
+ *        scanners have to find the same number of bytes.
+ */
+class ScannerBenchmark
+{
+public:
+    ScannerBenchmark(int iterations);
+    bool run(const std::vector<BenchmarkCorpus::Document> &documents);
+    static void printHeader();
+private:
+    double time(sd_markdown *markdown, int scan, const std::string &text, size_t &hits);
+private:
+    int iterations;
+};
+
+#endif // SCANNERBENCHMARK_H
@@ -0,0 +1,93 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#include <stdio.h>
+#include <string>
+
+#include <QThread>
+#include <QElapsedTimer>
+
+#include "stresstest.h"
+#include "rendercache.h"
+
+using namespace std;
+
+namespace {
+class StressThread : public QThread
+{
+public:
+    StressThread(MarkdownToHtml::MarkdownType type, int index, int rounds,
+                 const vector<BenchmarkCorpus::Document> &documents,
+                 const vector<string> &expected)
+        : type(type), index(index), rounds(rounds),
+          documents(documents), expected(expected), renders(0), mismatches(0) {}
+    int getRenders() const { return renders; }
+    int getMismatches() const { return mismatches; }
+protected:
+    void run()
+    {
+        for(int round=0; round<rounds; round++){
+            //each thread starts at another document, so different documents overlap
+            for(size_t i=0; i<documents.size(); i++){
+                size_t d = (i+index+round)%documents.size();
+                string html;
+                MarkdownToHtml::translateMarkdownToHtml(type, documents[d].text.c_str(),
+                                                        documents[d].text.size(), html);
+                renders++;
+                if(html!=expected[d]){
+                    mismatches++;
+                    fprintf(stderr, "mdrender: thread %d rendered %s differently\n",
+                            index, documents[d].name.c_str());
+                }
+            }
+        }
+    }
+private:
+    MarkdownToHtml::MarkdownType type;
+    int index;
+    int rounds;
+    const vector<BenchmarkCorpus::Document> &documents;
+    const vector<string> &expected;
+    int renders;
+    int mismatches;
+};
+}
+
+StressTest::StressTest(MarkdownToHtml::MarkdownType type, const char *engineName, int threads, int rounds)
+{
+    this->type = type;
+    this->engineName = engineName;
+    this->threads = threads;
+    this->rounds = rounds;
+}
+
+bool StressTest::run(const vector<BenchmarkCorpus::Document> &documents)
+{
+    //every render has to run the engine, not come out of the cache
+    RenderCache::instance()->setBudget(0);
+    vector<string> expected(documents.size());
+    for(size_t i=0; i<documents.size(); i++){
+        MarkdownToHtml::translateMarkdownToHtml(type, documents[i].text.c_str(),
+                                                documents[i].text.size(), expected[i]);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    vector<StressThread *> workers;
+    for(int i=0; i<threads; i++){
+        workers.push_back(new StressThread(type, i, rounds, documents, expected));
+        workers.back()->start();
+    }
+    int renders = 0;
+    int mismatches = 0;
+    for(size_t i=0; i<workers.size(); i++){
+        workers[i]->wait();
+        renders += workers[i]->getRenders();
+        mismatches += workers[i]->getMismatches();
+        delete workers[i];
+    }
+    printf("%s: %d threads, %d renders in %.1f s, %d differ from the serial render\n",
+           engineName, threads, renders, timer.elapsed()/1000.0, mismatches);
+    return mismatches==0;
+}
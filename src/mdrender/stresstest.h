@@ -0,0 +1,31 @@
+// Copyright (c) 2014 zhangshine. All rights reserved.
+// Use of this source code is governed by a BSD license that can be
+// found in the LICENSE file.
+
+#ifndef STRESSTEST_H
+#define STRESSTEST_H
+
+#include <vector>
+
+#include "markdowntohtml.h"
+#include "benchmarkcorpus.h"
+
+/**
+ * @brief Renders every document once on the calling thread, then renders them
+ *        all again on threads threads at the same time, rounds times each,
+ *        and compares every result with the serial one. It is meant to catch
+ *        shared state in an engine, MultiMarkdown's above all.
+ */
+class StressTest
+{
+public:
+    StressTest(MarkdownToHtml::MarkdownType type, const char *engineName, int threads, int rounds);
+    bool run(const std::vector<BenchmarkCorpus::Document> &documents);
+private:
+    MarkdownToHtml::MarkdownType type;
+    const char *engineName;
+    int threads;
+    int rounds;
+};
+
+#endif // STRESSTEST_H